@@ -0,0 +1,154 @@
+#include "AotEngine.hpp"
+
+/**
+	Retrieve the registry shared by the whole process.
+ */
+AotRegistry& AotRegistry::GetInstance()
+{
+	static AotRegistry s_instance;
+	return s_instance;
+};
+
+/**
+	Adds a program, called by generated code.
+
+	@param[in] pProgram The program, must live as long as the process.
+	@return true, so generated code can register from a static initializer.
+ */
+bool AotRegistry::Add(const AotProgram* pProgram)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_programs.push_back(pProgram);
+	return true;
+};
+
+/**
+	Retrieve the program translated for a ROM.
+
+	@param[in] romHash Content hash of the ROM.
+	@param[in] platform Platform the ROM runs on.
+	@param[in] quirks Quirk profile the ROM runs with.
+	@return The program or null if none was translated with that platform and profile.
+ */
+const AotProgram* AotRegistry::Find(uint64_t romHash, Platform platform, QuirkProfile quirks) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const AotProgram* pProgram : m_programs)
+	{
+		if (pProgram->romHash == romHash && pProgram->platform == platform && pProgram->quirks == quirks)
+		{
+			return pProgram;
+		};
+	};
+
+	return nullptr;
+};
+
+/**
+	Retrieve the number of programs compiled in.
+ */
+size_t AotRegistry::GetProgramCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_programs.size();
+};
+
+/**
+	Default Constructor
+
+	@param[in] interpreter Interpreter whose state the blocks operate on.
+ */
+AotEngine::AotEngine(Interpreter& interpreter) : m_interpreter(interpreter), m_pProgram(nullptr), m_isValid(false)
+{
+};
+
+/**
+	Switches to another program and checks it against memory.
+
+	@param[in] pProgram Program for the loaded ROM, null to interpret everything.
+ */
+void AotEngine::Bind(const AotProgram* pProgram)
+{
+	m_pProgram = pProgram;
+	m_code.reset();
+	m_isValid = pProgram != nullptr;
+	if (!m_isValid)
+	{
+		return;
+	};
+
+	for (size_t i = 0; i < pProgram->codeRegionCount; i++)
+	{
+		const MemoryRegion& region = pProgram->pCode[i];
+		for (uint32_t address = region.first; address <= region.last; address++)
+		{
+			m_code.set(address);
+			m_isValid &= address >= 0x0200 && address - 0x0200 < pProgram->imageSize &&
+				m_interpreter.m_memory[address] == pProgram->pImage[address - 0x0200];
+		};
+	};
+};
+
+/**
+	Retrieve the bound program, null if none.
+ */
+const AotProgram* AotEngine::GetProgram() const
+{
+	return m_pProgram;
+};
+
+/**
+	Runs translated blocks for a number of guest instructions.\n
+	The result is identical to calling Interpreter::Run() cycles times.
+
+	@param[in] cycles Number of instructions to execute.
+	@return Number of instructions executed.
+ */
+uint32_t AotEngine::Execute(uint32_t cycles)
+{
+	uint32_t executed = 0;
+	while (executed < cycles)
+	{
+		if (!m_isValid)
+		{
+			return executed + m_interpreter.ExecuteInterpreted(cycles - executed);
+		};
+
+		uint16_t address = m_interpreter.m_programCounter & g_chipAddressMask;
+		AotBlockFunction function = m_pProgram->dispatch(address);
+		if (function == nullptr)
+		{
+			m_interpreter.Run();
+			executed++;
+			continue;
+		};
+
+		m_interpreter.m_programCounter = address;
+		uint32_t length = function(*this, address, cycles - executed);
+		m_interpreter.m_cycleCount += length;
+		executed += length;
+	};
+
+	return executed;
+};
+
+/**
+	Drops back to the interpreter if a write hits translated code.
+
+	@param[in] address Guest address that was written to.
+ */
+void AotEngine::Invalidate(uint16_t address)
+{
+	m_isValid &= !m_code.test(address & g_chipAddressMask);
+};
+
+/**
+	Called from generated code to execute a single instruction with the interpreter.
+
+	@param[in] address Guest address of the instruction.
+ */
+void AotEngine::ExecuteInstruction(uint16_t address)
+{
+	m_interpreter.m_programCounter = address;
+	m_interpreter.Dispatch();
+};
@@ -0,0 +1,130 @@
+#ifndef AOTENGINE_HPP_INCLUDED
+#define AOTENGINE_HPP_INCLUDED
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "Interpreter.hpp"
+#include "Quirks.hpp"
+#include "RomAnalyzer.hpp"
+
+class AotEngine;
+
+/**
+	Translated basic block.\n
+	Starts at any instruction of the block and runs until the block ends or
+	budget instructions ran, leaving the program counter at the next
+	instruction.
+
+	@param[in] engine Engine owning the state to operate on.
+	@param[in] address Address of the first instruction to run.
+	@param[in] budget Maximum number of instructions to run.
+	@return Number of instructions run.
+ */
+typedef uint32_t (*AotBlockFunction)(AotEngine& engine, uint16_t address, uint32_t budget);
+
+/**
+	Finds the block containing an instruction, null if none does.\n
+	Used for every block entry, which includes the computed jumps of Bnnn.
+ */
+typedef AotBlockFunction (*AotDispatcher)(uint16_t address);
+
+/**
+	ROM translated to C++ by chip8-aot and compiled in to the executable.
+ */
+struct AotProgram
+{
+	/** Name given to chip8_add_aot_rom() */
+	const char* pName;
+	/** Content hash of the ROM, see RomCache::Hash() */
+	uint64_t romHash;
+	/** Instruction set the ROM was translated for */
+	Platform platform;
+	/** Quirk profile the ROM was translated for */
+	QuirkProfile quirks;
+	/** ROM bytes from 0x200 up to the last translated byte */
+	const uint8_t* pImage;
+	/** Number of bytes in pImage */
+	size_t imageSize;
+	/** Memory the translated blocks were decoded from */
+	const MemoryRegion* pCode;
+	/** Number of regions in pCode */
+	size_t codeRegionCount;
+	/** Block lookup by instruction address */
+	AotDispatcher dispatch;
+};
+
+/**
+	Process wide list of the programs compiled in to the executable.\n
+	Generated code adds its program while static objects are constructed.
+	Safe to use from several threads.
+ */
+class AotRegistry
+{
+	public:
+
+		static AotRegistry& GetInstance();
+
+		bool Add(const AotProgram* pProgram);
+		const AotProgram* Find(uint64_t romHash, Platform platform, QuirkProfile quirks) const;
+		size_t GetProgramCount() const;
+
+	private:
+
+		AotRegistry() = default;
+
+	private:
+
+		/** Guards m_programs */
+		mutable std::mutex m_mutex;
+		/** Registered programs */
+		std::vector<const AotProgram*> m_programs;
+
+}; // AotRegistry
+
+/**
+	Runs a ROM through the blocks chip8-aot translated ahead of time.\n
+	The program is only used while the memory it was translated from is
+	unchanged. A write to translated code drops back to the interpreter
+	until the next ROM or save state brings the original code back.
+	Addresses without a translated block run on the interpreter.
+ */
+class AotEngine
+{
+	public:
+
+		explicit AotEngine(Interpreter& interpreter);
+
+		void Bind(const AotProgram* pProgram);
+		const AotProgram* GetProgram() const;
+		bool IsValid() const { return m_isValid; };
+
+		uint32_t Execute(uint32_t cycles);
+		void Invalidate(uint16_t address);
+
+		/** V0 to VF, for the generated code */
+		uint8_t* GetRegisters() { return m_interpreter.m_registerV.data(); };
+		/** Index register, for the generated code */
+		uint16_t& GetIndexRegister() { return m_interpreter.m_I; };
+		/** Sets where execution continues once a block returns */
+		void SetProgramCounter(uint16_t address) { m_interpreter.m_programCounter = address; };
+
+		void ExecuteInstruction(uint16_t address);
+
+	private:
+
+		/** Interpreter owning the state the blocks operate on */
+		Interpreter& m_interpreter;
+		/** Program for the loaded ROM, null if none was compiled in */
+		const AotProgram* m_pProgram;
+		/** Guest bytes the program was translated from */
+		std::bitset<g_chipRamSize> m_code;
+		/** The translated code still matches memory */
+		bool m_isValid;
+
+}; // AotEngine
+
+#endif // AOTENGINE_HPP_INCLUDED
@@ -0,0 +1,366 @@
+#include <algorithm>
+#include <cmath>
+#include "Audio.hpp"
+#include "Scheduler.hpp"
+#include "StateBuffer.hpp"
+
+namespace
+{
+	/** Peak amplitude of the square wave */
+	constexpr float g_audioAmplitude = 0.25f;
+	/** Length of the fade in and out, in seconds */
+	constexpr double g_audioRampTime = 0.002;
+	/** Buffers the guest may run ahead of the audio clock before it is re-mapped */
+	constexpr uint32_t g_audioMaxLeadBuffers = 8;
+	/** Size of a WAV header */
+	constexpr size_t g_wavHeaderSize = 44;
+}
+
+/**
+	Default Constructor
+
+	@param[in] sampleRate Output sample rate.
+	@param[in] bufferFrames Samples per device buffer.
+ */
+AudioEngine::AudioEngine(uint32_t sampleRate, uint32_t bufferFrames) :
+	m_sampleRate(std::max(sampleRate, 1u)),
+	m_bufferFrames(std::max(bufferFrames, 1u)),
+	m_instructionsPerSecond(g_defaultInstructionsPerSecond),
+	m_droppedEvents(0),
+	m_clock(0),
+	m_offset(0),
+	m_isSynchronized(false),
+	m_isOn(false),
+	m_phase(0.0),
+	m_phaseStep(0.0),
+	m_gain(0.0f),
+	m_hasPattern(false),
+	m_patternPosition(0.0),
+	m_patternStep(0.0)
+{
+	m_pattern.fill(0x00);
+	SetToneFrequency(g_audioDefaultToneFrequency);
+};
+
+/**
+	Sets the guest speed used to convert cycle counts to time, emulation thread only.
+ */
+void AudioEngine::SetInstructionsPerSecond(uint32_t instructionsPerSecond)
+{
+	m_instructionsPerSecond = std::max(instructionsPerSecond, 1u);
+};
+
+/**
+	Sets the pitch of the beeper, call before audio starts.
+ */
+void AudioEngine::SetToneFrequency(double frequency)
+{
+	m_phaseStep = std::min(std::max(frequency, 1.0), m_sampleRate / 2.0) / m_sampleRate;
+};
+
+/**
+	Queues a beeper change, emulation thread only. Never blocks.
+
+	@param[in] cycle Cycle count of the interpreter at the change.
+	@param[in] isActive true when the beeper turns on.
+ */
+void AudioEngine::OnSoundChanged(uint64_t cycle, bool isActive)
+{
+	BeeperEvent event = {};
+	event.sampleTime = cycle * m_sampleRate / m_instructionsPerSecond;
+	event.isPattern = false;
+	event.isOn = isActive;
+	Queue(event);
+};
+
+/**
+	Queues an XO-CHIP pattern change, emulation thread only. Never blocks.
+
+	@param[in] cycle Cycle count of the interpreter at the change.
+	@param[in] pattern 128 one bit samples.
+	@param[in] pitch Pitch register.
+ */
+void AudioEngine::OnPatternChanged(uint64_t cycle, const std::array<uint8_t, g_xoAudioPatternSize>& pattern, uint8_t pitch)
+{
+	BeeperEvent event = {};
+	event.sampleTime = cycle * m_sampleRate / m_instructionsPerSecond;
+	event.isPattern = true;
+	event.pitch = pitch;
+	event.pattern = pattern;
+	Queue(event);
+};
+
+/**
+	Pushes an event for the audio thread, counting it as dropped if the ring is full.
+ */
+void AudioEngine::Queue(const BeeperEvent& event)
+{
+	if (!m_events.TryPush(event))
+	{
+		m_droppedEvents.fetch_add(1, std::memory_order_relaxed);
+	};
+};
+
+/**
+	Applies a due event, audio thread only.
+ */
+void AudioEngine::Apply(const BeeperEvent& event)
+{
+	if (!event.isPattern)
+	{
+		m_isOn = event.isOn;
+		return;
+	};
+
+	// 4000 samples per second at pitch 64, doubling every 48 steps.
+	m_hasPattern = true;
+	m_pattern = event.pattern;
+	m_patternStep = 4000.0 * std::pow(2.0, (event.pitch - 64.0) / 48.0) / m_sampleRate;
+};
+
+/**
+	Synthesizes samples, audio thread only.\n
+	The square wave is band limited with PolyBLEP, so it does not alias at
+	any pitch, and fades in and out over 2 ms.
+
+	@param[out] pSamples Mono float samples.
+	@param[in] count Number of samples.
+ */
+void AudioEngine::Render(float* pSamples, uint32_t count)
+{
+	const float gainStep = static_cast<float>(1.0 / (g_audioRampTime * m_sampleRate));
+	const int64_t latency = m_bufferFrames;
+	const int64_t maxLead = static_cast<int64_t>(m_bufferFrames) * g_audioMaxLeadBuffers;
+
+	for (uint32_t i = 0; i < count; i++, m_clock++)
+	{
+		const int64_t clock = static_cast<int64_t>(m_clock);
+		while (const BeeperEvent* pEvent = m_events.Peek())
+		{
+			int64_t eventTime = static_cast<int64_t>(pEvent->sampleTime);
+			if (!m_isSynchronized)
+			{
+				m_offset = clock + latency - eventTime;
+				m_isSynchronized = true;
+			};
+
+			// Re-map when the guest got too far ahead or fell behind, the change then plays after the usual latency.
+			int64_t due = eventTime + m_offset;
+			if (due > clock + maxLead || due < clock - maxLead)
+			{
+				m_offset = clock + latency - eventTime;
+				due = clock + latency;
+			};
+
+			if (due > clock)
+			{
+				break;
+			};
+
+			Apply(*pEvent);
+			BeeperEvent consumed;
+			m_events.TryPop(consumed);
+		};
+
+		float target = m_isOn ? 1.0f : 0.0f;
+		m_gain = m_gain < target ? std::min(m_gain + gainStep, target) : std::max(m_gain - gainStep, target);
+
+		if (m_gain == 0.0f)
+		{
+			pSamples[i] = 0.0f;
+			continue;
+		};
+
+		pSamples[i] = (m_hasPattern ? RenderPattern() : RenderSquare()) * m_gain * g_audioAmplitude;
+	};
+};
+
+/**
+	Retrieve the next sample of the band limited square wave, -1 to 1.
+ */
+float AudioEngine::RenderSquare()
+{
+	double phase = m_phase;
+	double value = phase < 0.5 ? 1.0 : -1.0;
+	value += PolyBlep(phase, m_phaseStep);
+	value -= PolyBlep(std::fmod(phase + 0.5, 1.0), m_phaseStep);
+
+	m_phase += m_phaseStep;
+	if (m_phase >= 1.0)
+	{
+		m_phase -= 1.0;
+	};
+	return static_cast<float>(value);
+};
+
+/**
+	Retrieve the next sample of the XO-CHIP pattern, -1 or 1.
+ */
+float AudioEngine::RenderPattern()
+{
+	constexpr double patternBits = g_xoAudioPatternSize * 8;
+	uint32_t bit = static_cast<uint32_t>(m_patternPosition);
+	bool isSet = (m_pattern[bit >> 3] & (0x80 >> (bit & 7))) != 0;
+
+	m_patternPosition += m_patternStep;
+	if (m_patternPosition >= patternBits)
+	{
+		m_patternPosition = std::fmod(m_patternPosition, patternBits);
+	};
+	return isSet ? 1.0f : -1.0f;
+};
+
+/**
+	Retrieve the output sample rate.
+ */
+uint32_t AudioEngine::GetSampleRate() const
+{
+	return m_sampleRate;
+};
+
+/**
+	Retrieve the samples per device buffer.
+ */
+uint32_t AudioEngine::GetBufferFrames() const
+{
+	return m_bufferFrames;
+};
+
+/**
+	Retrieve the number of beeper changes dropped because the audio thread fell behind.
+ */
+uint64_t AudioEngine::GetDroppedEvents() const
+{
+	return m_droppedEvents.load(std::memory_order_relaxed);
+};
+
+/**
+	Polynomial band limited step, smooths a discontinuity at phase 0 over one sample either side.
+
+	@param[in] phase Position in the period, 0 to 1.
+	@param[in] phaseStep Phase advance per sample.
+	@return Correction to add to the naive waveform.
+ */
+double AudioEngine::PolyBlep(double phase, double phaseStep)
+{
+	if (phase < phaseStep)
+	{
+		double t = phase / phaseStep;
+		return t + t - t * t - 1.0;
+	};
+
+	if (phase > 1.0 - phaseStep)
+	{
+		double t = (phase - 1.0) / phaseStep;
+		return t * t + t + t + 1.0;
+	};
+
+	return 0.0;
+};
+
+/**
+	Default Constructor
+ */
+WavWriter::WavWriter() : m_pFile(nullptr), m_sampleCount(0), m_isValid(true)
+{
+};
+
+/**
+	Default Destructor, finishes the file if it is still open.
+ */
+WavWriter::~WavWriter()
+{
+	Close();
+};
+
+/**
+	Creates the file, the header is completed by Close().
+
+	@param[in] filePath Path of the file to write.
+	@param[in] sampleRate Sample rate of the samples to be written.
+	@return false if the file could not be created.
+ */
+bool WavWriter::Open(const char* filePath, uint32_t sampleRate)
+{
+	Close();
+
+	m_pFile = std::fopen(filePath, "wb");
+	if (m_pFile == nullptr)
+	{
+		m_isValid = false;
+		return false;
+	};
+
+	uint8_t header[g_wavHeaderSize];
+	StateWriter writer(header, sizeof(header));
+	writer.WriteBytes("RIFF", 4);
+	writer.WriteU32(0);
+	writer.WriteBytes("WAVEfmt ", 8);
+	writer.WriteU32(16);
+	writer.WriteU16(1);					// PCM
+	writer.WriteU16(1);					// Mono
+	writer.WriteU32(sampleRate);
+	writer.WriteU32(sampleRate * sizeof(int16_t));
+	writer.WriteU16(sizeof(int16_t));
+	writer.WriteU16(16);
+	writer.WriteBytes("data", 4);
+	writer.WriteU32(0);
+
+	m_sampleCount = 0;
+	m_isValid = std::fwrite(header, 1, sizeof(header), m_pFile) == sizeof(header);
+	return m_isValid;
+};
+
+/**
+	Appends samples, clipped to -1 to 1.
+ */
+void WavWriter::Write(const float* pSamples, uint32_t count)
+{
+	if (m_pFile == nullptr)
+	{
+		return;
+	};
+
+	int16_t buffer[1024];
+	for (uint32_t offset = 0; offset < count; offset += 1024)
+	{
+		uint32_t chunk = std::min(count - offset, 1024u);
+		for (uint32_t i = 0; i < chunk; i++)
+		{
+			float sample = std::min(std::max(pSamples[offset + i], -1.0f), 1.0f);
+			int16_t value = static_cast<int16_t>(std::lround(sample * 32767.0f));
+			uint8_t* pBytes = reinterpret_cast<uint8_t*>(&buffer[i]);
+			pBytes[0] = static_cast<uint8_t>(value);
+			pBytes[1] = static_cast<uint8_t>(static_cast<uint16_t>(value) >> 8);
+		};
+		m_isValid = m_isValid && std::fwrite(buffer, sizeof(int16_t), chunk, m_pFile) == chunk;
+	};
+	m_sampleCount += count;
+};
+
+/**
+	Fills in the sizes in the header and closes the file.
+
+	@return false if any write failed.
+ */
+bool WavWriter::Close()
+{
+	if (m_pFile == nullptr)
+	{
+		return m_isValid;
+	};
+
+	uint32_t dataSize = m_sampleCount * sizeof(int16_t);
+	uint8_t sizes[4];
+	StateWriter riffWriter(sizes, sizeof(sizes));
+	riffWriter.WriteU32(static_cast<uint32_t>(g_wavHeaderSize - 8 + dataSize));
+	m_isValid = m_isValid && std::fseek(m_pFile, 4, SEEK_SET) == 0 && std::fwrite(sizes, 1, 4, m_pFile) == 4;
+
+	StateWriter dataWriter(sizes, sizeof(sizes));
+	dataWriter.WriteU32(dataSize);
+	m_isValid = m_isValid && std::fseek(m_pFile, 40, SEEK_SET) == 0 && std::fwrite(sizes, 1, 4, m_pFile) == 4;
+
+	m_isValid = std::fclose(m_pFile) == 0 && m_isValid;
+	m_pFile = nullptr;
+	return m_isValid;
+};
@@ -0,0 +1,140 @@
+#ifndef AUDIO_HPP_INCLUDED
+#define AUDIO_HPP_INCLUDED
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include "Interpreter.hpp"
+#include "SpscRing.hpp"
+
+/** Output sample rate unless configured otherwise */
+constexpr uint32_t g_audioDefaultSampleRate = 48000;
+/** Samples per device buffer unless configured otherwise, 5.3 ms at 48 kHz */
+constexpr uint32_t g_audioDefaultBufferFrames = 256;
+/** Pitch of the beeper in Hz */
+constexpr double g_audioDefaultToneFrequency = 440.0;
+/** Beeper changes that can be queued between two device callbacks */
+constexpr size_t g_audioEventCapacity = 256;
+
+/**
+	A beeper change on the audio timeline.
+ */
+struct BeeperEvent
+{
+	/** Sample the change happens at, in guest time */
+	uint64_t sampleTime;
+	/** true for an XO-CHIP pattern change, false for the beeper turning on or off */
+	bool isPattern;
+	/** true when the beeper turns on */
+	bool isOn;
+	/** XO-CHIP pitch register */
+	uint8_t pitch;
+	/** XO-CHIP audio pattern */
+	std::array<uint8_t, g_xoAudioPatternSize> pattern;
+};
+
+/**
+	Turns the sound timer in to a band limited square wave, or in to the
+	XO-CHIP audio pattern once a program loaded one.\n
+	The emulation thread receives beeper changes as a SoundListener and
+	pushes them, stamped with the guest time they happened at, in to a lock
+	free ring. The audio thread pulls samples with Render() and applies each
+	change at its sample. Guest time is mapped to the audio clock with one
+	buffer of latency and re-mapped whenever the two drift more than a few
+	buffers apart, for example after a stall or a rewind. The emulation side
+	never waits, a full ring drops the change.
+ */
+class AudioEngine : public SoundListener
+{
+	public:
+
+		explicit AudioEngine(uint32_t sampleRate = g_audioDefaultSampleRate, uint32_t bufferFrames = g_audioDefaultBufferFrames);
+
+		void SetInstructionsPerSecond(uint32_t instructionsPerSecond);
+		void SetToneFrequency(double frequency);
+		void OnSoundChanged(uint64_t cycle, bool isActive) override;
+		void OnPatternChanged(uint64_t cycle, const std::array<uint8_t, g_xoAudioPatternSize>& pattern, uint8_t pitch) override;
+
+		void Render(float* pSamples, uint32_t count);
+
+		uint32_t GetSampleRate() const;
+		uint32_t GetBufferFrames() const;
+		uint64_t GetDroppedEvents() const;
+
+	private:
+
+		void Queue(const BeeperEvent& event);
+		void Apply(const BeeperEvent& event);
+		float RenderSquare();
+		float RenderPattern();
+		static double PolyBlep(double phase, double phaseStep);
+
+	private:
+
+		/** Output sample rate */
+		uint32_t m_sampleRate;
+		/** Samples per device buffer, also the latency between guest and audio clock */
+		uint32_t m_bufferFrames;
+		/** Guest speed, converts cycles to samples */
+		uint32_t m_instructionsPerSecond;
+		/** Changes waiting for the audio thread */
+		SpscRing<BeeperEvent, g_audioEventCapacity> m_events;
+		/** Changes dropped because the ring was full */
+		std::atomic<uint64_t> m_droppedEvents;
+
+		// Audio thread state.
+
+		/** Samples rendered so far */
+		uint64_t m_clock;
+		/** Added to event times to get audio clock times */
+		int64_t m_offset;
+		/** Set once the first event mapped the guest time on to the audio clock */
+		bool m_isSynchronized;
+		/** Whether the beeper is on */
+		bool m_isOn;
+		/** Position in the square wave period, 0 to 1 */
+		double m_phase;
+		/** Phase advance per sample */
+		double m_phaseStep;
+		/** Current loudness, ramped towards 0 or 1 to avoid clicks */
+		float m_gain;
+		/** Set once an XO-CHIP pattern replaced the square wave */
+		bool m_hasPattern;
+		/** XO-CHIP audio pattern being played */
+		std::array<uint8_t, g_xoAudioPatternSize> m_pattern;
+		/** Position in the pattern in bits, 0 to 128 */
+		double m_patternPosition;
+		/** Pattern bits per output sample */
+		double m_patternStep;
+
+}; // AudioEngine
+
+/**
+	Writes mono float samples to a 16-bit PCM WAV file.\n
+	Used as the audio sink of headless runs.
+ */
+class WavWriter
+{
+	public:
+
+		WavWriter();
+		~WavWriter();
+
+		bool Open(const char* filePath, uint32_t sampleRate);
+		void Write(const float* pSamples, uint32_t count);
+		bool Close();
+
+	private:
+
+		/** Output file, null when closed */
+		FILE* m_pFile;
+		/** Samples written */
+		uint32_t m_sampleCount;
+		/** Cleared when a write failed */
+		bool m_isValid;
+
+}; // WavWriter
+
+#endif // AUDIO_HPP_INCLUDED
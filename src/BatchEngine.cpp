@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include "BatchEngine.hpp"
+
+/**
+	Default Constructor
+
+	@param[in] threadCount Number of worker threads, 0 uses one per hardware thread.
+ */
+BatchEngine::BatchEngine(uint32_t threadCount) : m_threadCount(threadCount), m_cyclesPerFrame(1), m_pendingInstances(0), m_executed(0), m_steals(0)
+{
+	if (m_threadCount == 0)
+	{
+		m_threadCount = std::max(1u, std::thread::hardware_concurrency());
+	};
+
+	for (uint32_t i = 0; i < m_threadCount; i++)
+	{
+		m_queues.push_back(std::make_unique<WorkQueue>());
+	};
+};
+
+/**
+	Default Destructor
+ */
+BatchEngine::~BatchEngine()
+{
+};
+
+/**
+	Hands an initialized interpreter to the engine.
+
+	@param[in] pInterpreter Interpreter to run in the batch.
+	@return Index of the instance.
+ */
+size_t BatchEngine::AddInstance(std::unique_ptr<Interpreter> pInterpreter)
+{
+	m_instances.push_back(std::move(pInterpreter));
+	m_remainingCycles.push_back(0);
+	m_frameCycles.push_back(0);
+	return m_instances.size() - 1;
+};
+
+/**
+	Retrieve an instance, only safe while no batch is running.
+
+	@param[in] index Index returned by AddInstance().
+ */
+Interpreter& BatchEngine::GetInstance(size_t index)
+{
+	return *m_instances[index];
+};
+
+/**
+	Retrieve the number of instances owned by the engine.
+ */
+size_t BatchEngine::GetInstanceCount() const
+{
+	return m_instances.size();
+};
+
+/**
+	Retrieve the number of worker threads.
+ */
+uint32_t BatchEngine::GetThreadCount() const
+{
+	return m_threadCount;
+};
+
+/**
+	Runs every instance for a number of cycles and waits for all of them to finish.
+
+	@param[in] cyclesPerInstance Number of instructions each instance executes.
+	@param[in] sliceCycles Number of instructions an instance runs before yielding to the next one.
+	@param[in] cyclesPerFrame Number of instructions between two timer ticks.
+	@return Totals for the batch.
+ */
+BatchResult BatchEngine::Run(uint64_t cyclesPerInstance, uint32_t sliceCycles, uint32_t cyclesPerFrame)
+{
+	if (sliceCycles == 0)
+	{
+		sliceCycles = 1;
+	};
+
+	m_cyclesPerFrame = cyclesPerFrame > 0 ? cyclesPerFrame : 1;
+
+	// Deal the instances out round robin.
+	for (size_t i = 0; i < m_instances.size(); i++)
+	{
+		m_remainingCycles[i] = cyclesPerInstance;
+		m_queues[i % m_threadCount]->instances.push_back(i);
+	};
+
+	m_pendingInstances = cyclesPerInstance > 0 ? m_instances.size() : 0;
+	m_executed = 0;
+	m_steals = 0;
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> workers;
+	for (uint32_t i = 1; i < m_threadCount; i++)
+	{
+		workers.emplace_back(&BatchEngine::WorkerMain, this, i, sliceCycles);
+	};
+
+	// The calling thread is worker 0.
+	WorkerMain(0, sliceCycles);
+
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	};
+
+	auto end = std::chrono::steady_clock::now();
+
+	for (std::unique_ptr<WorkQueue>& pQueue : m_queues)
+	{
+		pQueue->instances.clear();
+	};
+
+	BatchResult result;
+	result.instructions = m_executed;
+	result.seconds = std::chrono::duration<double>(end - start).count();
+	result.steals = m_steals;
+	return result;
+};
+
+/**
+	Worker loop, runs slices until every instance has finished.
+
+	@param[in] workerIndex Index of the worker's own queue.
+	@param[in] sliceCycles Number of instructions per slice.
+ */
+void BatchEngine::WorkerMain(uint32_t workerIndex, uint32_t sliceCycles)
+{
+	// Counted locally to keep the shared counter out of the hot loop.
+	uint64_t executed = 0;
+
+	while (m_pendingInstances.load(std::memory_order_acquire) > 0)
+	{
+		size_t instance;
+		if (!PopLocal(workerIndex, instance) && !Steal(workerIndex, instance))
+		{
+			std::this_thread::yield();
+			continue;
+		};
+
+		uint64_t& remaining = m_remainingCycles[instance];
+		uint32_t slice = static_cast<uint32_t>(remaining < sliceCycles ? remaining : sliceCycles);
+		uint32_t ran = RunSlice(instance, slice);
+		remaining -= ran;
+		executed += ran;
+
+		if (remaining > 0)
+		{
+			// Yield to the other instances on this worker.
+			WorkQueue& queue = *m_queues[workerIndex];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.instances.push_front(instance);
+		}
+		else
+		{
+			m_pendingInstances.fetch_sub(1, std::memory_order_release);
+		};
+	};
+
+	m_executed.fetch_add(executed);
+};
+
+/**
+	Runs an instance, ticking its timers at every frame boundary.
+
+	@param[in] instance Index of the instance.
+	@param[in] cycles Number of instructions to execute.
+	@return Number of instructions executed.
+ */
+uint32_t BatchEngine::RunSlice(size_t instance, uint32_t cycles)
+{
+	Interpreter& interpreter = *m_instances[instance];
+	uint32_t& frameCycles = m_frameCycles[instance];
+	uint32_t executed = 0;
+
+	while (executed < cycles)
+	{
+		uint32_t frameRemaining = m_cyclesPerFrame - frameCycles;
+		uint32_t ran = interpreter.Execute(cycles - executed < frameRemaining ? cycles - executed : frameRemaining);
+		executed += ran;
+		frameCycles += ran;
+
+		if (frameCycles == m_cyclesPerFrame)
+		{
+			interpreter.TickTimers();
+			frameCycles = 0;
+		};
+	};
+
+	return executed;
+};
+
+/**
+	Takes the next instance from the worker's own queue.
+
+	@param[in] workerIndex Index of the worker.
+	@param[out] instance Index of the instance to run.
+	@return false if the queue was empty.
+ */
+bool BatchEngine::PopLocal(uint32_t workerIndex, size_t& instance)
+{
+	WorkQueue& queue = *m_queues[workerIndex];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.instances.empty())
+	{
+		return false;
+	};
+
+	instance = queue.instances.back();
+	queue.instances.pop_back();
+	return true;
+};
+
+/**
+	Takes an instance from the opposite end of another worker's queue.
+
+	@param[in] workerIndex Index of the worker looking for work.
+	@param[out] instance Index of the instance to run.
+	@return false if every other queue was empty.
+ */
+bool BatchEngine::Steal(uint32_t workerIndex, size_t& instance)
+{
+	for (uint32_t i = 1; i < m_threadCount; i++)
+	{
+		WorkQueue& victim = *m_queues[(workerIndex + i) % m_threadCount];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.instances.empty())
+		{
+			instance = victim.instances.front();
+			victim.instances.pop_front();
+			m_steals.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		};
+	};
+
+	return false;
+};
@@ -0,0 +1,88 @@
+#ifndef BATCHENGINE_HPP_INCLUDED
+#define BATCHENGINE_HPP_INCLUDED
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Interpreter.hpp"
+
+/**
+	Totals reported after a batch run.
+ */
+struct BatchResult
+{
+	/** Instructions executed over all instances */
+	uint64_t instructions;
+	/** Wall clock time of the run in seconds */
+	double seconds;
+	/** Number of slices taken from another worker's queue */
+	uint64_t steals;
+};
+
+/**
+	Runs many Interpreter instances on a pool of worker threads.\n
+	Every worker owns a queue of instances. An instance runs for a slice of
+	cycles and is then put at the back of the queue again, so instances on
+	the same worker take turns. Every instance ticks its timers once per
+	frame of guest instructions. Workers that run out of work steal instances
+	from the front of other workers' queues.
+ */
+class BatchEngine
+{
+	public:
+
+		explicit BatchEngine(uint32_t threadCount = 0);
+		~BatchEngine();
+
+		size_t AddInstance(std::unique_ptr<Interpreter> pInterpreter);
+		Interpreter& GetInstance(size_t index);
+		size_t GetInstanceCount() const;
+		uint32_t GetThreadCount() const;
+
+		BatchResult Run(uint64_t cyclesPerInstance, uint32_t sliceCycles, uint32_t cyclesPerFrame);
+
+	private:
+
+		/** Instances waiting to run on one worker */
+		struct WorkQueue
+		{
+			/** Guards instances */
+			std::mutex mutex;
+			/** Indices in to m_instances */
+			std::deque<size_t> instances;
+		};
+
+		void WorkerMain(uint32_t workerIndex, uint32_t sliceCycles);
+		uint32_t RunSlice(size_t instance, uint32_t cycles);
+		bool PopLocal(uint32_t workerIndex, size_t& instance);
+		bool Steal(uint32_t workerIndex, size_t& instance);
+
+	private:
+
+		/** Number of worker threads */
+		uint32_t m_threadCount;
+		/** Instances owned by the engine */
+		std::vector<std::unique_ptr<Interpreter>> m_instances;
+		/** Cycles each instance still has to run in the current batch */
+		std::vector<uint64_t> m_remainingCycles;
+		/** Cycles each instance ran since its last timer tick */
+		std::vector<uint32_t> m_frameCycles;
+		/** Cycles between two timer ticks */
+		uint32_t m_cyclesPerFrame;
+		/** One queue per worker */
+		std::vector<std::unique_ptr<WorkQueue>> m_queues;
+		/** Instances that have not finished the current batch */
+		std::atomic<size_t> m_pendingInstances;
+		/** Instructions executed in the current batch */
+		std::atomic<uint64_t> m_executed;
+		/** Slices stolen in the current batch */
+		std::atomic<uint64_t> m_steals;
+
+}; // BatchEngine
+
+#endif // BATCHENGINE_HPP_INCLUDED
@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <cstring>
+#include "Blitter.hpp"
+#include "Simd.hpp"
+
+/** Number of 32-bit pixels in a SimdVector */
+constexpr uint32_t g_simdPixels = g_simdBytes / sizeof(uint32_t);
+
+const std::array<Palette, 4> g_palettes =
+{{
+	{ "mono", {{ 0xFF000000, 0xFFFFFFFF, 0xFFAAAAAA, 0xFF555555 }} },
+	{ "amber", {{ 0xFF1A0F00, 0xFFFFB000, 0xFFC07800, 0xFF603C00 }} },
+	{ "green", {{ 0xFF0F1F0F, 0xFF33FF66, 0xFF22AA44, 0xFF115522 }} },
+	{ "lcd", {{ 0xFF9BBC0F, 0xFF0F380F, 0xFF306230, 0xFF8BAC0F }} }
+}};
+
+/**
+	Looks up a built in palette by name.
+
+	@param[in] pName Name of the palette.
+	@return The palette or null if there is none with that name.
+ */
+const Palette* FindPalette(const char* pName)
+{
+	for (const Palette& palette : g_palettes)
+	{
+		if (std::strcmp(palette.pName, pName) == 0)
+		{
+			return &palette;
+		};
+	};
+
+	return nullptr;
+};
+
+/**
+	Default Constructor
+ */
+Blitter::Blitter() : m_palette(g_palettes[0]), m_scale(0)
+{
+};
+
+/**
+	Sets the colours used for the pixel values.
+ */
+void Blitter::SetPalette(const Palette& palette)
+{
+	m_palette = palette;
+};
+
+/**
+	Sets the integer scale factor.
+
+	@param[in] scale Destination pixels per framebuffer pixel, 0 fits the destination.
+ */
+void Blitter::SetScale(uint32_t scale)
+{
+	m_scale = scale;
+};
+
+/**
+	Retrieve the scale factor used for a destination of the given size.
+ */
+uint32_t Blitter::GetScale(const Framebuffer& framebuffer, uint32_t width, uint32_t height) const
+{
+	if (m_scale != 0)
+	{
+		return m_scale;
+	};
+
+	uint32_t scale = std::min(width / framebuffer.GetWidth(), height / framebuffer.GetHeight());
+	return std::max(scale, 1u);
+};
+
+/**
+	Draws the framebuffer in to the top left corner of a pixel buffer.\n
+	Whatever the scaled image does not cover is filled with the unlit colour,
+	so the destination does not have to be cleared first.
+
+	@param[in] framebuffer Screen to draw.
+	@param[in] pPixels Destination pixels.
+	@param[in] pitch Distance between destination rows in pixels.
+	@param[in] width Width of the destination in pixels.
+	@param[in] height Height of the destination in pixels.
+ */
+void Blitter::Blit(const Framebuffer& framebuffer, uint32_t* pPixels, uint32_t pitch, uint32_t width, uint32_t height)
+{
+	BlitRows(framebuffer, framebuffer.GetAllRows(), pPixels, pitch, width, height);
+
+	// Below the image.
+	uint32_t row = std::min(framebuffer.GetHeight() * GetScale(framebuffer, width, height), height);
+	for (uint32_t* pDestination = pPixels + row * pitch; row < height; row++, pDestination += pitch)
+	{
+		std::fill(pDestination, pDestination + width, m_palette.colors[0]);
+	};
+};
+
+/**
+	Redraws selected framebuffer rows, leaving the rest of the destination untouched.\n
+	The destination must have been drawn with Blit() at the same size before.
+
+	@param[in] framebuffer Screen to draw.
+	@param[in] rows Bit y is set for every framebuffer row y to draw.
+	@param[in] pPixels Destination pixels.
+	@param[in] pitch Distance between destination rows in pixels.
+	@param[in] width Width of the destination in pixels.
+	@param[in] height Height of the destination in pixels.
+ */
+void Blitter::BlitRows(const Framebuffer& framebuffer, uint64_t rows, uint32_t* pPixels, uint32_t pitch, uint32_t width, uint32_t height)
+{
+	uint32_t scale = GetScale(framebuffer, width, height);
+	uint32_t imageWidth = std::min<uint32_t>(framebuffer.GetWidth() * scale, width);
+
+	for (uint16_t y = 0; y < framebuffer.GetHeight() && y * scale < height; y++)
+	{
+		if ((rows & (1ULL << y)) == 0)
+		{
+			continue;
+		};
+
+		if (framebuffer.GetPlaneCount() > 1)
+		{
+			ExpandRows(framebuffer.GetRow(y, 0), framebuffer.GetRow(y, 1), framebuffer.GetWordsPerRow());
+		}
+		else
+		{
+			ExpandRow(framebuffer.GetRow(y), framebuffer.GetWordsPerRow());
+		};
+		ScaleRow(framebuffer.GetWidth(), scale);
+
+		uint32_t* pDestination = pPixels + y * scale * pitch;
+		for (uint32_t row = y * scale; row < (y + 1) * scale && row < height; row++, pDestination += pitch)
+		{
+			std::memcpy(pDestination, m_scaledRow.data(), imageWidth * sizeof(uint32_t));
+			std::fill(pDestination + imageWidth, pDestination + width, m_palette.colors[0]);
+		};
+	};
+};
+
+/** Lane i of a vector tests bit 31 - i of a 32 pixel half word */
+static const uint32_t s_bits[32] =
+{
+	0x80000000, 0x40000000, 0x20000000, 0x10000000, 0x08000000, 0x04000000, 0x02000000, 0x01000000,
+	0x00800000, 0x00400000, 0x00200000, 0x00100000, 0x00080000, 0x00040000, 0x00020000, 0x00010000,
+	0x00008000, 0x00004000, 0x00002000, 0x00001000, 0x00000800, 0x00000400, 0x00000200, 0x00000100,
+	0x00000080, 0x00000040, 0x00000020, 0x00000010, 0x00000008, 0x00000004, 0x00000002, 0x00000001
+};
+
+/**
+	Converts a packed row to one colour per pixel in m_colors.
+
+	@param[in] pRow Packed pixels, most significant bit leftmost.
+	@param[in] wordCount Number of 64-bit words in the row.
+ */
+void Blitter::ExpandRow(const uint64_t* pRow, uint16_t wordCount)
+{
+	m_colors.resize(wordCount * g_framebufferWordBits);
+
+	const SimdVector zero = SimdZero();
+	const SimdVector unlit = SimdSetU32(m_palette.colors[0]);
+	const SimdVector lit = SimdSetU32(m_palette.colors[1]);
+	uint32_t* pColors = m_colors.data();
+
+	for (uint16_t word = 0; word < wordCount; word++)
+	{
+		const uint32_t halves[2] = { static_cast<uint32_t>(pRow[word] >> 32), static_cast<uint32_t>(pRow[word]) };
+		for (uint32_t half : halves)
+		{
+			const SimdVector bits = SimdSetU32(half);
+			for (uint32_t i = 0; i < 32; i += g_simdPixels, pColors += g_simdPixels)
+			{
+				SimdVector isUnlit = SimdEqualU32(SimdAnd(bits, SimdLoad(&s_bits[i])), zero);
+				SimdStore(pColors, SimdBlend(isUnlit, lit, unlit));
+			};
+		};
+	};
+};
+
+/**
+	Converts the same row of two bit planes to one colour per pixel in m_colors.
+
+	@param[in] pRow Packed pixels of the first plane, pixel value bit 0.
+	@param[in] pSecondRow Packed pixels of the second plane, pixel value bit 1.
+	@param[in] wordCount Number of 64-bit words in a row.
+ */
+void Blitter::ExpandRows(const uint64_t* pRow, const uint64_t* pSecondRow, uint16_t wordCount)
+{
+	m_colors.resize(wordCount * g_framebufferWordBits);
+
+	const SimdVector zero = SimdZero();
+	const SimdVector colors[g_paletteSize] =
+	{
+		SimdSetU32(m_palette.colors[0]), SimdSetU32(m_palette.colors[1]),
+		SimdSetU32(m_palette.colors[2]), SimdSetU32(m_palette.colors[3])
+	};
+	uint32_t* pColors = m_colors.data();
+
+	for (uint16_t word = 0; word < wordCount; word++)
+	{
+		const uint32_t halves[2][2] =
+		{
+			{ static_cast<uint32_t>(pRow[word] >> 32), static_cast<uint32_t>(pSecondRow[word] >> 32) },
+			{ static_cast<uint32_t>(pRow[word]), static_cast<uint32_t>(pSecondRow[word]) }
+		};
+		for (const uint32_t* pHalf : halves)
+		{
+			const SimdVector bits = SimdSetU32(pHalf[0]);
+			const SimdVector secondBits = SimdSetU32(pHalf[1]);
+			for (uint32_t i = 0; i < 32; i += g_simdPixels, pColors += g_simdPixels)
+			{
+				const SimdVector test = SimdLoad(&s_bits[i]);
+				SimdVector isClear = SimdEqualU32(SimdAnd(bits, test), zero);
+				SimdVector isSecondClear = SimdEqualU32(SimdAnd(secondBits, test), zero);
+				SimdVector firstPlane = SimdBlend(isClear, colors[1], colors[0]);
+				SimdVector bothPlanes = SimdBlend(isClear, colors[3], colors[2]);
+				SimdStore(pColors, SimdBlend(isSecondClear, bothPlanes, firstPlane));
+			};
+		};
+	};
+};
+
+/**
+	Repeats every colour in m_colors scale times in to m_scaledRow.
+ */
+void Blitter::ScaleRow(uint16_t pixelCount, uint32_t scale)
+{
+	// Room for the last pixel's vector stores to run past the end.
+	m_scaledRow.resize(pixelCount * scale + g_simdPixels);
+	uint32_t* pScaled = m_scaledRow.data();
+
+	if (scale == 1)
+	{
+		std::memcpy(pScaled, m_colors.data(), pixelCount * sizeof(uint32_t));
+		return;
+	};
+
+	for (uint16_t x = 0; x < pixelCount; x++, pScaled += scale)
+	{
+		const SimdVector color = SimdSetU32(m_colors[x]);
+		for (uint32_t i = 0; i < scale; i += g_simdPixels)
+		{
+			SimdStore(pScaled + i, color);
+		};
+	};
+};
@@ -0,0 +1,71 @@
+#ifndef BLITTER_HPP_INCLUDED
+#define BLITTER_HPP_INCLUDED
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "Framebuffer.hpp"
+
+/** Number of colours in a palette */
+constexpr uint8_t g_paletteSize = 4;
+
+/**
+	Colours used to present the framebuffer, 32-bit ARGB.\n
+	The index is the pixel value, bit 0 coming from the first bit plane and
+	bit 1 from the second one, so index 0 is an unlit pixel and index 1 a
+	lit pixel in single plane modes.
+ */
+struct Palette
+{
+	/** Name used to select the palette */
+	const char* pName;
+	/** ARGB colour per pixel value */
+	std::array<uint32_t, g_paletteSize> colors;
+};
+
+/** Palettes built in to the emulator, the first one is the default */
+extern const std::array<Palette, 4> g_palettes;
+
+const Palette* FindPalette(const char* pName);
+
+/**
+	Scales the framebuffer in to a 32-bit pixel buffer.\n
+	Every source row is expanded to colours once with SIMD, widened by the
+	scale factor and then copied to the destination scale times, so the cost
+	per destination row is a memcpy. BlitRows() only redraws the rows a
+	frame changed.
+ */
+class Blitter
+{
+	public:
+
+		Blitter();
+
+		void SetPalette(const Palette& palette);
+		void SetScale(uint32_t scale);
+		uint32_t GetScale(const Framebuffer& framebuffer, uint32_t width, uint32_t height) const;
+
+		void Blit(const Framebuffer& framebuffer, uint32_t* pPixels, uint32_t pitch, uint32_t width, uint32_t height);
+		void BlitRows(const Framebuffer& framebuffer, uint64_t rows, uint32_t* pPixels, uint32_t pitch, uint32_t width, uint32_t height);
+
+	private:
+
+		void ExpandRow(const uint64_t* pRow, uint16_t wordCount);
+		void ExpandRows(const uint64_t* pRow, const uint64_t* pSecondRow, uint16_t wordCount);
+		void ScaleRow(uint16_t pixelCount, uint32_t scale);
+
+	private:
+
+		/** Colours used for the pixel values */
+		Palette m_palette;
+		/** Integer scale factor, 0 picks the largest one fitting the destination */
+		uint32_t m_scale;
+		/** One colour per framebuffer pixel of the row being blitted */
+		std::vector<uint32_t> m_colors;
+		/** The row being blitted after scaling */
+		std::vector<uint32_t> m_scaledRow;
+
+}; // Blitter
+
+#endif // BLITTER_HPP_INCLUDED
@@ -0,0 +1,444 @@
+#include <algorithm>
+#include <cstring>
+#include "Framebuffer.hpp"
+
+/**
+	Default Constructor
+ */
+Framebuffer::Framebuffer() : m_width(64), m_height(32), m_wordsPerRow(1), m_planeCount(1), m_planeMask(0x01), m_dirtyRows(0)
+{
+	m_rows.fill(0);
+};
+
+/**
+	Changes the resolution and clears every plane.
+
+	@param[in] width Width in pixels, rounded up to a multiple of 64.
+	@param[in] height Height in pixels.
+ */
+void Framebuffer::Resize(uint16_t width, uint16_t height)
+{
+	m_wordsPerRow = (std::min(width, g_framebufferMaxWidth) + g_framebufferWordBits - 1) / g_framebufferWordBits;
+	m_width = m_wordsPerRow * g_framebufferWordBits;
+	m_height = std::min(height, g_framebufferMaxHeight);
+	std::fill(m_rows.begin(), m_rows.begin() + m_planeCount * m_height * m_wordsPerRow, 0);
+	m_dirtyRows = GetAllRows();
+};
+
+/**
+	Changes the number of bit planes and clears every plane, the first plane is selected.
+
+	@param[in] planeCount 1 or 2.
+ */
+void Framebuffer::SetPlaneCount(uint8_t planeCount)
+{
+	m_planeCount = std::min(std::max(planeCount, static_cast<uint8_t>(1)), g_framebufferMaxPlanes);
+	m_planeMask = 0x01;
+	Resize(m_width, m_height);
+};
+
+/**
+	Selects the planes drawing, clearing and scrolling apply to.
+
+	@param[in] planeMask Bit p selects plane p, planes past the plane count are ignored.
+ */
+void Framebuffer::SelectPlanes(uint8_t planeMask)
+{
+	m_planeMask = planeMask & ((1 << m_planeCount) - 1);
+};
+
+/**
+	Turns every pixel of the selected planes off.
+ */
+void Framebuffer::Clear()
+{
+	for (uint8_t plane = 0; plane < m_planeCount; plane++)
+	{
+		if ((m_planeMask & (1 << plane)) == 0)
+		{
+			continue;
+		};
+
+		uint64_t* pPlane = GetPlane(plane);
+		for (uint16_t y = 0; y < m_height; y++)
+		{
+			uint64_t* pRow = &pPlane[y * m_wordsPerRow];
+			for (uint16_t word = 0; word < m_wordsPerRow; word++)
+			{
+				// Only rows that had a pixel on need to be presented again.
+				if (pRow[word] != 0)
+				{
+					m_dirtyRows |= 1ULL << y;
+					pRow[word] = 0;
+				};
+			};
+		};
+	};
+};
+
+/**
+	XORs an 8 pixel wide sprite on to the selected planes.\n
+	The start position wraps around the screen, the sprite itself is clipped
+	or wrapped at the edges depending on Wrap.
+
+	@tparam Wrap true wraps pixels past the edge to the opposite edge, false clips them.
+	@param[in] x Column of the sprite's left edge.
+	@param[in] y Row of the sprite's top edge.
+	@param[in] pRows One byte per sprite row, most significant bit leftmost. Every selected plane takes the next rowCount bytes, lowest plane first.
+	@param[in] rowCount Number of rows in the sprite.
+	@return true if any pixel that was on got turned off.
+ */
+template <bool Wrap>
+bool Framebuffer::DrawSprite(uint16_t x, uint16_t y, const uint8_t* pRows, uint8_t rowCount)
+{
+	return DrawRows<1, Wrap>(x, y, pRows, rowCount);
+};
+
+/**
+	XORs a 16 pixel wide sprite on to the selected planes, like DrawSprite() with two bytes per row.
+ */
+template <bool Wrap>
+bool Framebuffer::DrawWideSprite(uint16_t x, uint16_t y, const uint8_t* pRows, uint8_t rowCount)
+{
+	return DrawRows<2, Wrap>(x, y, pRows, rowCount);
+};
+
+template bool Framebuffer::DrawSprite<false>(uint16_t x, uint16_t y, const uint8_t* pRows, uint8_t rowCount);
+template bool Framebuffer::DrawSprite<true>(uint16_t x, uint16_t y, const uint8_t* pRows, uint8_t rowCount);
+template bool Framebuffer::DrawWideSprite<false>(uint16_t x, uint16_t y, const uint8_t* pRows, uint8_t rowCount);
+template bool Framebuffer::DrawWideSprite<true>(uint16_t x, uint16_t y, const uint8_t* pRows, uint8_t rowCount);
+
+/**
+	Draws a sprite of BytesPerRow bytes per row on every selected plane.
+ */
+template <uint8_t BytesPerRow, bool Wrap>
+bool Framebuffer::DrawRows(uint16_t x, uint16_t y, const uint8_t* pRows, uint8_t rowCount)
+{
+	x %= m_width;
+	y %= m_height;
+
+	bool collision = false;
+	for (uint8_t plane = 0; plane < m_planeCount; plane++)
+	{
+		if ((m_planeMask & (1 << plane)) == 0)
+		{
+			continue;
+		};
+
+		uint64_t* pPlane = GetPlane(plane);
+		for (uint8_t row = 0; row < rowCount; row++, pRows += BytesPerRow)
+		{
+			uint16_t posY = y + row;
+			if (posY >= m_height)
+			{
+				if (!Wrap)
+				{
+					// The rest of this plane's rows are clipped.
+					pRows += (rowCount - row) * BytesPerRow;
+					break;
+				};
+				posY -= m_height;
+			};
+
+			uint64_t bits = pRows[0];
+			for (uint8_t i = 1; i < BytesPerRow; i++)
+			{
+				bits = bits << 8 | pRows[i];
+			};
+
+			if (bits != 0)
+			{
+				// Left align the sprite row in a word.
+				collision |= DrawRow<Wrap>(&pPlane[posY * m_wordsPerRow], x, bits << (g_framebufferWordBits - 8 * BytesPerRow));
+				m_dirtyRows |= 1ULL << posY;
+			};
+		};
+	};
+
+	return collision;
+};
+
+/**
+	XORs left aligned bits in to a row starting at column x.
+
+	@return true if any pixel that was on got turned off.
+ */
+template <bool Wrap>
+bool Framebuffer::DrawRow(uint64_t* pRow, uint16_t x, uint64_t bits)
+{
+	uint16_t word = x / g_framebufferWordBits;
+	uint16_t shift = x % g_framebufferWordBits;
+
+	uint64_t left = bits >> shift;
+	uint64_t collision = pRow[word] & left;
+	pRow[word] ^= left;
+
+	// Bits shifted past the end of the word continue in the next one.
+	if (shift != 0)
+	{
+		uint64_t right = bits << (g_framebufferWordBits - shift);
+		uint16_t next = word + 1;
+		if (next == m_wordsPerRow)
+		{
+			next = Wrap ? 0 : m_wordsPerRow;
+		};
+
+		if (next < m_wordsPerRow)
+		{
+			collision |= pRow[next] & right;
+			pRow[next] ^= right;
+		};
+	};
+
+	return collision != 0;
+};
+
+/**
+	Moves the selected planes down, rows scrolled in at the top are blank.
+
+	@param[in] rows Number of rows to scroll by.
+ */
+void Framebuffer::ScrollDown(uint16_t rows)
+{
+	rows = std::min(rows, m_height);
+	for (uint8_t plane = 0; plane < m_planeCount; plane++)
+	{
+		if ((m_planeMask & (1 << plane)) != 0)
+		{
+			uint64_t* pPlane = GetPlane(plane);
+			std::memmove(&pPlane[rows * m_wordsPerRow], pPlane, (m_height - rows) * m_wordsPerRow * sizeof(uint64_t));
+			std::fill(pPlane, pPlane + rows * m_wordsPerRow, 0);
+		};
+	};
+	m_dirtyRows = GetAllRows();
+};
+
+/**
+	Moves the selected planes up, rows scrolled in at the bottom are blank.
+
+	@param[in] rows Number of rows to scroll by.
+ */
+void Framebuffer::ScrollUp(uint16_t rows)
+{
+	rows = std::min(rows, m_height);
+	for (uint8_t plane = 0; plane < m_planeCount; plane++)
+	{
+		if ((m_planeMask & (1 << plane)) != 0)
+		{
+			uint64_t* pPlane = GetPlane(plane);
+			std::memmove(pPlane, &pPlane[rows * m_wordsPerRow], (m_height - rows) * m_wordsPerRow * sizeof(uint64_t));
+			std::fill(pPlane + (m_height - rows) * m_wordsPerRow, pPlane + m_height * m_wordsPerRow, 0);
+		};
+	};
+	m_dirtyRows = GetAllRows();
+};
+
+/**
+	Moves the selected planes right, columns scrolled in at the left are blank.
+
+	@param[in] pixels Number of columns to scroll by, less than 64.
+ */
+void Framebuffer::ScrollRight(uint16_t pixels)
+{
+	pixels %= g_framebufferWordBits;
+	if (pixels == 0)
+	{
+		return;
+	};
+
+	for (uint8_t plane = 0; plane < m_planeCount; plane++)
+	{
+		if ((m_planeMask & (1 << plane)) == 0)
+		{
+			continue;
+		};
+
+		uint64_t* pRow = GetPlane(plane);
+		for (uint16_t y = 0; y < m_height; y++, pRow += m_wordsPerRow)
+		{
+			// Each word takes the bits the word to its left shifts out.
+			for (uint16_t word = m_wordsPerRow - 1; word > 0; word--)
+			{
+				pRow[word] = pRow[word] >> pixels | pRow[word - 1] << (g_framebufferWordBits - pixels);
+			};
+			pRow[0] >>= pixels;
+		};
+	};
+	m_dirtyRows = GetAllRows();
+};
+
+/**
+	Moves the selected planes left, columns scrolled in at the right are blank.
+
+	@param[in] pixels Number of columns to scroll by, less than 64.
+ */
+void Framebuffer::ScrollLeft(uint16_t pixels)
+{
+	pixels %= g_framebufferWordBits;
+	if (pixels == 0)
+	{
+		return;
+	};
+
+	for (uint8_t plane = 0; plane < m_planeCount; plane++)
+	{
+		if ((m_planeMask & (1 << plane)) == 0)
+		{
+			continue;
+		};
+
+		uint64_t* pRow = GetPlane(plane);
+		for (uint16_t y = 0; y < m_height; y++, pRow += m_wordsPerRow)
+		{
+			// Each word takes the bits the word to its right shifts out.
+			for (uint16_t word = 0; word + 1 < m_wordsPerRow; word++)
+			{
+				pRow[word] = pRow[word] << pixels | pRow[word + 1] >> (g_framebufferWordBits - pixels);
+			};
+			pRow[m_wordsPerRow - 1] <<= pixels;
+		};
+	};
+	m_dirtyRows = GetAllRows();
+};
+
+/**
+	Retrieve the value of a single pixel, bit p is the pixel's bit in plane p.
+ */
+uint8_t Framebuffer::GetPixel(uint16_t x, uint16_t y) const
+{
+	uint8_t value = 0;
+	for (uint8_t plane = 0; plane < m_planeCount; plane++)
+	{
+		uint64_t word = GetRow(y, plane)[x / g_framebufferWordBits];
+		value |= static_cast<uint8_t>(((word << (x % g_framebufferWordBits)) >> (g_framebufferWordBits - 1)) << plane);
+	};
+	return value;
+};
+
+/**
+	Retrieve the packed words of a row of one plane.
+ */
+const uint64_t* Framebuffer::GetRow(uint16_t y, uint8_t plane) const
+{
+	return &m_rows[(plane * m_height + y) * m_wordsPerRow];
+};
+
+/**
+	Retrieve the width in pixels.
+ */
+uint16_t Framebuffer::GetWidth() const
+{
+	return m_width;
+};
+
+/**
+	Retrieve the height in pixels.
+ */
+uint16_t Framebuffer::GetHeight() const
+{
+	return m_height;
+};
+
+/**
+	Retrieve the number of words making up one row.
+ */
+uint16_t Framebuffer::GetWordsPerRow() const
+{
+	return m_wordsPerRow;
+};
+
+/**
+	Retrieve the number of bit planes in use.
+ */
+uint8_t Framebuffer::GetPlaneCount() const
+{
+	return m_planeCount;
+};
+
+/**
+	Retrieve the planes drawing applies to, bit p is set for plane p.
+ */
+uint8_t Framebuffer::GetSelectedPlanes() const
+{
+	return m_planeMask;
+};
+
+/**
+	Checks if any row changed since ClearDirtyRows().
+ */
+bool Framebuffer::IsDirty() const
+{
+	return m_dirtyRows != 0;
+};
+
+/**
+	Retrieve the rows changed since ClearDirtyRows(), bit y is set for row y.
+ */
+uint64_t Framebuffer::GetDirtyRows() const
+{
+	return m_dirtyRows;
+};
+
+/**
+	Marks every row as presented.
+ */
+void Framebuffer::ClearDirtyRows()
+{
+	m_dirtyRows = 0;
+};
+
+/**
+	Retrieve a row mask with a bit set for every row of the current resolution.
+ */
+uint64_t Framebuffer::GetAllRows() const
+{
+	return m_height >= 64 ? ~0ULL : (1ULL << m_height) - 1;
+};
+
+/**
+	Retrieve the packed rows of every plane at the current resolution as bytes.
+ */
+const uint8_t* Framebuffer::GetData() const
+{
+	return reinterpret_cast<const uint8_t*>(m_rows.data());
+};
+
+/**
+	Retrieve the size in bytes of the packed rows of every plane at the current resolution.
+ */
+size_t Framebuffer::GetDataSize() const
+{
+	return m_planeCount * m_height * m_wordsPerRow * sizeof(uint64_t);
+};
+
+/**
+	Checks if a resolution can be held without rounding or clamping.
+ */
+bool Framebuffer::IsValidSize(uint16_t width, uint16_t height)
+{
+	return width > 0 && width <= g_framebufferMaxWidth && width % g_framebufferWordBits == 0 &&
+		height > 0 && height <= g_framebufferMaxHeight;
+};
+
+/**
+	Writes the packed rows of every plane at the current resolution.
+ */
+void Framebuffer::SaveRows(StateWriter& writer) const
+{
+	for (uint16_t i = 0; i < m_planeCount * m_height * m_wordsPerRow; i++)
+	{
+		writer.WriteU64(m_rows[i]);
+	};
+};
+
+/**
+	Reads rows written by SaveRows() at the current resolution and plane count, marking every row dirty.
+ */
+void Framebuffer::LoadRows(StateReader& reader)
+{
+	for (uint16_t i = 0; i < m_planeCount * m_height * m_wordsPerRow; i++)
+	{
+		m_rows[i] = reader.ReadU64();
+	};
+	m_dirtyRows = GetAllRows();
+};
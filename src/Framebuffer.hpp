@@ -0,0 +1,102 @@
+#ifndef FRAMEBUFFER_HPP_INCLUDED
+#define FRAMEBUFFER_HPP_INCLUDED
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "StateBuffer.hpp"
+
+/** Widest screen the framebuffer can hold */
+constexpr uint16_t g_framebufferMaxWidth = 128;
+/** Tallest screen the framebuffer can hold */
+constexpr uint16_t g_framebufferMaxHeight = 64;
+/** Number of pixels packed in to one word */
+constexpr uint16_t g_framebufferWordBits = 64;
+/** Most bit planes the framebuffer can hold */
+constexpr uint8_t g_framebufferMaxPlanes = 2;
+
+static_assert(g_framebufferMaxHeight <= 64, "Dirty rows are tracked in a 64-bit mask");
+
+/**
+	One bit per pixel screen buffer.\n
+	Every row is stored as width / 64 words with the leftmost pixel in the
+	most significant bit, so a sprite row is drawn with a shift, an XOR and
+	an AND for the collision test, and scrolling moves whole words. XO-CHIP
+	uses two bit planes, stored one after the other, and the value of a pixel
+	is its bit from plane 0 plus twice its bit from plane 1. Drawing,
+	clearing and scrolling only touch the selected planes. Storage is sized
+	for the largest mode so changing the resolution or the number of planes
+	never reallocates. Rows that changed since the front end last presented
+	are tracked in a bitmap.
+ */
+class Framebuffer
+{
+	public:
+
+		Framebuffer();
+
+		void Resize(uint16_t width, uint16_t height);
+		void SetPlaneCount(uint8_t planeCount);
+		void SelectPlanes(uint8_t planeMask);
+
+		void Clear();
+		template <bool Wrap>
+		bool DrawSprite(uint16_t x, uint16_t y, const uint8_t* pRows, uint8_t rowCount);
+		template <bool Wrap>
+		bool DrawWideSprite(uint16_t x, uint16_t y, const uint8_t* pRows, uint8_t rowCount);
+
+		void ScrollDown(uint16_t rows);
+		void ScrollUp(uint16_t rows);
+		void ScrollRight(uint16_t pixels);
+		void ScrollLeft(uint16_t pixels);
+
+		uint8_t GetPixel(uint16_t x, uint16_t y) const;
+		const uint64_t* GetRow(uint16_t y, uint8_t plane = 0) const;
+
+		uint16_t GetWidth() const;
+		uint16_t GetHeight() const;
+		uint16_t GetWordsPerRow() const;
+		uint8_t GetPlaneCount() const;
+		uint8_t GetSelectedPlanes() const;
+
+		bool IsDirty() const;
+		uint64_t GetDirtyRows() const;
+		void ClearDirtyRows();
+		uint64_t GetAllRows() const;
+
+		const uint8_t* GetData() const;
+		size_t GetDataSize() const;
+
+		static bool IsValidSize(uint16_t width, uint16_t height);
+		void SaveRows(StateWriter& writer) const;
+		void LoadRows(StateReader& reader);
+
+	private:
+
+		template <uint8_t BytesPerRow, bool Wrap>
+		bool DrawRows(uint16_t x, uint16_t y, const uint8_t* pRows, uint8_t rowCount);
+		template <bool Wrap>
+		bool DrawRow(uint64_t* pRow, uint16_t x, uint64_t bits);
+		uint64_t* GetPlane(uint8_t plane) { return &m_rows[plane * m_height * m_wordsPerRow]; };
+
+	private:
+
+		/** Width in pixels, a multiple of 64 */
+		uint16_t m_width;
+		/** Height in pixels */
+		uint16_t m_height;
+		/** Words making up one row */
+		uint16_t m_wordsPerRow;
+		/** Number of bit planes in use */
+		uint8_t m_planeCount;
+		/** Bit p is set when plane p is drawn to */
+		uint8_t m_planeMask;
+		/** Bit y is set when row y changed since ClearDirtyRows() */
+		uint64_t m_dirtyRows;
+		/** Packed pixels, m_wordsPerRow words per row, m_height rows per plane */
+		std::array<uint64_t, g_framebufferMaxPlanes * g_framebufferMaxHeight * (g_framebufferMaxWidth / g_framebufferWordBits)> m_rows;
+
+}; // Framebuffer
+
+#endif // FRAMEBUFFER_HPP_INCLUDED
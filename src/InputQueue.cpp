@@ -0,0 +1,147 @@
+#include <chrono>
+#include "InputQueue.hpp"
+
+/**
+	Default Constructor
+ */
+InputQueue::InputQueue() : m_droppedEvents(0), m_windowStart(Now()), m_windowEnd(m_windowStart), m_tickCount(1), m_tickIndex(0)
+{
+};
+
+/**
+	Retrieve the current host time in the unit of InputEvent::timestamp.
+ */
+uint64_t InputQueue::Now()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Scheduler::Clock::now().time_since_epoch()).count());
+};
+
+/**
+	Queues a key change stamped with the current time, input thread only. Never blocks.
+
+	@param[in] keyIndex Chip8 key index.
+	@param[in] isPressed true when the key went down.
+	@return false if the queue is full and the change was dropped.
+ */
+bool InputQueue::Push(uint8_t keyIndex, bool isPressed)
+{
+	InputEvent event;
+	event.timestamp = Now();
+	event.keyIndex = keyIndex;
+	event.isPressed = isPressed;
+	if (!m_events.TryPush(event))
+	{
+		m_droppedEvents.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	};
+	return true;
+};
+
+/**
+	Closes the window of host time since the last call, emulation thread only.
+
+	@param[in] ticks Number of ExecuteTick() calls the window is spread over, 0 keeps the window open.
+ */
+void InputQueue::BeginTicks(uint32_t ticks)
+{
+	if (ticks == 0)
+	{
+		return;
+	};
+
+	m_windowStart = m_windowEnd;
+	m_windowEnd = Now();
+	m_tickCount = ticks;
+	m_tickIndex = 0;
+};
+
+/**
+	Runs one tick worth of instructions, applying the key changes that fall in to the tick's share of the window.
+
+	@param[in] interpreter Interpreter to run.
+	@param[in] cycles Number of instructions in the tick.
+	@param[in] pMovie Movie recording the changes, may be null.
+	@return Number of instructions executed.
+ */
+uint32_t InputQueue::ExecuteTick(Interpreter& interpreter, uint32_t cycles, Movie* pMovie)
+{
+	uint64_t length = m_windowEnd - m_windowStart;
+	uint64_t start = m_windowStart + length * m_tickIndex / m_tickCount;
+	uint64_t end = m_windowStart + length * (m_tickIndex + 1) / m_tickCount;
+	if (m_tickIndex + 1 < m_tickCount)
+	{
+		m_tickIndex++;
+	};
+
+	uint32_t executed = 0;
+	while (const InputEvent* pEvent = m_events.Peek())
+	{
+		// Changes captured after the window closed wait for the next ticks.
+		if (pEvent->timestamp >= end)
+		{
+			break;
+		};
+
+		uint64_t offset = pEvent->timestamp > start ? (pEvent->timestamp - start) * cycles / (end - start) : 0;
+		while (executed < offset)
+		{
+			executed += interpreter.Execute(static_cast<uint32_t>(offset - executed));
+		};
+
+		Apply(interpreter, *pEvent, pMovie);
+		InputEvent consumed;
+		m_events.TryPop(consumed);
+	};
+
+	while (executed < cycles)
+	{
+		executed += interpreter.Execute(cycles - executed);
+	};
+
+	return executed;
+};
+
+/**
+	Applies every queued key change right away, for when no ticks run such as while rewinding.
+
+	@param[in] interpreter Interpreter receiving the changes.
+	@param[in] pMovie Movie recording the changes, may be null.
+ */
+void InputQueue::Flush(Interpreter& interpreter, Movie* pMovie)
+{
+	InputEvent event;
+	while (m_events.TryPop(event))
+	{
+		Apply(interpreter, event, pMovie);
+	};
+
+	m_windowEnd = Now();
+};
+
+/**
+	Retrieve the number of key changes dropped because the emulation fell behind.
+ */
+uint64_t InputQueue::GetDroppedEvents() const
+{
+	return m_droppedEvents.load(std::memory_order_relaxed);
+};
+
+/**
+	Hands a key change to the interpreter and the movie.
+ */
+void InputQueue::Apply(Interpreter& interpreter, const InputEvent& event, Movie* pMovie)
+{
+	if (event.isPressed)
+	{
+		interpreter.OnKeyPressed(event.keyIndex);
+	}
+	else
+	{
+		interpreter.OnKeyReleased(event.keyIndex);
+	};
+
+	if (pMovie != nullptr)
+	{
+		pMovie->Record(interpreter.GetCycleCount(), event.isPressed ? MovieEvent::KeyPressed : MovieEvent::KeyReleased, event.keyIndex);
+	};
+};
@@ -0,0 +1,78 @@
+#ifndef INPUTQUEUE_HPP_INCLUDED
+#define INPUTQUEUE_HPP_INCLUDED
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "Interpreter.hpp"
+#include "Movie.hpp"
+#include "Scheduler.hpp"
+#include "SpscRing.hpp"
+
+/** Key changes that can be queued between two timer ticks */
+constexpr size_t g_inputEventCapacity = 256;
+
+/**
+	A key change captured by the host.
+ */
+struct InputEvent
+{
+	/** Time the change was captured, in nanoseconds of Scheduler::Clock */
+	uint64_t timestamp;
+	/** Chip8 key index */
+	uint8_t keyIndex;
+	/** true when the key went down */
+	bool isPressed;
+};
+
+/**
+	Carries key changes from the input thread to the guest.\n
+	Changes are time stamped when they are captured and queued in a lock free
+	ring, so capturing never waits for the emulation. Before running the
+	ticks that became due the emulation closes the window of host time since
+	the previous ticks and splits it evenly over them. Every change is then
+	applied at the guest cycle matching its place in that window, so a key
+	reaches the guest at most one tick after it was pressed and presses stay
+	in order and keep their spacing however late the ticks run.
+ */
+class InputQueue
+{
+	public:
+
+		InputQueue();
+
+		static uint64_t Now();
+
+		bool Push(uint8_t keyIndex, bool isPressed);
+
+		void BeginTicks(uint32_t ticks);
+		uint32_t ExecuteTick(Interpreter& interpreter, uint32_t cycles, Movie* pMovie = nullptr);
+		void Flush(Interpreter& interpreter, Movie* pMovie = nullptr);
+
+		uint64_t GetDroppedEvents() const;
+
+	private:
+
+		static void Apply(Interpreter& interpreter, const InputEvent& event, Movie* pMovie);
+
+	private:
+
+		/** Changes waiting for the emulation */
+		SpscRing<InputEvent, g_inputEventCapacity> m_events;
+		/** Changes dropped because the ring was full */
+		std::atomic<uint64_t> m_droppedEvents;
+
+		// Emulation thread state.
+
+		/** Host time the current window starts at */
+		uint64_t m_windowStart;
+		/** Host time the current window ends at */
+		uint64_t m_windowEnd;
+		/** Ticks sharing the current window */
+		uint32_t m_tickCount;
+		/** Ticks of the current window already executed */
+		uint32_t m_tickIndex;
+
+}; // InputQueue
+
+#endif // INPUTQUEUE_HPP_INCLUDED
@@ -0,0 +1,188 @@
+#include <cstddef>
+#include <cstring>
+#include "Instruction.hpp"
+
+/**
+	Decodes a raw opcode in to an operation and its operands.
+
+	@param[in] opcode The 16 bit opcode read from memory.
+	@param[in] platform Instruction set, opcodes of later sets are unknown to earlier ones.
+	@return The decoded instruction, Operation::Unknown if the opcode is not recognized.
+ */
+Instruction DecodeInstruction(uint16_t opcode, Platform platform)
+{
+	const bool isSuperChip = platform != Platform::Chip8;
+	const bool isXoChip = platform == Platform::XoChip;
+
+	Instruction instruction;
+	instruction.operation = Operation::Unknown;
+	instruction.x = static_cast<uint8_t>((opcode & 0x0F00) >> 8);
+	instruction.y = static_cast<uint8_t>((opcode & 0x00F0) >> 4);
+	instruction.n = static_cast<uint8_t>(opcode & 0x000F);
+	instruction.kk = static_cast<uint8_t>(opcode & 0x00FF);
+	instruction.nnn = opcode & 0x0FFF;
+	instruction.opcode = opcode;
+
+	switch (opcode & 0xF000)
+	{
+		case 0x0000:
+			if (opcode == 0x00E0)
+			{
+				instruction.operation = Operation::Op00E0;
+			}
+			else if (opcode == 0x00EE)
+			{
+				instruction.operation = Operation::Op00EE;
+			}
+			else if (isSuperChip && (opcode & 0xFFF0) == 0x00C0)
+			{
+				instruction.operation = Operation::Op00Cn;
+			}
+			else if (isXoChip && (opcode & 0xFFF0) == 0x00D0)
+			{
+				instruction.operation = Operation::Op00Dn;
+			}
+			else if (isSuperChip)
+			{
+				switch (opcode)
+				{
+					case 0x00FB: instruction.operation = Operation::Op00FB; break;
+					case 0x00FC: instruction.operation = Operation::Op00FC; break;
+					case 0x00FD: instruction.operation = Operation::Op00FD; break;
+					case 0x00FE: instruction.operation = Operation::Op00FE; break;
+					case 0x00FF: instruction.operation = Operation::Op00FF; break;
+				};
+			};
+			break;
+
+		case 0x1000: instruction.operation = Operation::Op1nnn; break;
+		case 0x2000: instruction.operation = Operation::Op2nnn; break;
+		case 0x3000: instruction.operation = Operation::Op3xkk; break;
+		case 0x4000: instruction.operation = Operation::Op4xkk; break;
+
+		case 0x5000:
+			if (instruction.n == 0x0)
+			{
+				instruction.operation = Operation::Op5xy0;
+			}
+			else if (isXoChip && instruction.n == 0x2)
+			{
+				instruction.operation = Operation::Op5xy2;
+			}
+			else if (isXoChip && instruction.n == 0x3)
+			{
+				instruction.operation = Operation::Op5xy3;
+			};
+			break;
+
+		case 0x6000: instruction.operation = Operation::Op6xkk; break;
+		case 0x7000: instruction.operation = Operation::Op7xkk; break;
+
+		case 0x8000:
+			switch (instruction.n)
+			{
+				case 0x0: instruction.operation = Operation::Op8xy0; break;
+				case 0x1: instruction.operation = Operation::Op8xy1; break;
+				case 0x2: instruction.operation = Operation::Op8xy2; break;
+				case 0x3: instruction.operation = Operation::Op8xy3; break;
+				case 0x4: instruction.operation = Operation::Op8xy4; break;
+				case 0x5: instruction.operation = Operation::Op8xy5; break;
+				case 0x6: instruction.operation = Operation::Op8xy6; break;
+				case 0x7: instruction.operation = Operation::Op8xy7; break;
+				case 0xE: instruction.operation = Operation::Op8xyE; break;
+			};
+			break;
+
+		case 0x9000:
+			if (instruction.n == 0x0)
+			{
+				instruction.operation = Operation::Op9xy0;
+			};
+			break;
+
+		case 0xA000: instruction.operation = Operation::OpAnnn; break;
+		case 0xB000: instruction.operation = Operation::OpBnnn; break;
+		case 0xC000: instruction.operation = Operation::OpCxkk; break;
+		case 0xD000: instruction.operation = Operation::OpDxyn; break;
+
+		case 0xE000:
+			switch (instruction.kk)
+			{
+				case 0x9E: instruction.operation = Operation::OpEx9E; break;
+				case 0xA1: instruction.operation = Operation::OpExA1; break;
+			};
+			break;
+
+		case 0xF000:
+			switch (instruction.kk)
+			{
+				case 0x07: instruction.operation = Operation::OpFx07; break;
+				case 0x0A: instruction.operation = Operation::OpFx0A; break;
+				case 0x15: instruction.operation = Operation::OpFx15; break;
+				case 0x18: instruction.operation = Operation::OpFx18; break;
+				case 0x1E: instruction.operation = Operation::OpFx1E; break;
+				case 0x29: instruction.operation = Operation::OpFx29; break;
+				case 0x33: instruction.operation = Operation::OpFx33; break;
+				case 0x55: instruction.operation = Operation::OpFx55; break;
+				case 0x65: instruction.operation = Operation::OpFx65; break;
+				case 0x30: instruction.operation = isSuperChip ? Operation::OpFx30 : Operation::Unknown; break;
+				case 0x75: instruction.operation = isSuperChip ? Operation::OpFx75 : Operation::Unknown; break;
+				case 0x85: instruction.operation = isSuperChip ? Operation::OpFx85 : Operation::Unknown; break;
+				case 0x3A: instruction.operation = isXoChip ? Operation::OpFx3A : Operation::Unknown; break;
+				case 0x01: instruction.operation = isXoChip ? Operation::OpFn01 : Operation::Unknown; break;
+				case 0x00: instruction.operation = isXoChip && opcode == 0xF000 ? Operation::OpF000 : Operation::Unknown; break;
+				case 0x02: instruction.operation = isXoChip && opcode == 0xF002 ? Operation::OpF002 : Operation::Unknown; break;
+			};
+			break;
+	};
+
+	return instruction;
+};
+
+/**
+	Retrieve the opcode pattern of an operation, for example "8xy4".
+
+	@param[in] operation Operation to name.
+	@return Name of the operation, "Unknown" for anything out of range.
+ */
+const char* GetOperationName(Operation operation)
+{
+	// Ordered like the Operation enum.
+	static const char* const s_names[] =
+	{
+		"Undecoded", "Unknown",
+		"00Cn", "00Dn", "00E0", "00EE", "00FB", "00FC", "00FD", "00FE", "00FF",
+		"1nnn", "2nnn", "3xkk", "4xkk", "5xy0", "5xy2", "5xy3", "6xkk", "7xkk",
+		"8xy0", "8xy1", "8xy2", "8xy3", "8xy4", "8xy5", "8xy6", "8xy7", "8xyE",
+		"9xy0", "Annn", "Bnnn", "Cxkk", "Dxyn", "Ex9E", "ExA1",
+		"F000", "Fn01", "F002", "Fx07", "Fx0A", "Fx15", "Fx18", "Fx1E", "Fx29", "Fx30", "Fx33", "Fx3A",
+		"Fx55", "Fx65", "Fx75", "Fx85"
+	};
+	static_assert(sizeof(s_names) / sizeof(s_names[0]) == static_cast<size_t>(Operation::Count), "Operation names out of sync with the enum");
+
+	size_t index = static_cast<size_t>(operation);
+	return index < static_cast<size_t>(Operation::Count) ? s_names[index] : "Unknown";
+};
+
+/**
+	Looks up a platform by its command line name, chip8, schip or xochip.
+
+	@param[in] pName Name of the platform.
+	@param[out] platform The platform, untouched if the name is unknown.
+	@return false if there is no platform with that name.
+ */
+bool FindPlatform(const char* pName, Platform& platform)
+{
+	static const char* const s_names[] = { "chip8", "schip", "xochip" };
+
+	for (size_t i = 0; i < sizeof(s_names) / sizeof(s_names[0]); i++)
+	{
+		if (std::strcmp(s_names[i], pName) == 0)
+		{
+			platform = static_cast<Platform>(i);
+			return true;
+		};
+	};
+
+	return false;
+};
@@ -0,0 +1,106 @@
+#ifndef INSTRUCTION_HPP_INCLUDED
+#define INSTRUCTION_HPP_INCLUDED
+#pragma once
+
+#include <cstdint>
+
+/**
+	Instruction set variants.
+		Chip8 - The original instruction set, 4K of memory.
+		SuperChip - SUPER-CHIP 1.1, adds a 128 x 64 mode, 16 x 16 sprites, scrolling and a large font.
+		XoChip - XO-CHIP, adds 64K of memory, two bit planes and a sample pattern for the beeper on top of SUPER-CHIP.
+ */
+enum class Platform : uint8_t
+{
+	Chip8,
+	SuperChip,
+	XoChip
+};
+
+/**
+	Every operation the Chip8 instruction set knows about.
+	Operations are named after the opcode pattern they are decoded from.
+ */
+enum class Operation : uint8_t
+{
+	Undecoded,	///< Cache entry that has not been decoded yet
+	Unknown,	///< Opcode without a known meaning, executed as a no-op
+	Op00Cn,		///< Scroll down n rows (SUPER-CHIP)
+	Op00Dn,		///< Scroll up n rows (XO-CHIP)
+	Op00E0,		///< Clear the display
+	Op00EE,		///< Return from subroutine
+	Op00FB,		///< Scroll right 4 pixels (SUPER-CHIP)
+	Op00FC,		///< Scroll left 4 pixels (SUPER-CHIP)
+	Op00FD,		///< Exit the interpreter (SUPER-CHIP)
+	Op00FE,		///< Low resolution (SUPER-CHIP)
+	Op00FF,		///< High resolution (SUPER-CHIP)
+	Op1nnn,		///< Jump to nnn
+	Op2nnn,		///< Call subroutine at nnn
+	Op3xkk,		///< Skip if Vx == kk
+	Op4xkk,		///< Skip if Vx != kk
+	Op5xy0,		///< Skip if Vx == Vy
+	Op5xy2,		///< Store Vx through Vy at I (XO-CHIP)
+	Op5xy3,		///< Load Vx through Vy from I (XO-CHIP)
+	Op6xkk,		///< Vx = kk
+	Op7xkk,		///< Vx += kk
+	Op8xy0,		///< Vx = Vy
+	Op8xy1,		///< Vx |= Vy
+	Op8xy2,		///< Vx &= Vy
+	Op8xy3,		///< Vx ^= Vy
+	Op8xy4,		///< Vx += Vy, VF = carry
+	Op8xy5,		///< Vx -= Vy, VF = NOT borrow
+	Op8xy6,		///< Vx >>= 1, VF = shifted out bit
+	Op8xy7,		///< Vx = Vy - Vx, VF = NOT borrow
+	Op8xyE,		///< Vx <<= 1, VF = shifted out bit
+	Op9xy0,		///< Skip if Vx != Vy
+	OpAnnn,		///< I = nnn
+	OpBnnn,		///< Jump to nnn + V0
+	OpCxkk,		///< Vx = random AND kk
+	OpDxyn,		///< Draw sprite
+	OpEx9E,		///< Skip if key Vx is pressed
+	OpExA1,		///< Skip if key Vx is released
+	OpF000,		///< I = the following 16 bit word (XO-CHIP)
+	OpFn01,		///< Select bit planes n (XO-CHIP)
+	OpF002,		///< Load the 16 byte audio pattern from I (XO-CHIP)
+	OpFx07,		///< Vx = delay timer
+	OpFx0A,		///< Wait for key press, store in Vx
+	OpFx15,		///< Delay timer = Vx
+	OpFx18,		///< Sound timer = Vx
+	OpFx1E,		///< I += Vx
+	OpFx29,		///< I = font sprite for Vx
+	OpFx30,		///< I = large font sprite for Vx (SUPER-CHIP)
+	OpFx33,		///< Store BCD of Vx at I
+	OpFx3A,		///< Audio pattern pitch = Vx (XO-CHIP)
+	OpFx55,		///< Store V0 through Vx at I
+	OpFx65,		///< Load V0 through Vx from I
+	OpFx75,		///< Store V0 through Vx in the flag registers (SUPER-CHIP)
+	OpFx85,		///< Load V0 through Vx from the flag registers (SUPER-CHIP)
+	Count
+};
+
+/**
+	A Chip8 instruction with all of its operands extracted.
+ */
+struct Instruction
+{
+	/** Decoded operation */
+	Operation operation;
+	/** Register index from the second nibble */
+	uint8_t x;
+	/** Register index from the third nibble */
+	uint8_t y;
+	/** Lowest nibble */
+	uint8_t n;
+	/** Lowest byte */
+	uint8_t kk;
+	/** Lowest 12 bits, used as an address */
+	uint16_t nnn;
+	/** The raw opcode */
+	uint16_t opcode;
+};
+
+Instruction DecodeInstruction(uint16_t opcode, Platform platform = Platform::Chip8);
+const char* GetOperationName(Operation operation);
+bool FindPlatform(const char* pName, Platform& platform);
+
+#endif // INSTRUCTION_HPP_INCLUDED
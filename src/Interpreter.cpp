@@ -1,31 +1,82 @@
+#include <algorithm>
+#include <cstdio>
 #include <cstdlib>
-#include <ctime>
+#include <cstring>
 #include <string>
-#include <SDL_keycode.h>
+#include "AotEngine.hpp"
 #include "Interpreter.hpp"
+#include "Recompiler.hpp"
+#include "RomAnalyzer.hpp"
+#include "RomCache.hpp"
+#if CHIP8_PROFILER
+#include "Profiler.hpp"
+#endif
 
-#define GetRegister(opcode) ( (opcode & 0x0F00) >> 8 )
+/**
+    Chip8 fontset, sprites for the hexadecimal digits '0' through 'F'.
+ */
+const std::array<uint8_t, g_chipFontsetSize> g_chipFontset =
+{
+    0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
+    0x20, 0x60, 0x20, 0x20, 0x70, // 1
+    0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
+    0xF0, 0x10, 0xF0, 0x10, 0xF0, // 3
+    0x90, 0x90, 0xF0, 0x10, 0x10, // 4
+    0xF0, 0x80, 0xF0, 0x10, 0xF0, // 5
+    0xF0, 0x80, 0xF0, 0x90, 0xF0, // 6
+    0xF0, 0x10, 0x20, 0x40, 0x40, // 7
+    0xF0, 0x90, 0xF0, 0x90, 0xF0, // 8
+    0xF0, 0x90, 0xF0, 0x10, 0xF0, // 9
+    0xF0, 0x90, 0xF0, 0x90, 0x90, // A
+    0xE0, 0x90, 0xE0, 0x90, 0xE0, // B
+    0xF0, 0x80, 0x80, 0x80, 0xF0, // C
+    0xE0, 0x90, 0x90, 0x90, 0xE0, // D
+    0xF0, 0x80, 0xF0, 0x80, 0xF0, // E
+    0xF0, 0x80, 0xF0, 0x80, 0x80  // F
+};
+
+/**
+    SUPER-CHIP large fontset, 8 x 10 pixel sprites for '0' through '9', XO-CHIP adds 'A' through 'F'.
+ */
+const std::array<uint8_t, g_chipBigFontsetSize> g_chipBigFontset =
+{
+    0xFF, 0xFF, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, // 0
+    0x18, 0x78, 0x78, 0x18, 0x18, 0x18, 0x18, 0x18, 0xFF, 0xFF, // 1
+    0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // 2
+    0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 3
+    0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0x03, 0x03, // 4
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 5
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, // 6
+    0xFF, 0xFF, 0x03, 0x03, 0x06, 0x0C, 0x18, 0x18, 0x18, 0x18, // 7
+    0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, // 8
+    0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 9
+    0x7E, 0xFF, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, // A
+    0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, // B
+    0x3C, 0xFF, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0xFF, 0x3C, // C
+    0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC, // D
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // E
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0  // F
+};
 
 /**
     Default Constructor
  */
-Interpreter::Interpreter() : m_delayTimer(0x00), m_soundTimer(0x00), m_stackPointer(0xFF), m_screenSize(ScreenSize::Chip8), m_programCounter(0x0200), m_I(0x0000)
+Interpreter::Interpreter() : m_delayTimer(0x00), m_soundTimer(0x00), m_stackPointer(0xFF), m_screenSize(ScreenSize::Chip8), m_platform(Platform::Chip8), m_addressMask(g_chipAddressMask), m_quirkProfile(QuirkProfile::Default), m_getHandler(nullptr), m_romHash(0), m_programCounter(0x0200), m_I(0x0000), m_pitch(g_xoDefaultPitch), m_cycleCount(0), m_idleCycleCount(0), m_isSkippingIdle(false), m_random(g_defaultRandomSeed), m_pSoundListener(nullptr)
 {
-    /**
-        Initialize the screen buffer
-     */
-    m_pScreenBuffer.reset();
-	
 	/**
 		Zero all bits in arrays
 	*/
-	m_memory.fill(0x00);
+	m_memory.assign(g_chipRamSize, 0x00);
 	m_registerV.fill(0x00);
 	m_fontset.fill(0x00);
 	m_stack.fill(0x0000);
-    
-    // Initializr std::rand()
-    std::srand(std::time(nullptr));
+	m_flagRegisters.fill(0x00);
+	m_audioPattern.fill(0x00);
+	BindQuirks(QuirkProfile::Default);
+	InvalidateDecodedInstructions();
+#if CHIP8_PROFILER
+	m_pProfiler = nullptr;
+#endif
 };
 
 /**
@@ -39,12 +90,17 @@ Interpreter::~Interpreter()
     Initializes the Interpreter to open, validate and place the loaded ROM in the allocated 4K memory.
 
     @param[in] filePath Path to the ROM file to load.
-	@param[in] screenSize Size of the screen.
+	@param[in] screenSize Size of the screen, SUPER-CHIP and XO-CHIP start in 64 x 32 whatever is given.
+	@param[in] platform Instruction set to emulate.
     @return true or false depending on initialization of emulator RAM and loading of the ROM
  */
-bool Interpreter::Initialize(const char* filePath, ScreenSize screenSize)
+bool Interpreter::Initialize(const char* filePath, ScreenSize screenSize, Platform platform)
 {
-	m_screenSize = screenSize;
+	m_screenSize = platform == Platform::Chip8 ? screenSize : ScreenSize::Chip8;
+	SetPlatform(platform);
+	m_flagRegisters.fill(0x00);
+	m_audioPattern.fill(0x00);
+	m_pitch = g_xoDefaultPitch;
 
     if (!InitializeEmulatorRAM())
     {
@@ -69,471 +125,426 @@ bool Interpreter::Initialize(const char* filePath, ScreenSize screenSize)
         printf("Error: Failed to open and load requested file!\n");
         return false;
     };
+
+    // Handlers are picked per ROM, so they have to be bound before anything is decoded.
+    BindQuirks(QuirkDatabase::GetInstance().Find(m_romHash, platform));
+
+    // Memory was rewritten, nothing decoded so far is valid.
+    InvalidateDecodedInstructions();
+    if (m_pRecompiler)
+    {
+        m_pRecompiler->Flush();
+    };
+    BindAotProgram();
     
     return true;
 };
 
 /**
-    Runs the interpreter.
+    Runs the interpreter for a number of instructions without any throttling.\n
+    The timers are left alone, see TickTimers(). With idle skipping on, the
+    iterations of a wait loop are counted without being executed.
+
+    @param[in] cycles Number of instructions to execute.
+    @return Number of instructions executed.
  */
-void Interpreter::Run()
+uint32_t Interpreter::Execute(uint32_t cycles)
 {
-    uint16_t opcode = (m_memory[m_programCounter] << 8 | m_memory[m_programCounter + 1]);
-    uint16_t pc = m_programCounter + g_chipInstructionSize;
-    
-    switch (opcode & 0xF000) {
-            
-        case 0x000:
-            
-            switch (opcode & 0x000F)
-            {
-                    
-                /**
-                    0x0000\n
-                        Clear the display.
-                */
-                case 0x0000:
-                {
-                    uint16_t pixels = GetEmulatorWidth() * GetEmulatorHeight();
-                    std::fill(
-                              m_pScreenBuffer.get(),
-                              m_pScreenBuffer.get() + pixels,
-                              0x00);
-                }
-                    break;
-                    
-                /**
-                    0x000E\n
-                        Return from subroutine.
-                */
-                case 0x000E:
-                    pc = m_stack[m_stackPointer] + g_chipInstructionSize;
-                    m_stackPointer--;
-                    break;
-            };
-            break;
+    if (!m_isSkippingIdle)
+    {
+        return ExecuteBackend(cycles);
+    };
 
-			/**
-				1nnn\n
-					Jump to location nnn.
-			 */
-        case 0x1000:
-			pc = opcode & 0x0FFF;
-			break;
+    // The first iteration after a timer tick or key change still loads the new
+    // values, so the first check after a miss comes one loop length later.
+    uint32_t executed = 0;
+    uint32_t checkCycles = g_idleMaxLoopLength;
+    while (executed < cycles)
+    {
+        uint32_t remaining = cycles - executed;
+        uint32_t loopLength = FindIdleLoop();
+        if (loopLength > 0)
+        {
+            // Whole iterations leave the state as it is, only the rest has to run.
+            uint32_t skipped = remaining - remaining % loopLength;
+            m_cycleCount += skipped;
+            m_idleCycleCount += skipped;
+            return executed + skipped + ExecuteBackend(remaining - skipped);
+        };
 
-			/**
-				2nnn:
-					Call subroutine at nnn.
-			 */
-		case 0x2000:
-			m_stackPointer++;
-			m_stack[m_stackPointer] = m_programCounter;
-			pc = (opcode & 0x0FFF);
-			break;
+        executed += ExecuteBackend(remaining < checkCycles ? remaining : checkCycles);
+        checkCycles = g_idleCheckCycles;
+    };
 
-			/**
-				3xkk\n
-					Compare register x to kk, if equal increment program counter by 2
-			 */
-		case 0x3000:
-			pc += m_registerV[GetRegister(opcode)] == (opcode & 0x00FF) ? g_chipInstructionSize : 0;
-			break;
+    return executed;
+};
 
-			/**
-				4xkk\n
-					Compare register x to kk, is not equal increment program counter by 2
-			 */
-		case 0x4000:
-			pc += m_registerV[GetRegister(opcode)] != (opcode & 0x00FF) ? g_chipInstructionSize : 0;
-			break;
+/**
+    Runs the backend selected with SetBackend().
 
-			/**
-				5xy0\n
-					Compare register x and y, if x and y is equal increment program counter by 2
-			 */
-		case 0x5000:
-			pc += m_registerV[(opcode & 0x0F00) >> 8] == m_registerV[(opcode & 0x00F0 >> 4)] ? g_chipInstructionSize : 0;
-			break;
+    @param[in] cycles Number of instructions to execute.
+    @return Number of instructions executed.
+ */
+uint32_t Interpreter::ExecuteBackend(uint32_t cycles)
+{
+#if CHIP8_PROFILER
+    // The profiler sees every instruction, which only the single step path allows.
+    if (m_pProfiler != nullptr)
+    {
+        for (uint32_t i = 0; i < cycles; i++)
+        {
+            Run();
+        };
+        return cycles;
+    };
+#endif
 
-			/**
-				6xkk\n
-					Store kk in register x
-			 */
-		case 0x6000:
-			m_registerV[GetRegister(opcode)] = opcode & 0x00FF;
-			break;
+    if (m_pRecompiler)
+    {
+        return m_pRecompiler->Execute(cycles);
+    };
 
-			/**
-				7xkk\n
-					Set register x to x + kk
-			 */
-		case 0x7000:
-			m_registerV[GetRegister(opcode)] += (opcode & 0x00FF);
-			break;
+    if (m_pAotEngine)
+    {
+        return m_pAotEngine->Execute(cycles);
+    };
 
-            /**
-                8xyn\n
-                    n determines which opcode we should use.
-             */
-		case 0x8000:
-            
-            switch (opcode & 0x000F)
-            {
-                    
-                    /**
-                        8xy0\n
-                            Set register Vx to Vy
-                     */
-                case 0x0000:
-                    m_registerV[(opcode & 0x0F00) >> 8] = m_registerV[(opcode & 0x00F0) >> 4];
-                    break;
-                    
-                    /**
-                        8xy1\n
-                            Set register Vx to Vx OR (|) Vy
-                     */
-                case 0x0001:
-                    m_registerV[(opcode & 0x0F00) >> 8] |= m_registerV[(opcode & 0x00F0) >> 4];
-                    break;
-                    
-                    /**
-                        8xy2\n
-                            Set register Vx to Vx AND (&) Vy
-                     */
-                case 0x0002:
-                    m_registerV[(opcode & 0x0F00) >> 8] &= m_registerV[(opcode & 0x00F0) >> 4];
-                    break;
-                    
-                    /**
-						8xy3\n
-                     		Set register Vx XOR Vy
-                     */
-                case 0x0003:
-                    m_registerV[(opcode & 0x0F00) >> 8] ^= m_registerV[(opcode & 0x00F0) >> 4];
-                    break;
-                    
-                    /**
-                        8xy4\n
-                            Set register Vx to Vx + Vy.
-                            VF is set to carry
-                            Set register VF to carry (Vx + Vy > 255, carry is equal to 1 otherwise 0)
-                     */
-                case 0x0004:
-                    m_registerV[(opcode & 0x0F00) >> 8] += m_registerV[(opcode & 0x00F0) >> 4];
-                    m_registerV[0x0F] = m_registerV[(0x00F0) >> 4] > (0xFF - m_registerV[(0x0F00 & opcode) >> 8]);
-                    break;
-                
-                    /**
-                        8xy5\n
-                            Set register Vx to Vx - Vy
-                            VF is set to NOT borrow
-                     */
-                case 0x0005:
-                    m_registerV[0x0F] = m_registerV[(opcode & 0x0F00) >> 8] > m_registerV[(opcode & 0x00F0) >> 4] ? 0x01 : 0x00;
-                    m_registerV[(opcode & 0x0F00) >> 8] -= m_registerV[(opcode & 0x00F0) >> 4];
-                    break;
-                    
-                    /**
-                        8xy6\n
-                            If the last bit of Vx is 1 set VF  to 1, otherwise 0.
-                            Divide register Vx by two.
-                     */
-                case 0x0006:
-                    m_registerV[0x0F] = m_registerV[(opcode & 0x0F00) >> 8] & 0x01;
-                    m_registerV[(opcode & 0x0F00) >> 8] >>= 1;
-                    break;
-                    
-                    /**
-                        8xy7\n
-                            Set register Vx to Vx - Vy.
-                            If Vy is greater than Vx set VF to 1, otherwise 0.
-                            Register VF is set to NOT BORROW.
-                     */
-                case 0x0007:
-                    m_registerV[0x0F] = m_registerV[(opcode & 0x00F0) >> 4] > m_registerV[(0x0F00) >> 8] ? 0x01 : 0x00;
-                    m_registerV[(opcode & 0x0F00) >> 8] = m_registerV[(opcode & 0x00F0) >> 4] - m_registerV[(opcode & 0x0F00) >> 8];
-                    break;
-                    
-                    /**
-                        8xyE\n
-                            Check if most-significant bit is 1, if so set VF to 1 otherwise 0.
-                            Multiply register Vx by 2.
-                     */
-                case 0x000E:
-                    m_registerV[0x0F] = m_registerV[(opcode & 0x0F00) >> 8] & 0x80 ? 0x01 : 0x00;
-                    m_registerV[(opcode & 0x0F00) >> 8] <<= 1;
-                    break;
-            }
-            
-			break;
+    return ExecuteInterpreted(cycles);
+};
 
-			/**
-				9xy0\n
-					Skip next instruction if register x is equal to register y
-			 */
-		case 0x9000:
-			pc += m_registerV[(opcode & 0x0F00) >> 8] != m_registerV[(opcode & 0x00F0) >> 4] ? g_chipInstructionSize : 0;
-			break;
+/**
+    Checks whether the program counter is at the start of a wait loop.\n
+    A wait loop only loads constants and the delay timer, compares them
+    and jumps back, like Fx07 3xkk 1nnn, or is an Fx0A with no key pressed.
+    Neither the timers nor the keys change during Execute(), so once an
+    iteration ends in the state it started from every further one does too.
 
-			/**
-				Annn\n
-					Set I to nnn
-					Program counter is set to value nnn
-			 */
-		case 0xA000:
-			m_I = opcode & 0x0FFF;
-			break;
-            
-            /**
-                Bnnn\n
-                    Set program counter to nnn + value of register V0.
-             */
-        case 0xB000:
-            pc = (opcode & 0x0FFF) + m_registerV[0x00];
-            break;
-            
-            /**
-                Cxkk\n
-                    Set Vx to random byte AND kk
-             */
-        case 0xC000:
-            m_registerV[(opcode & 0x0F00) >> 8] = (std::rand() % 255) + (opcode & 0x00FF);
-            break;
+    @return Number of instructions in the loop, 0 if not in a wait loop.
+ */
+uint32_t Interpreter::FindIdleLoop() const
+{
+#if CHIP8_PROFILER
+    // Skipped instructions would be missing from the profile.
+    if (m_pProfiler != nullptr)
+    {
+        return 0;
+    };
+#endif
 
-			/**
-				Dxyn\n
-					Display n-byte sprite starting at location of I
-					x - positionX from Vx
-					y - positionY from Vy
-					n - read n bytes from memory also used as height
-			 */
-		case 0xD000:
+    std::array<uint8_t, g_chipRegisterBankSize> registers = m_registerV;
+    uint16_t index = m_I;
+    uint16_t programCounter = m_programCounter;
+    for (uint32_t length = 1; length <= g_idleMaxLoopLength; length++)
+    {
+        uint16_t address = programCounter & g_chipAddressMask;
+        programCounter = address + g_chipInstructionSize;
+
+        Instruction instruction = DecodeAt(address).instruction;
+        bool isSkipped = false;
+        switch (instruction.operation)
         {
-            uint16_t posX = m_registerV[(opcode & 0x0F00) >> 8];
-            uint16_t posY = m_registerV[(opcode & 0x00F0) >> 4];
-            uint16_t width = GetEmulatorWidth();
-            uint16_t height = opcode & 0x000F;
-            uint16_t pixel;
-            
-            // Set register 15 (0x0F) to 0 for no collision detected.
-            m_registerV[0x0F] = 0;
-            for(uint16_t y = 0; y < height; y++)
-            {
-                
-                // Get start address
-                pixel = m_memory[m_I + y];
-                for(uint16_t x = 0; x < 8; x++)     // 8-bits is the maximum width of a sprite
+            case Operation::Op1nnn: programCounter = instruction.nnn; break;
+            case Operation::Op3xkk: isSkipped = registers[instruction.x] == instruction.kk; break;
+            case Operation::Op4xkk: isSkipped = registers[instruction.x] != instruction.kk; break;
+            case Operation::Op5xy0: isSkipped = registers[instruction.x] == registers[instruction.y]; break;
+            case Operation::Op9xy0: isSkipped = registers[instruction.x] != registers[instruction.y]; break;
+            case Operation::OpEx9E: isSkipped = m_keyboard[registers[instruction.x] & 0x0F] != 0; break;
+            case Operation::OpExA1: isSkipped = m_keyboard[registers[instruction.x] & 0x0F] == 0; break;
+            case Operation::Op6xkk: registers[instruction.x] = instruction.kk; break;
+            case Operation::OpAnnn: index = instruction.nnn; break;
+            case Operation::OpFx07: registers[instruction.x] = m_delayTimer; break;
+            case Operation::OpFx0A:
+                if (std::find(m_keyboard.begin(), m_keyboard.end(), 0x01) != m_keyboard.end())
                 {
-                    
-                    if((pixel & (0x80 >> x)) != 0)
-                    {
-                        
-                        // Did we collide with something?
-                        if(m_pScreenBuffer[(posX + x + ((posY + y) * width))] == 1)
-                        {
-                            m_registerV[0x0F] = 0x01;
-                        };
-                        
-                        m_pScreenBuffer[posX + x + ((posY + y) * width)] ^= 1;
-                    };
+                    return 0;
                 };
-            };
-        }
-            break;
+                programCounter -= g_chipInstructionSize;
+                break;
+            case Operation::Unknown: break;
+            default: return 0;
+        };
 
-			/**
-				E000\n
-					Handle input.
-			*/
-		case 0xE000:
-			
-			switch (opcode & 0x00FF)
-			{
-					/**
-						Ex9E\n
-							Skip next instruction if the key with value Vx is pressed.
-					*/
-				case 0x009E:
-                    pc += m_keyboard[m_registerV[(opcode & 0x0F00) >> 8]] != 0 ? g_chipInstructionSize : 0;
-					break;
-
-					/**
-						ExA1\n
-							Skip the next instruction if the key with value Vx is released.
-					*/
-				case 0x00A1:
-                    pc += m_keyboard[m_registerV[(opcode & 0x0F00) >> 8]] == 0 ? g_chipInstructionSize : 0;
-					break;
-			}
-			break;
-            
-            /**
-                FxII\n
-                    Two last nibbles are used to determine which instruction to use.
-             */
-        case 0xF000:
-            
-            switch (opcode & 0x00FF)
-            {
-                    
-                    /**
-                        Fx007\n
-                            Store delay timer in register Vx.
-                     */
-                case 0x0007:
-                    m_registerV[(opcode & 0x0F00) >> 8] = m_delayTimer;
-                    break;
-                    
-                    /**
-                        Fx0A\n
-                            Wait for a key press and then store it in register Vx.
-                     */
-                case 0x000A:
-                {
-                    // A check for if we've pressed a key.
-                    bool isKeyPressed = false;
-                    
-                    // Look for the pressed key.
-                    for (int i = 0; i < g_chipKeyboardSize; i++)
-                    {
-                        // Check if the key is pressed.
-                        if (m_keyboard[i] == 0x01)
-                        {
-                            // Store in register Vxz®
-                            m_registerV[(opcode & 0x0F00) >> 8] = i;
-                            isKeyPressed = true; // Say that we've pressed the key.
-                        };
-                    };
-                    
-                    // Break the loop until we've pressed a key.
-                    if (!isKeyPressed)
-                    {
-                        return;
-                    };
-                };
-                    break;
-                    
-                    /**
-                        Fx15\n
-                            Set delay timer to x.
-                     */
-                case 0x0015:
-                    m_delayTimer = ((opcode & 0x0F00) >> 8);
-                    break;
-                    
-                    /**
-                        Fx18\n
-                            Set sound timer to x.
-                     */
-                case 0x0018:
-                    m_soundTimer = ((opcode & 0x0F00) >> 8);
-                    break;
-                    
-                    /**
-                        Fx1E\n
-                            Set I to I + register Vx.
-                     */
-                case 0x001E:
-                    m_I += m_registerV[(opcode & 0x0F00) >> 8];
-                    break;
-                    
-                    /**
-                        Fx29\n
-                            Set I to corresponding sprite for digit at Vx.
-                     */
-                case 0x0029:
-                    // Multiply value by five (5) since a font sprite has a length of five (5).
-					m_I = m_registerV[(opcode & 0x0F00) >> 8] * 5;
-                    break;
-                    
-                    /**
-                        Fx33\n
-                            Store the BCD (Binary Coded Decimal) of Vx in memory location starting at I.\n
-                            I = one hundredth digit of Vx \n
-                            I + 1 = one tenth digit of Vx \n
-                            I + 2 = one digit of Vx \n
-                     */
-                case 0x0033:
-                {
-                    uint16_t value = m_registerV[(opcode & 0x0F00) >> 8];
-                    m_memory[m_I] = (value / 100) % 10;
-                    m_memory[m_I + 1] = (value / 10) % 10;
-                    m_memory[m_I + 2] = value % 10;
-                }
-                    break;
-
-					/**
-						Fx55\n
-							Load register V0 through Vx in to memory.
-					 */
-				case 0x0055:
-					{
-						for (uint8_t i = 0; i < ((opcode & 0x0F00) >> 8); i++)
-						{
-							m_memory[m_I + i] = m_registerV[i];
-						};
-					};
-					break;
-                    
-                    /**
-                        Fx65\n
-                            Reads registers V0 to Vx from memory starting at I.
-                     */
-                case 0x0065:
-                    for (int i = 0; i < ((opcode & 0x0F00) >> 8); i++)
-                    {
-                        m_registerV[i] = m_memory[m_I + i];
-                    };
-                    break;
-            };
-            break;
+        if (isSkipped)
+        {
+            programCounter += GetSkipSize(programCounter);
+        };
 
-		default:
-			printf("Unknown");
-			break;
+        if (programCounter == m_programCounter && index == m_I && registers == m_registerV)
+        {
+            return length;
+        };
     };
-    m_programCounter = pc;
-    
-    // Subtract one from the delay timer.
-    // (Should be at a rate of 1 per 60Hz)
+
+    return 0;
+};
+
+/**
+    Runs the interpreter engine picked at build time, bypassing every other backend.
+
+    @param[in] cycles Number of instructions to execute.
+    @return Number of instructions executed.
+ */
+uint32_t Interpreter::ExecuteInterpreted(uint32_t cycles)
+{
+#if CHIP8_THREADED_DISPATCH
+    return (this->*m_executeThreaded)(cycles);
+#else
+    for (uint32_t i = 0; i < cycles; i++)
+    {
+        Run();
+    };
+
+    return cycles;
+#endif
+};
+
+/**
+    Runs the interpreter for a single instruction.
+ */
+void Interpreter::Run()
+{
+    Dispatch();
+    m_cycleCount++;
+};
+
+/**
+    Executes the instruction at the program counter.\n
+    Instructions are decoded once and kept in m_decodedInstructions until
+    the memory they were decoded from is written to.
+ */
+void Interpreter::Dispatch()
+{
+    uint16_t address = m_programCounter & g_chipAddressMask;
+    m_programCounter = address + g_chipInstructionSize;
+
+#if CHIP8_PROFILER
+    if (m_pProfiler != nullptr)
+    {
+        m_pProfiler->OnInstruction(address, DecodeAt(address).instruction);
+    };
+#endif
+
+    if ((address & 0x0001) == 0)
+    {
+        const DecodedInstruction& decoded = m_decodedInstructions[address >> 1];
+        (this->*decoded.handler)(decoded.instruction);
+    }
+    else
+    {
+        // Instructions on odd addresses are rare, decode them every time.
+        DecodedInstruction decoded = DecodeAt(address);
+        (this->*decoded.handler)(decoded.instruction);
+    };
+};
+
+/**
+    Counts the delay and sound timers down by one.\n
+    Called by the front end 60 times per second of guest time, independent
+    of how many instructions were executed in between.
+ */
+void Interpreter::TickTimers()
+{
     if (m_delayTimer > 0)
     {
-        --m_delayTimer;
+        m_delayTimer--;
     };
     
-    // Subtract one from the sound timer.
-    // (Should be at a rate of 1 per 60Hz)
     if (m_soundTimer > 0)
     {
-        if (m_soundTimer == 1)
-        {
-            // TODO: Implement audio beep here.
-        };
-        --m_soundTimer;
+        SetSoundTimer(m_soundTimer - 1);
     };
 };
 
 /**
-    Draw pixels to the screen
- 
-    @param[in] pScreen An array of all pixels available on the screen passed.
-    @param[in] windowWidth Width of the window
-    @param[in] windowHeight Height of the window
+    Retrieve whether the beeper sounds, which it does while the sound timer is non zero.
  */
-void Interpreter::Draw(uint32_t* pScreen, uint32_t windowWidth, uint32_t windowHeight)
+bool Interpreter::IsSoundActive() const
 {
-    // Get screen width.
-    uint16_t screenWidth = GetEmulatorWidth();
-    
-    for(uint16_t y = 0; y < windowHeight; y++)
+    return m_soundTimer > 0;
+};
+
+/**
+    Sets the object told about the beeper turning on and off.
+
+    @param[in] pListener Listener, null to stop notifying. Must outlive the attachment.
+ */
+void Interpreter::SetSoundListener(SoundListener* pListener)
+{
+    m_pSoundListener = pListener;
+};
+
+#if CHIP8_THREADED_DISPATCH
+/**
+    Threaded dispatch engine.\n
+    Every handler jumps straight to the handler of the next instruction instead
+    of returning to a central loop. Uses computed goto on GCC and Clang and a
+    switch inside a loop on other compilers.
+
+    @param[in] cycles Number of instructions to execute.
+    @return Number of instructions executed.
+ */
+template <typename Quirks>
+uint32_t Interpreter::ExecuteThreaded(uint32_t cycles)
+{
+    uint32_t remaining = cycles;
+    const DecodedInstruction* pDecoded = nullptr;
+    DecodedInstruction oddInstruction;
+
+// Fetches the next cache entry, leaves the engine once the budget is spent.
+#define CHIP8_FETCH() \
+    { \
+        if (remaining == 0) \
+        { \
+            goto finished; \
+        }; \
+        remaining--; \
+        uint16_t address = m_programCounter & g_chipAddressMask; \
+        m_programCounter = address + g_chipInstructionSize; \
+        if ((address & 0x0001) == 0) \
+        { \
+            pDecoded = &m_decodedInstructions[address >> 1]; \
+        } \
+        else \
+        { \
+            oddInstruction = DecodeAt(address); \
+            pDecoded = &oddInstruction; \
+        }; \
+    }
+
+#if defined(__GNUC__) || defined(__clang__)
+    // Ordered like the Operation enum.
+    static void* const s_labels[] =
+    {
+        &&Undecoded, &&Unknown,
+        &&Op00Cn, &&Op00Dn, &&Op00E0, &&Op00EE, &&Op00FB, &&Op00FC, &&Op00FD, &&Op00FE, &&Op00FF,
+        &&Op1nnn, &&Op2nnn, &&Op3xkk, &&Op4xkk, &&Op5xy0, &&Op5xy2, &&Op5xy3, &&Op6xkk, &&Op7xkk,
+        &&Op8xy0, &&Op8xy1, &&Op8xy2, &&Op8xy3, &&Op8xy4, &&Op8xy5, &&Op8xy6, &&Op8xy7, &&Op8xyE,
+        &&Op9xy0, &&OpAnnn, &&OpBnnn, &&OpCxkk, &&OpDxyn, &&OpEx9E, &&OpExA1,
+        &&OpF000, &&OpFn01, &&OpF002, &&OpFx07, &&OpFx0A, &&OpFx15, &&OpFx18, &&OpFx1E, &&OpFx29, &&OpFx30, &&OpFx33, &&OpFx3A,
+        &&OpFx55, &&OpFx65, &&OpFx75, &&OpFx85
+    };
+    static_assert(sizeof(s_labels) / sizeof(s_labels[0]) == static_cast<size_t>(Operation::Count), "Label table does not match Operation");
+
+#define CHIP8_OPERATION(name) name
+#define CHIP8_JUMP() goto *s_labels[static_cast<uint8_t>(pDecoded->instruction.operation)]
+#define CHIP8_NEXT() \
+    m_cycleCount++; \
+    CHIP8_FETCH(); \
+    CHIP8_JUMP()
+
+    CHIP8_FETCH();
+    CHIP8_JUMP();
+    {
+#else
+#define CHIP8_OPERATION(name) case Operation::name
+#define CHIP8_NEXT() \
+    m_cycleCount++; \
+    continue
+
+    for (;;)
     {
-        for(uint16_t x = 0; x < windowWidth; x++)
+        CHIP8_FETCH();
+        switch (pDecoded->instruction.operation)
         {
-            // Since the window is 10 times bigger than the emulators
-            // screen we divide x and y values by to more accuratly map them.
-            pScreen[x + (windowWidth * y)] = m_pScreenBuffer[(x / 10) + (y / 10) * screenWidth] ? 0xFFFFFFFF : 0x00000000;
+            case Operation::Count:
+#endif
+            CHIP8_OPERATION(Undecoded): OpDecode(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Unknown): CHIP8_NEXT();
+            CHIP8_OPERATION(Op00Cn): Op00Cn(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op00Dn): Op00Dn(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op00E0): Op00E0(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op00EE): Op00EE(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op00FB): Op00FB(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op00FC): Op00FC(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op00FD): Op00FD(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op00FE): Op00FE(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op00FF): Op00FF(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op1nnn): Op1nnn(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op2nnn): Op2nnn(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op3xkk): Op3xkk(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op4xkk): Op4xkk(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op5xy0): Op5xy0(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op5xy2): Op5xy2(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op5xy3): Op5xy3(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op6xkk): Op6xkk(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op7xkk): Op7xkk(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op8xy0): Op8xy0(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op8xy1): Op8xy1<Quirks>(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op8xy2): Op8xy2<Quirks>(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op8xy3): Op8xy3<Quirks>(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op8xy4): Op8xy4(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op8xy5): Op8xy5(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op8xy6): Op8xy6<Quirks>(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op8xy7): Op8xy7(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op8xyE): Op8xyE<Quirks>(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(Op9xy0): Op9xy0(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(OpAnnn): OpAnnn(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(OpBnnn): OpBnnn<Quirks>(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(OpCxkk): OpCxkk(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(OpDxyn): OpDxyn<Quirks>(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(OpEx9E): OpEx9E(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(OpExA1): OpExA1(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(OpF000): OpF000(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(OpFn01): OpFn01(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(OpF002): OpF002(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(OpFx07): OpFx07(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(OpFx0A): OpFx0A(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(OpFx15): OpFx15(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(OpFx18): OpFx18(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(OpFx1E): OpFx1E(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(OpFx29): OpFx29(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(OpFx30): OpFx30(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(OpFx33): OpFx33(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(OpFx3A): OpFx3A(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(OpFx55): OpFx55<Quirks>(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(OpFx65): OpFx65<Quirks>(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(OpFx75): OpFx75(pDecoded->instruction); CHIP8_NEXT();
+            CHIP8_OPERATION(OpFx85): OpFx85(pDecoded->instruction); CHIP8_NEXT();
+#if !(defined(__GNUC__) || defined(__clang__))
         };
+#endif
     };
+
+#undef CHIP8_FETCH
+#undef CHIP8_OPERATION
+#undef CHIP8_JUMP
+#undef CHIP8_NEXT
+
+finished:
+    return cycles;
+};
+#endif // CHIP8_THREADED_DISPATCH
+
+/**
+    Retrieve the screen buffer, use a Blitter to present it.
+ */
+const Framebuffer& Interpreter::GetFramebuffer() const
+{
+    return m_framebuffer;
+};
+
+/**
+    Checks if the screen changed since the last ClearDirtyRows(), only 00E0 and Dxyn change it.
+ */
+bool Interpreter::IsFrameDirty() const
+{
+    return m_framebuffer.IsDirty();
+};
+
+/**
+    Retrieve the screen rows changed since the last ClearDirtyRows(), bit y is set for row y.
+ */
+uint64_t Interpreter::GetDirtyRows() const
+{
+    return m_framebuffer.GetDirtyRows();
+};
+
+/**
+    Call after presenting the screen to start tracking changes for the next frame.
+ */
+void Interpreter::ClearDirtyRows()
+{
+    m_framebuffer.ClearDirtyRows();
 };
 
 /**
@@ -564,20 +575,15 @@ void Interpreter::OnKeyReleased(uint8_t keyIndex)
  */
 bool Interpreter::InitializeEmulatorRAM()
 {
-    m_memory.fill(0x00);
+    std::fill(m_memory.begin(), m_memory.end(), 0x00);
     
     //  Retrieve the two higher nibbles for the width then multiply
     //  the two retrieved higher nibbles with the two lower to get
     //  the resolution of the Chip8 screen.
      
-	uint16_t pixels = (static_cast<uint16_t>(m_screenSize) >> 8) * (0x00FF & static_cast<uint16_t>(m_screenSize));
-    m_pScreenBuffer.reset(new uint8_t[pixels]);
-    std::fill(
-              m_pScreenBuffer.get(),
-              m_pScreenBuffer.get() + pixels,
-              0x00);
+    m_framebuffer.Resize(GetEmulatorWidth(), GetEmulatorHeight());
     
-    return !m_memory.empty() && m_pScreenBuffer != nullptr;
+    return !m_memory.empty();
 };
 
 /**
@@ -597,27 +603,13 @@ bool Interpreter::InitializeEmulatorKeyboard()
 bool Interpreter::InitializeFontset()
 {   
     // Insert the fonset.
-    m_fontset =
-    {
-        0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
-        0x20, 0x60, 0x20, 0x20, 0x70, // 1
-        0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
-        0xF0, 0x10, 0xF0, 0x10, 0xF0, // 3
-        0x90, 0x90, 0xF0, 0x10, 0x10, // 4
-        0xF0, 0x80, 0xF0, 0x10, 0xF0, // 5
-        0xF0, 0x80, 0xF0, 0x90, 0xF0, // 6
-        0xF0, 0x10, 0x20, 0x40, 0x40, // 7
-        0xF0, 0x90, 0xF0, 0x90, 0xF0, // 8
-        0xF0, 0x90, 0xF0, 0x10, 0xF0, // 9
-        0xF0, 0x90, 0xF0, 0x90, 0x90, // A
-        0xE0, 0x90, 0xE0, 0x90, 0xE0, // B
-        0xF0, 0x80, 0x80, 0x80, 0xF0, // C
-        0xE0, 0x90, 0x90, 0x90, 0xE0, // D
-        0xF0, 0x80, 0xF0, 0x80, 0xF0, // E
-        0xF0, 0x80, 0xF0, 0x80, 0x80  // F
-    };
+    m_fontset = g_chipFontset;
 
 	std::memcpy(&m_memory[0x00], &m_fontset[0x00], g_chipFontsetSize);
+	if (m_platform != Platform::Chip8)
+	{
+		std::memcpy(&m_memory[g_chipBigFontAddress], g_chipBigFontset.data(), g_chipBigFontsetSize);
+	};
     
     return !m_fontset.empty();
 };
@@ -636,52 +628,1311 @@ bool Interpreter::OpenAndLoadFile(const char* filePath)
         printf("File path cannot be null or empty!\n");
         return false;
     };
-    
-    std::ifstream file;
-    file.open(filePath, std::ifstream::in | std::ifstream::binary);
-    
-    if (!file.is_open())
-    {
-        printf("Failed to open %s\n", filePath);
-        return false;
-    };
-    
-    file.seekg(0, file.end);
-    size_t romSize = file.tellg();
-    if (romSize < 0 && romSize > (g_chipRamSize - 0x1FF))
+
+    // Identical ROMs are read once per process and copied from the cache.
+    RomStatus status;
+    uint32_t maxSize = m_platform == Platform::XoChip ? g_xoRomMaxSize : g_chipRomMaxSize;
+    std::shared_ptr<const Rom> pRom = RomCache::GetInstance().Load(filePath, maxSize, status);
+    switch (status)
     {
-        printf("File to large, RAM size is %u\n", g_chipRamSize);
-        file.close();
-        return false;
+        case RomStatus::Loaded:
+            break;
+
+        case RomStatus::TooLarge:
+            printf("File to large, a ROM can be at most %u bytes\n", maxSize);
+            return false;
+
+        case RomStatus::NotFound:
+            printf("Failed to open %s\n", filePath);
+            return false;
+
+        case RomStatus::ReadError:
+            printf("Failed to read %s\n", filePath);
+            return false;
     };
-    
-	uint16_t fileIndex = 0;
-    file.seekg(0, std::ifstream::beg);
 
-	// Read from file one byte at the time.
-	while (file)
+    std::copy(pRom->data.begin(), pRom->data.end(), m_memory.begin() + 0x0200);
+    m_romHash = pRom->hash;
+    return true;
+};
+
+/**
+	Selects the engine used by Execute().\n
+	The recompiler is only available on x86-64 Linux and the ahead of time
+	engine only for ROMs chip8-aot translated, the interpreter is used otherwise.
+
+	@param[in] backend Requested backend.
+	@return true if the requested backend is now in use.
+*/
+bool Interpreter::SetBackend(Backend backend)
+{
+	if (backend != Backend::Recompiler)
 	{
-		// Add bytes from byte 512 until the end of the file.
-		m_memory[0x0200 + fileIndex] = file.get();
-		fileIndex++; // Increase the index after each byte.
+		m_pRecompiler.reset();
 	};
-    file.close();
-    
-    return !file.is_open();
+
+	if (backend != Backend::Aot)
+	{
+		m_pAotEngine.reset();
+	};
+
+	if (backend == Backend::Interpreter)
+	{
+		return true;
+	};
+
+	if (backend == Backend::Aot)
+	{
+		if (!m_pAotEngine)
+		{
+			m_pAotEngine = std::make_unique<AotEngine>(*this);
+			BindAotProgram();
+		};
+
+		// Without a program for this ROM every instruction would be interpreted anyway.
+		if (m_pAotEngine->GetProgram() == nullptr)
+		{
+			m_pAotEngine.reset();
+			return false;
+		};
+
+		return true;
+	};
+
+	if (!m_pRecompiler)
+	{
+		std::unique_ptr<Recompiler> pRecompiler = std::make_unique<Recompiler>(*this);
+		if (!pRecompiler->Initialize())
+		{
+			return false;
+		};
+		m_pRecompiler = std::move(pRecompiler);
+	};
+
+	return true;
 };
 
 /**
-	Retrieve emulator screen width from screenSize
+	Retrieve the engine used by Execute().
 */
-uint16_t Interpreter::GetEmulatorWidth() const
+Backend Interpreter::GetBackend() const
 {
-	return static_cast<uint16_t>(m_screenSize) >> 8;
+	if (m_pAotEngine)
+	{
+		return Backend::Aot;
+	};
+
+	return m_pRecompiler ? Backend::Recompiler : Backend::Interpreter;
 };
 
 /**
-	Retrieve emulator screen height from screenSize
+	Computes a hash over the complete machine state.\n
+	Used to check that different backends end up in the same state.
 */
-uint16_t Interpreter::GetEmulatorHeight() const
+uint64_t Interpreter::GetStateHash() const
 {
-	return (0x00FF & static_cast<uint16_t>(m_screenSize));
+	// FNV-1a
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	auto mix = [&hash](const uint8_t* pData, size_t size)
+	{
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ pData[i]) * 0x100000001B3ULL;
+		};
+	};
+
+	mix(m_memory.data(), m_addressMask + 1);
+	mix(m_registerV.data(), m_registerV.size());
+	mix(reinterpret_cast<const uint8_t*>(m_stack.data()), m_stack.size() * sizeof(uint16_t));
+	mix(reinterpret_cast<const uint8_t*>(&m_I), sizeof(m_I));
+	mix(reinterpret_cast<const uint8_t*>(&m_programCounter), sizeof(m_programCounter));
+	mix(reinterpret_cast<const uint8_t*>(&m_stackPointer), sizeof(m_stackPointer));
+	mix(&m_delayTimer, sizeof(m_delayTimer));
+	mix(&m_soundTimer, sizeof(m_soundTimer));
+	mix(m_framebuffer.GetData(), m_framebuffer.GetDataSize());
+
+	// Chip8 never touches the extensions, leaving them out keeps its hashes stable.
+	if (m_platform != Platform::Chip8)
+	{
+		uint8_t planes = m_framebuffer.GetSelectedPlanes();
+		mix(reinterpret_cast<const uint8_t*>(&m_platform), sizeof(m_platform));
+		mix(&planes, sizeof(planes));
+		mix(m_flagRegisters.data(), m_flagRegisters.size());
+		mix(m_audioPattern.data(), m_audioPattern.size());
+		mix(&m_pitch, sizeof(m_pitch));
+	};
+	return hash;
+};
+
+/**
+	Retrieve the size of a save state at the current resolution.
+*/
+size_t Interpreter::GetSaveStateSize() const
+{
+	return g_saveStateFixedSize + m_addressMask + 1 + m_framebuffer.GetDataSize();
+};
+
+/**
+	Serializes the machine in to a caller provided buffer.\n
+	The format is versioned and little endian, a buffer of g_saveStateMaxSize
+	bytes always fits. Nothing is allocated, so this is cheap enough to run
+	every frame.
+
+	@param[out] pBuffer Destination buffer.
+	@param[in] bufferSize Size of the destination buffer.
+	@return Number of bytes written, 0 if the buffer is too small.
+*/
+size_t Interpreter::SaveState(uint8_t* pBuffer, size_t bufferSize) const
+{
+	StateWriter writer(pBuffer, bufferSize);
+	writer.WriteU32(g_saveStateMagic);
+	writer.WriteU16(g_saveStateVersion);
+	writer.WriteU16(static_cast<uint16_t>(m_screenSize));
+	writer.WriteU16(m_framebuffer.GetWidth());
+	writer.WriteU16(m_framebuffer.GetHeight());
+	writer.WriteU8(static_cast<uint8_t>(m_platform));
+
+	writer.WriteBytes(m_memory.data(), m_addressMask + 1);
+	writer.WriteBytes(m_registerV.data(), m_registerV.size());
+	for (uint16_t address : m_stack)
+	{
+		writer.WriteU16(address);
+	};
+	writer.WriteBytes(m_keyboard.data(), m_keyboard.size());
+	writer.WriteU16(m_programCounter);
+	writer.WriteU16(m_I);
+	writer.WriteU8(static_cast<uint8_t>(m_stackPointer));
+	writer.WriteU8(m_delayTimer);
+	writer.WriteU8(m_soundTimer);
+	writer.WriteU64(m_cycleCount);
+	writer.WriteU64(m_random.GetState());
+	writer.WriteU8(m_framebuffer.GetSelectedPlanes());
+	writer.WriteBytes(m_flagRegisters.data(), m_flagRegisters.size());
+	writer.WriteBytes(m_audioPattern.data(), m_audioPattern.size());
+	writer.WriteU8(m_pitch);
+	m_framebuffer.SaveRows(writer);
+
+	return writer.IsValid() ? writer.GetOffset() : 0;
+};
+
+/**
+	Restores the machine from a buffer written by SaveState().\n
+	The state is left untouched if the buffer is not a complete save state
+	of this version, or holds a stack pointer or screen size no machine can
+	be in. Decoded and recompiled code is only thrown away for
+	memory the save state changes.
+
+	@param[in] pBuffer Source buffer.
+	@param[in] bufferSize Size of the source buffer.
+	@return false if the buffer could not be loaded.
+*/
+bool Interpreter::LoadState(const uint8_t* pBuffer, size_t bufferSize)
+{
+	StateReader reader(pBuffer, bufferSize);
+	uint32_t magic = reader.ReadU32();
+	uint16_t version = reader.ReadU16();
+	uint16_t screenSize = reader.ReadU16();
+	uint16_t width = reader.ReadU16();
+	uint16_t height = reader.ReadU16();
+	uint8_t platformValue = reader.ReadU8();
+
+	bool isScreenSizeValid = screenSize == static_cast<uint16_t>(ScreenSize::Chip8) ||
+		screenSize == static_cast<uint16_t>(ScreenSize::ETTI) ||
+		screenSize == static_cast<uint16_t>(ScreenSize::HiRes);
+	if (!reader.IsValid() || magic != g_saveStateMagic || version != g_saveStateVersion || !Framebuffer::IsValidSize(width, height) ||
+		!isScreenSizeValid || platformValue > static_cast<uint8_t>(Platform::XoChip))
+	{
+		return false;
+	};
+
+	Platform platform = static_cast<Platform>(platformValue);
+	size_t memorySize = platform == Platform::XoChip ? g_xoRamSize : g_chipRamSize;
+	uint8_t planeCount = platform == Platform::XoChip ? g_framebufferMaxPlanes : 1;
+	size_t screenBytes = planeCount * height * (width / g_framebufferWordBits) * sizeof(uint64_t);
+	if (bufferSize < g_saveStateFixedSize + memorySize + screenBytes)
+	{
+		return false;
+	};
+
+	// Checked before anything changes, 00EE and 2nnn index m_stack with it.
+	size_t stackPointerOffset = reader.GetOffset() + memorySize + g_chipRegisterBankSize + g_chipStackSize * sizeof(uint16_t) + g_chipKeyboardSize + 2 + 2;
+	int8_t stackPointer = static_cast<int8_t>(pBuffer[stackPointerOffset]);
+	if (stackPointer < -1 || stackPointer >= static_cast<int8_t>(g_chipStackSize))
+	{
+		return false;
+	};
+
+	m_screenSize = static_cast<ScreenSize>(screenSize);
+	if (platform != m_platform)
+	{
+		// Opcodes decode differently on another platform.
+		SetPlatform(platform);
+		InvalidateDecodedInstructions();
+		if (m_pRecompiler)
+		{
+			m_pRecompiler->Flush();
+		};
+	};
+
+	// Only write the bytes that differ, so decoded and recompiled code for unchanged memory survives.
+	const uint8_t* pMemory = reader.ReadSpan(memorySize);
+	for (uint32_t address = 0; address < memorySize; address += sizeof(uint64_t))
+	{
+		uint64_t current, loaded;
+		std::memcpy(&current, &m_memory[address], sizeof(uint64_t));
+		std::memcpy(&loaded, &pMemory[address], sizeof(uint64_t));
+		if (current == loaded)
+		{
+			continue;
+		};
+
+		for (uint32_t i = address; i < address + sizeof(uint64_t); i++)
+		{
+			if (m_memory[i] != pMemory[i])
+			{
+				WriteMemory(i, pMemory[i]);
+			};
+		};
+	};
+
+	reader.ReadBytes(m_registerV.data(), m_registerV.size());
+	for (uint16_t& address : m_stack)
+	{
+		address = reader.ReadU16();
+	};
+	reader.ReadBytes(m_keyboard.data(), m_keyboard.size());
+	m_programCounter = reader.ReadU16();
+	m_I = reader.ReadU16();
+	m_stackPointer = stackPointer;
+	reader.ReadU8();
+	m_delayTimer = reader.ReadU8();
+	uint8_t soundTimer = reader.ReadU8();
+	m_cycleCount = reader.ReadU64();
+	SetSoundTimer(soundTimer);
+	m_random.SetState(reader.ReadU64());
+	uint8_t planeMask = reader.ReadU8();
+	reader.ReadBytes(m_flagRegisters.data(), m_flagRegisters.size());
+	reader.ReadBytes(m_audioPattern.data(), m_audioPattern.size());
+	m_pitch = reader.ReadU8();
+	m_framebuffer.Resize(width, height);
+	m_framebuffer.SelectPlanes(planeMask);
+	m_framebuffer.LoadRows(reader);
+	NotifyPatternChanged();
+
+	// The state may bring back code a write had changed, or be for another platform.
+	BindAotProgram();
+
+#if CHIP8_PROFILER
+	if (m_pProfiler != nullptr)
+	{
+		m_pProfiler->Resync(m_stack.data(), m_stackPointer, m_memory.data());
+	};
+#endif
+
+	return true;
+};
+
+/**
+	Restarts the random sequence used by Cxkk.\n
+	The same seed, ROM and inputs always give the same run.
+
+	@param[in] seed Any value.
+*/
+void Interpreter::SetRandomSeed(uint64_t seed)
+{
+	m_random.Seed(seed);
+};
+
+#if CHIP8_PROFILER
+/**
+	Attaches a profiler that counts every following instruction.\n
+	While attached Execute() steps one instruction at a time on the
+	interpreter, the threaded engine and the recompiler are bypassed.
+
+	@param[in] pProfiler Profiler to attach, null to detach. Must outlive the attachment.
+*/
+void Interpreter::SetProfiler(Profiler* pProfiler)
+{
+	m_pProfiler = pProfiler;
+	if (m_pProfiler != nullptr)
+	{
+		m_pProfiler->Resync(m_stack.data(), m_stackPointer, m_memory.data());
+	};
+};
+#endif
+
+/**
+	Retrieve the instruction set being emulated.
+*/
+Platform Interpreter::GetPlatform() const
+{
+	return m_platform;
+};
+
+/**
+	Replaces the quirk profile picked for the ROM when it was loaded.\n
+	Everything decoded or translated so far used the old handlers and is discarded.
+
+	@param[in] profile Behaviours to emulate.
+*/
+void Interpreter::SetQuirkProfile(QuirkProfile profile)
+{
+	BindQuirks(profile);
+	InvalidateDecodedInstructions();
+	if (m_pRecompiler)
+	{
+		m_pRecompiler->Flush();
+	};
+	BindAotProgram();
+};
+
+/**
+	Retrieve the behaviours being emulated.
+*/
+QuirkProfile Interpreter::GetQuirkProfile() const
+{
+	return m_quirkProfile;
+};
+
+/**
+	Retrieve the content hash of the loaded ROM, the key of the QuirkDatabase.
+*/
+uint64_t Interpreter::GetRomHash() const
+{
+	return m_romHash;
+};
+
+/**
+	Decodes, and translates when recompiling, the code of the loaded ROM up
+	front instead of the first time it runs.\n
+	The analysis only says where to look, everything is still decoded from
+	memory, so a stale analysis costs time but never changes behaviour.
+
+	@param[in] analysis Analysis of the loaded ROM, ignored if made for another platform.
+*/
+void Interpreter::Prepare(const RomAnalysis& analysis)
+{
+	if (analysis.platform != m_platform)
+	{
+		return;
+	};
+
+	for (uint32_t address = 0; address < g_chipRamSize; address += g_chipInstructionSize)
+	{
+		DecodedInstruction& decoded = m_decodedInstructions[address >> 1];
+		if (analysis.instructions.test(address) && decoded.instruction.operation == Operation::Undecoded)
+		{
+			decoded = DecodeAt(static_cast<uint16_t>(address));
+		};
+	};
+
+	if (m_pRecompiler)
+	{
+		m_pRecompiler->Prepare(analysis);
+	};
+};
+
+/**
+	Retrieve the number of instructions executed since construction.
+*/
+uint64_t Interpreter::GetCycleCount() const
+{
+	return m_cycleCount;
+};
+
+/**
+	Turns skipping the iterations of wait loops on or off.\n
+	Skipped iterations count as executed, so the state, the cycle count and
+	everything timed by it are the same as when running them.
+
+	@param[in] isSkippingIdle true to skip wait loops in Execute().
+ */
+void Interpreter::SetIdleSkipping(bool isSkippingIdle)
+{
+	m_isSkippingIdle = isSkippingIdle;
+};
+
+/**
+	Retrieve how many instructions of GetCycleCount() were skipped in wait loops.
+ */
+uint64_t Interpreter::GetIdleCycleCount() const
+{
+	return m_idleCycleCount;
+};
+
+/**
+	Retrieve how many instructions of GetCycleCount() ran inside recompiled blocks.
+ */
+uint64_t Interpreter::GetRecompiledCycleCount() const
+{
+	return m_pRecompiler ? m_pRecompiler->GetNativeCycleCount() : 0;
+};
+
+/**
+	Retrieve emulator screen width from screenSize
+*/
+uint16_t Interpreter::GetEmulatorWidth() const
+{
+	return static_cast<uint16_t>(m_screenSize) >> 8;
+};
+
+/**
+	Retrieve emulator screen height from screenSize
+*/
+uint16_t Interpreter::GetEmulatorHeight() const
+{
+	return (0x00FF & static_cast<uint16_t>(m_screenSize));
+};
+
+/**
+	Decodes the instruction at an address and looks up its handler.
+
+	@param[in] address Address of the instruction in memory.
+	@return The decoded instruction together with the handler executing it.
+ */
+Interpreter::DecodedInstruction Interpreter::DecodeAt(uint16_t address) const
+{
+	uint16_t opcode = (m_memory[address & g_chipAddressMask] << 8) | m_memory[(address + 1) & g_chipAddressMask];
+
+	DecodedInstruction decoded;
+	decoded.instruction = DecodeInstruction(opcode, m_platform);
+	decoded.handler = m_getHandler(decoded.instruction.operation);
+	return decoded;
+};
+
+/**
+	Retrieve the member function executing an operation.
+
+	@param[in] operation The operation to look up.
+	@return Handler for the operation.
+ */
+template <typename Quirks>
+Interpreter::Handler Interpreter::GetHandler(Operation operation)
+{
+	switch (operation)
+	{
+		case Operation::Undecoded: return &Interpreter::OpDecode;
+		case Operation::Op00Cn: return &Interpreter::Op00Cn;
+		case Operation::Op00Dn: return &Interpreter::Op00Dn;
+		case Operation::Op00E0: return &Interpreter::Op00E0;
+		case Operation::Op00EE: return &Interpreter::Op00EE;
+		case Operation::Op00FB: return &Interpreter::Op00FB;
+		case Operation::Op00FC: return &Interpreter::Op00FC;
+		case Operation::Op00FD: return &Interpreter::Op00FD;
+		case Operation::Op00FE: return &Interpreter::Op00FE;
+		case Operation::Op00FF: return &Interpreter::Op00FF;
+		case Operation::Op1nnn: return &Interpreter::Op1nnn;
+		case Operation::Op2nnn: return &Interpreter::Op2nnn;
+		case Operation::Op3xkk: return &Interpreter::Op3xkk;
+		case Operation::Op4xkk: return &Interpreter::Op4xkk;
+		case Operation::Op5xy0: return &Interpreter::Op5xy0;
+		case Operation::Op5xy2: return &Interpreter::Op5xy2;
+		case Operation::Op5xy3: return &Interpreter::Op5xy3;
+		case Operation::Op6xkk: return &Interpreter::Op6xkk;
+		case Operation::Op7xkk: return &Interpreter::Op7xkk;
+		case Operation::Op8xy0: return &Interpreter::Op8xy0;
+		case Operation::Op8xy1: return &Interpreter::Op8xy1<Quirks>;
+		case Operation::Op8xy2: return &Interpreter::Op8xy2<Quirks>;
+		case Operation::Op8xy3: return &Interpreter::Op8xy3<Quirks>;
+		case Operation::Op8xy4: return &Interpreter::Op8xy4;
+		case Operation::Op8xy5: return &Interpreter::Op8xy5;
+		case Operation::Op8xy6: return &Interpreter::Op8xy6<Quirks>;
+		case Operation::Op8xy7: return &Interpreter::Op8xy7;
+		case Operation::Op8xyE: return &Interpreter::Op8xyE<Quirks>;
+		case Operation::Op9xy0: return &Interpreter::Op9xy0;
+		case Operation::OpAnnn: return &Interpreter::OpAnnn;
+		case Operation::OpBnnn: return &Interpreter::OpBnnn<Quirks>;
+		case Operation::OpCxkk: return &Interpreter::OpCxkk;
+		case Operation::OpDxyn: return &Interpreter::OpDxyn<Quirks>;
+		case Operation::OpEx9E: return &Interpreter::OpEx9E;
+		case Operation::OpExA1: return &Interpreter::OpExA1;
+		case Operation::OpF000: return &Interpreter::OpF000;
+		case Operation::OpFn01: return &Interpreter::OpFn01;
+		case Operation::OpF002: return &Interpreter::OpF002;
+		case Operation::OpFx07: return &Interpreter::OpFx07;
+		case Operation::OpFx0A: return &Interpreter::OpFx0A;
+		case Operation::OpFx15: return &Interpreter::OpFx15;
+		case Operation::OpFx18: return &Interpreter::OpFx18;
+		case Operation::OpFx1E: return &Interpreter::OpFx1E;
+		case Operation::OpFx29: return &Interpreter::OpFx29;
+		case Operation::OpFx30: return &Interpreter::OpFx30;
+		case Operation::OpFx33: return &Interpreter::OpFx33;
+		case Operation::OpFx3A: return &Interpreter::OpFx3A;
+		case Operation::OpFx55: return &Interpreter::OpFx55<Quirks>;
+		case Operation::OpFx65: return &Interpreter::OpFx65<Quirks>;
+		case Operation::OpFx75: return &Interpreter::OpFx75;
+		case Operation::OpFx85: return &Interpreter::OpFx85;
+		default: return &Interpreter::OpUnknown;
+	};
+};
+
+/**
+	Looks up the ahead of time program for the loaded ROM, platform and quirk profile.\n
+	Does nothing unless the ahead of time engine is selected.
+ */
+void Interpreter::BindAotProgram()
+{
+	if (m_pAotEngine)
+	{
+		m_pAotEngine->Bind(AotRegistry::GetInstance().Find(m_romHash, m_platform, m_quirkProfile));
+	};
+};
+
+/**
+	Marks every cached instruction as undecoded.
+ */
+void Interpreter::InvalidateDecodedInstructions()
+{
+	// Built once, copying from a temporary rebuilt per entry stalls on store forwarding.
+	static const DecodedInstruction s_undecoded = []()
+	{
+		DecodedInstruction undecoded;
+		undecoded.instruction = DecodeInstruction(0x0000);
+		undecoded.instruction.operation = Operation::Undecoded;
+		undecoded.handler = &Interpreter::OpDecode;
+		return undecoded;
+	}();
+
+	m_decodedInstructions.fill(s_undecoded);
+};
+
+/**
+	Sets the sound timer and tells the sound listener when the beeper turns on or off.
+
+	@param[in] value New sound timer value.
+ */
+void Interpreter::SetSoundTimer(uint8_t value)
+{
+	bool wasActive = m_soundTimer > 0;
+	m_soundTimer = value;
+	if (m_pSoundListener != nullptr && wasActive != (value > 0))
+	{
+		m_pSoundListener->OnSoundChanged(m_cycleCount, value > 0);
+	};
+};
+
+/**
+	Switches the instruction set, the memory size and the number of bit planes.\n
+	Memory is resized to the address space of the platform, the framebuffer is
+	sized for XO-CHIP and never reallocated.
+
+	@param[in] platform Instruction set to emulate.
+ */
+void Interpreter::SetPlatform(Platform platform)
+{
+	m_platform = platform;
+	m_addressMask = platform == Platform::XoChip ? static_cast<uint16_t>(g_xoRamSize - 1) : g_chipAddressMask;
+
+	// Only XO-CHIP pays for 64K, growing keeps the first 4K and zeroes the rest.
+	m_memory.resize(m_addressMask + 1, 0x00);
+	m_framebuffer.SetPlaneCount(platform == Platform::XoChip ? g_framebufferMaxPlanes : 1);
+};
+
+/**
+	Points the handler lookup and the threaded engine at the instantiations for a profile.\n
+	Does not touch the decoded instruction cache.
+
+	@param[in] profile Behaviours to emulate.
+ */
+void Interpreter::BindQuirks(QuirkProfile profile)
+{
+	m_quirkProfile = profile;
+	switch (profile)
+	{
+		case QuirkProfile::Vip:
+			BindPolicy<VipQuirks>();
+			break;
+
+		case QuirkProfile::SuperChip:
+			BindPolicy<SuperChipQuirks>();
+			break;
+
+		case QuirkProfile::XoChip:
+			BindPolicy<XoChipQuirks>();
+			break;
+
+		default:
+			m_quirkProfile = QuirkProfile::Default;
+			BindPolicy<DefaultQuirks>();
+			break;
+	};
+};
+
+/**
+	Points the handler lookup and the threaded engine at the instantiations for a policy.
+ */
+template <typename Quirks>
+void Interpreter::BindPolicy()
+{
+	m_getHandler = &Interpreter::GetHandler<Quirks>;
+#if CHIP8_THREADED_DISPATCH
+	m_executeThreaded = &Interpreter::ExecuteThreaded<Quirks>;
+#endif
+};
+
+/**
+	Retrieve how far a taken skip moves the program counter.\n
+	XO-CHIP skips the four byte F000 nnnn as a whole.
+ */
+uint16_t Interpreter::GetSkipSize() const
+{
+	return GetSkipSize(m_programCounter);
+};
+
+/**
+	Retrieve how far a taken skip moves a program counter.
+
+	@param[in] address Program counter after the skip instruction.
+ */
+uint16_t Interpreter::GetSkipSize(uint16_t address) const
+{
+	if (m_platform == Platform::XoChip &&
+		m_memory[address & g_chipAddressMask] == 0xF0 && m_memory[(address + 1) & g_chipAddressMask] == 0x00)
+	{
+		return g_chipInstructionSize * 2;
+	};
+
+	return g_chipInstructionSize;
+};
+
+/**
+	Switches between the low and high resolution of SUPER-CHIP, clearing the screen.\n
+	The framebuffer is sized for the high resolution, so this never reallocates.
+ */
+void Interpreter::SetResolution(ScreenSize screenSize)
+{
+	m_screenSize = screenSize;
+	m_framebuffer.Resize(GetEmulatorWidth(), GetEmulatorHeight());
+};
+
+/**
+	Tells the sound listener about the XO-CHIP audio pattern and pitch.
+ */
+void Interpreter::NotifyPatternChanged()
+{
+	if (m_pSoundListener != nullptr && m_platform == Platform::XoChip)
+	{
+		m_pSoundListener->OnPatternChanged(m_cycleCount, m_audioPattern, m_pitch);
+	};
+};
+
+/**
+	Writes a byte to memory and drops the cached instruction covering it.
+
+	@param[in] address Address to write to, wrapped to the address space of the platform.
+	@param[in] value Value to write.
+ */
+void Interpreter::WriteMemory(uint16_t address, uint8_t value)
+{
+	address &= m_addressMask;
+	m_memory[address] = value;
+
+	// Code only runs from the first 4K, XO-CHIP data above it never needs decoding.
+	if (address >= g_chipRamSize)
+	{
+		return;
+	};
+
+	if (m_pRecompiler)
+	{
+		m_pRecompiler->Invalidate(address);
+	};
+
+	if (m_pAotEngine)
+	{
+		m_pAotEngine->Invalidate(address);
+	};
+
+	DecodedInstruction& decoded = m_decodedInstructions[address >> 1];
+	decoded.instruction.operation = Operation::Undecoded;
+	decoded.handler = &Interpreter::OpDecode;
+};
+
+/**
+	Decodes the instruction for the current cache entry and executes it.
+ */
+void Interpreter::OpDecode(const Instruction&)
+{
+	uint16_t address = (m_programCounter - g_chipInstructionSize) & g_chipAddressMask;
+	DecodedInstruction& decoded = m_decodedInstructions[address >> 1];
+	decoded = DecodeAt(address);
+	(this->*decoded.handler)(decoded.instruction);
+};
+
+/**
+	Unknown opcodes are ignored.
+ */
+void Interpreter::OpUnknown(const Instruction&)
+{
+};
+
+/**
+	00Cn\n
+		Scroll the selected planes down by n rows.
+ */
+void Interpreter::Op00Cn(const Instruction& instruction)
+{
+	m_framebuffer.ScrollDown(instruction.n);
+};
+
+/**
+	00Dn\n
+		Scroll the selected planes up by n rows.
+ */
+void Interpreter::Op00Dn(const Instruction& instruction)
+{
+	m_framebuffer.ScrollUp(instruction.n);
+};
+
+/**
+	00E0\n
+		Clear the display.
+ */
+void Interpreter::Op00E0(const Instruction&)
+{
+	m_framebuffer.Clear();
+};
+
+/**
+	00EE\n
+		Return from subroutine, a return on an empty stack wraps, see GetStackPointerAfterReturn().
+ */
+void Interpreter::Op00EE(const Instruction&)
+{
+	m_programCounter = m_stack[m_stackPointer & g_chipStackMask];
+	m_stackPointer = GetStackPointerAfterReturn(m_stackPointer);
+};
+
+/**
+	00FB\n
+		Scroll the selected planes right by 4 pixels.
+ */
+void Interpreter::Op00FB(const Instruction&)
+{
+	m_framebuffer.ScrollRight(4);
+};
+
+/**
+	00FC\n
+		Scroll the selected planes left by 4 pixels.
+ */
+void Interpreter::Op00FC(const Instruction&)
+{
+	m_framebuffer.ScrollLeft(4);
+};
+
+/**
+	00FD\n
+		Exit the interpreter, the instruction repeats itself until the front end stops.
+ */
+void Interpreter::Op00FD(const Instruction&)
+{
+	m_programCounter -= g_chipInstructionSize;
+};
+
+/**
+	00FE\n
+		Switch to the 64 x 32 low resolution and clear the screen.
+ */
+void Interpreter::Op00FE(const Instruction&)
+{
+	SetResolution(ScreenSize::Chip8);
+};
+
+/**
+	00FF\n
+		Switch to the 128 x 64 high resolution and clear the screen.
+ */
+void Interpreter::Op00FF(const Instruction&)
+{
+	SetResolution(ScreenSize::HiRes);
+};
+
+/**
+	1nnn\n
+		Jump to location nnn.
+ */
+void Interpreter::Op1nnn(const Instruction& instruction)
+{
+	m_programCounter = instruction.nnn;
+};
+
+/**
+	2nnn\n
+		Call subroutine at nnn, the return address is pushed on the stack, which wraps after 16 calls.
+ */
+void Interpreter::Op2nnn(const Instruction& instruction)
+{
+	m_stackPointer = GetStackPointerAfterCall(m_stackPointer);
+	m_stack[m_stackPointer] = m_programCounter;
+	m_programCounter = instruction.nnn;
+};
+
+/**
+	3xkk\n
+		Compare register x to kk, if equal increment program counter by 2
+ */
+void Interpreter::Op3xkk(const Instruction& instruction)
+{
+	m_programCounter += m_registerV[instruction.x] == instruction.kk ? GetSkipSize() : 0;
+};
+
+/**
+	4xkk\n
+		Compare register x to kk, is not equal increment program counter by 2
+ */
+void Interpreter::Op4xkk(const Instruction& instruction)
+{
+	m_programCounter += m_registerV[instruction.x] != instruction.kk ? GetSkipSize() : 0;
+};
+
+/**
+	5xy0\n
+		Compare register x and y, if x and y is equal increment program counter by 2
+ */
+void Interpreter::Op5xy0(const Instruction& instruction)
+{
+	m_programCounter += m_registerV[instruction.x] == m_registerV[instruction.y] ? GetSkipSize() : 0;
+};
+
+/**
+	5xy2\n
+		Store registers Vx through Vy in to memory starting at I, in either direction. I is left unchanged.
+ */
+void Interpreter::Op5xy2(const Instruction& instruction)
+{
+	int8_t step = instruction.x <= instruction.y ? 1 : -1;
+	uint8_t count = static_cast<uint8_t>(std::abs(instruction.y - instruction.x) + 1);
+	for (uint8_t i = 0; i < count; i++)
+	{
+		WriteMemory(m_I + i, m_registerV[instruction.x + i * step]);
+	};
+};
+
+/**
+	5xy3\n
+		Load registers Vx through Vy from memory starting at I, in either direction. I is left unchanged.
+ */
+void Interpreter::Op5xy3(const Instruction& instruction)
+{
+	int8_t step = instruction.x <= instruction.y ? 1 : -1;
+	uint8_t count = static_cast<uint8_t>(std::abs(instruction.y - instruction.x) + 1);
+	for (uint8_t i = 0; i < count; i++)
+	{
+		m_registerV[instruction.x + i * step] = m_memory[(m_I + i) & m_addressMask];
+	};
+};
+
+/**
+	6xkk\n
+		Store kk in register x
+ */
+void Interpreter::Op6xkk(const Instruction& instruction)
+{
+	m_registerV[instruction.x] = instruction.kk;
+};
+
+/**
+	7xkk\n
+		Set register x to x + kk
+ */
+void Interpreter::Op7xkk(const Instruction& instruction)
+{
+	m_registerV[instruction.x] += instruction.kk;
+};
+
+/**
+	8xy0\n
+		Set register Vx to Vy
+ */
+void Interpreter::Op8xy0(const Instruction& instruction)
+{
+	m_registerV[instruction.x] = m_registerV[instruction.y];
+};
+
+/**
+	8xy1\n
+		Set register Vx to Vx OR (|) Vy
+		VF is set to 0 with the VF reset quirk.
+ */
+template <typename Quirks>
+void Interpreter::Op8xy1(const Instruction& instruction)
+{
+	m_registerV[instruction.x] |= m_registerV[instruction.y];
+	if (Quirks::resetsVF)
+	{
+		m_registerV[0x0F] = 0x00;
+	};
+};
+
+/**
+	8xy2\n
+		Set register Vx to Vx AND (&) Vy
+		VF is set to 0 with the VF reset quirk.
+ */
+template <typename Quirks>
+void Interpreter::Op8xy2(const Instruction& instruction)
+{
+	m_registerV[instruction.x] &= m_registerV[instruction.y];
+	if (Quirks::resetsVF)
+	{
+		m_registerV[0x0F] = 0x00;
+	};
+};
+
+/**
+	8xy3\n
+		Set register Vx XOR Vy
+		VF is set to 0 with the VF reset quirk.
+ */
+template <typename Quirks>
+void Interpreter::Op8xy3(const Instruction& instruction)
+{
+	m_registerV[instruction.x] ^= m_registerV[instruction.y];
+	if (Quirks::resetsVF)
+	{
+		m_registerV[0x0F] = 0x00;
+	};
+};
+
+/**
+	8xy4\n
+		Set register Vx to Vx + Vy.
+		Set register VF to carry (Vx + Vy > 255, carry is equal to 1 otherwise 0)
+ */
+void Interpreter::Op8xy4(const Instruction& instruction)
+{
+	uint16_t sum = m_registerV[instruction.x] + m_registerV[instruction.y];
+	m_registerV[instruction.x] = static_cast<uint8_t>(sum);
+	m_registerV[0x0F] = sum > 0xFF ? 0x01 : 0x00;
+};
+
+/**
+	8xy5\n
+		Set register Vx to Vx - Vy
+		VF is set to NOT borrow
+ */
+void Interpreter::Op8xy5(const Instruction& instruction)
+{
+	uint8_t notBorrow = m_registerV[instruction.x] >= m_registerV[instruction.y] ? 0x01 : 0x00;
+	m_registerV[instruction.x] -= m_registerV[instruction.y];
+	m_registerV[0x0F] = notBorrow;
+};
+
+/**
+	8xy6\n
+		If the last bit of Vx is 1 set VF  to 1, otherwise 0.
+		Divide register Vx by two.
+		With the shift quirk Vx is set to Vy divided by two instead.
+ */
+template <typename Quirks>
+void Interpreter::Op8xy6(const Instruction& instruction)
+{
+	uint8_t source = m_registerV[Quirks::shiftsVy ? instruction.y : instruction.x];
+	m_registerV[instruction.x] = source >> 1;
+	m_registerV[0x0F] = source & 0x01;
+};
+
+/**
+	8xy7\n
+		Set register Vx to Vy - Vx.
+		Register VF is set to NOT BORROW.
+ */
+void Interpreter::Op8xy7(const Instruction& instruction)
+{
+	uint8_t notBorrow = m_registerV[instruction.y] >= m_registerV[instruction.x] ? 0x01 : 0x00;
+	m_registerV[instruction.x] = m_registerV[instruction.y] - m_registerV[instruction.x];
+	m_registerV[0x0F] = notBorrow;
+};
+
+/**
+	8xyE\n
+		Check if most-significant bit is 1, if so set VF to 1 otherwise 0.
+		Multiply register Vx by 2.
+		With the shift quirk Vx is set to Vy multiplied by two instead.
+ */
+template <typename Quirks>
+void Interpreter::Op8xyE(const Instruction& instruction)
+{
+	uint8_t source = m_registerV[Quirks::shiftsVy ? instruction.y : instruction.x];
+	m_registerV[instruction.x] = static_cast<uint8_t>(source << 1);
+	m_registerV[0x0F] = source & 0x80 ? 0x01 : 0x00;
+};
+
+/**
+	9xy0\n
+		Skip next instruction if register x is not equal to register y
+ */
+void Interpreter::Op9xy0(const Instruction& instruction)
+{
+	m_programCounter += m_registerV[instruction.x] != m_registerV[instruction.y] ? GetSkipSize() : 0;
+};
+
+/**
+	Annn\n
+		Set I to nnn
+ */
+void Interpreter::OpAnnn(const Instruction& instruction)
+{
+	m_I = instruction.nnn;
+};
+
+/**
+	Bnnn\n
+		Set program counter to nnn + value of register V0.
+		With the jump quirk it is xnn + value of register Vx.
+ */
+template <typename Quirks>
+void Interpreter::OpBnnn(const Instruction& instruction)
+{
+	m_programCounter = instruction.nnn + m_registerV[Quirks::jumpsWithVx ? instruction.x : 0x00];
+};
+
+/**
+	Cxkk\n
+		Set Vx to random byte AND kk
+ */
+void Interpreter::OpCxkk(const Instruction& instruction)
+{
+	m_registerV[instruction.x] = m_random.NextByte() & instruction.kk;
+};
+
+/**
+	Dxyn\n
+		Display n-byte sprite starting at location of I
+		x - positionX from Vx
+		y - positionY from Vy
+		n - read n bytes from memory also used as height
+		The position wraps around the screen, pixels past the edges are clipped
+		or wrapped depending on the sprite quirk.
+		SUPER-CHIP draws a 16 x 16 sprite of two bytes per row for n = 0.
+		XO-CHIP draws on every selected plane, each plane takes the next sprite's worth of bytes.
+ */
+template <typename Quirks>
+void Interpreter::OpDxyn(const Instruction& instruction)
+{
+	bool isWide = instruction.n == 0 && m_platform != Platform::Chip8;
+	uint8_t rowCount = isWide ? 16 : instruction.n;
+	uint8_t planes = m_framebuffer.GetSelectedPlanes();
+	uint16_t byteCount = rowCount * (isWide ? 2 : 1) * ((planes & 0x01) + ((planes >> 1) & 0x01));
+
+	std::array<uint8_t, 16 * 2 * g_framebufferMaxPlanes> rows;
+	for (uint16_t i = 0; i < byteCount; i++)
+	{
+		rows[i] = m_memory[(m_I + i) & m_addressMask];
+	};
+
+	// Set register 15 (0x0F) to 1 if any pixel was turned off.
+	uint8_t x = m_registerV[instruction.x];
+	uint8_t y = m_registerV[instruction.y];
+	bool collision = isWide ?
+		m_framebuffer.DrawWideSprite<Quirks::wrapsSprites>(x, y, rows.data(), rowCount) :
+		m_framebuffer.DrawSprite<Quirks::wrapsSprites>(x, y, rows.data(), rowCount);
+	m_registerV[0x0F] = collision ? 0x01 : 0x00;
+};
+
+/**
+	Ex9E\n
+		Skip next instruction if the key with value Vx is pressed.
+ */
+void Interpreter::OpEx9E(const Instruction& instruction)
+{
+	m_programCounter += m_keyboard[m_registerV[instruction.x] & 0x0F] != 0 ? GetSkipSize() : 0;
+};
+
+/**
+	ExA1\n
+		Skip the next instruction if the key with value Vx is released.
+ */
+void Interpreter::OpExA1(const Instruction& instruction)
+{
+	m_programCounter += m_keyboard[m_registerV[instruction.x] & 0x0F] == 0 ? GetSkipSize() : 0;
+};
+
+/**
+	F000 nnnn\n
+		Set I to the 16 bit word following the instruction and step over it.
+ */
+void Interpreter::OpF000(const Instruction&)
+{
+	m_I = static_cast<uint16_t>(m_memory[m_programCounter & g_chipAddressMask] << 8 | m_memory[(m_programCounter + 1) & g_chipAddressMask]);
+	m_programCounter += g_chipInstructionSize;
+};
+
+/**
+	Fn01\n
+		Select the bit planes drawing, clearing and scrolling apply to, bit p of n selects plane p.
+ */
+void Interpreter::OpFn01(const Instruction& instruction)
+{
+	m_framebuffer.SelectPlanes(instruction.x);
+};
+
+/**
+	F002\n
+		Load the 16 byte audio pattern from memory starting at I.
+ */
+void Interpreter::OpF002(const Instruction&)
+{
+	for (uint8_t i = 0; i < g_xoAudioPatternSize; i++)
+	{
+		m_audioPattern[i] = m_memory[(m_I + i) & m_addressMask];
+	};
+	NotifyPatternChanged();
+};
+
+/**
+	Fx07\n
+		Store delay timer in register Vx.
+ */
+void Interpreter::OpFx07(const Instruction& instruction)
+{
+	m_registerV[instruction.x] = m_delayTimer;
+};
+
+/**
+	Fx0A\n
+		Wait for a key press and then store it in register Vx.
+		The instruction is repeated until a key is pressed.
+ */
+void Interpreter::OpFx0A(const Instruction& instruction)
+{
+	for (uint8_t i = 0; i < g_chipKeyboardSize; i++)
+	{
+		if (m_keyboard[i] == 0x01)
+		{
+			m_registerV[instruction.x] = i;
+			return;
+		};
+	};
+
+	// No key pressed, execute this instruction again.
+	m_programCounter -= g_chipInstructionSize;
+};
+
+/**
+	Fx15\n
+		Set delay timer to Vx.
+ */
+void Interpreter::OpFx15(const Instruction& instruction)
+{
+	m_delayTimer = m_registerV[instruction.x];
+};
+
+/**
+	Fx18\n
+		Set sound timer to Vx.
+ */
+void Interpreter::OpFx18(const Instruction& instruction)
+{
+	SetSoundTimer(m_registerV[instruction.x]);
+};
+
+/**
+	Fx1E\n
+		Set I to I + register Vx.
+ */
+void Interpreter::OpFx1E(const Instruction& instruction)
+{
+	m_I += m_registerV[instruction.x];
+};
+
+/**
+	Fx29\n
+		Set I to corresponding sprite for digit at Vx.
+ */
+void Interpreter::OpFx29(const Instruction& instruction)
+{
+	// Multiply value by five (5) since a font sprite has a length of five (5).
+	m_I = (m_registerV[instruction.x] & 0x0F) * 5;
+};
+
+/**
+	Fx30\n
+		Set I to the large font sprite for digit at Vx.
+ */
+void Interpreter::OpFx30(const Instruction& instruction)
+{
+	m_I = g_chipBigFontAddress + (m_registerV[instruction.x] & 0x0F) * 10;
+};
+
+/**
+	Fx33\n
+		Store the BCD (Binary Coded Decimal) of Vx in memory location starting at I.\n
+		I = one hundredth digit of Vx \n
+		I + 1 = one tenth digit of Vx \n
+		I + 2 = one digit of Vx \n
+ */
+void Interpreter::OpFx33(const Instruction& instruction)
+{
+	uint8_t value = m_registerV[instruction.x];
+	WriteMemory(m_I, (value / 100) % 10);
+	WriteMemory(m_I + 1, (value / 10) % 10);
+	WriteMemory(m_I + 2, value % 10);
+};
+
+/**
+	Fx3A\n
+		Set the pitch the audio pattern plays at to Vx.
+ */
+void Interpreter::OpFx3A(const Instruction& instruction)
+{
+	m_pitch = m_registerV[instruction.x];
+	NotifyPatternChanged();
+};
+
+/**
+	Fx55\n
+		Store register V0 through Vx in to memory starting at I.
+		With the load and store quirk I is left pointing past the last register.
+ */
+template <typename Quirks>
+void Interpreter::OpFx55(const Instruction& instruction)
+{
+	for (uint8_t i = 0; i <= instruction.x; i++)
+	{
+		WriteMemory(m_I + i, m_registerV[i]);
+	};
+
+	if (Quirks::incrementsI)
+	{
+		m_I += instruction.x + 1;
+	};
+};
+
+/**
+	Fx65\n
+		Reads registers V0 to Vx from memory starting at I.
+		With the load and store quirk I is left pointing past the last register.
+ */
+template <typename Quirks>
+void Interpreter::OpFx65(const Instruction& instruction)
+{
+	for (uint8_t i = 0; i <= instruction.x; i++)
+	{
+		m_registerV[i] = m_memory[(m_I + i) & m_addressMask];
+	};
+
+	if (Quirks::incrementsI)
+	{
+		m_I += instruction.x + 1;
+	};
+};
+
+/**
+	Fx75\n
+		Store registers V0 through Vx in the flag registers.
+ */
+void Interpreter::OpFx75(const Instruction& instruction)
+{
+	std::copy(m_registerV.begin(), m_registerV.begin() + instruction.x + 1, m_flagRegisters.begin());
+};
+
+/**
+	Fx85\n
+		Load registers V0 through Vx from the flag registers.
+ */
+void Interpreter::OpFx85(const Instruction& instruction)
+{
+	std::copy(m_flagRegisters.begin(), m_flagRegisters.begin() + instruction.x + 1, m_registerV.begin());
 };
@@ -5,47 +5,212 @@
 #include <cstdint>
 #include <fstream>
 #include <array>
+#include <cstddef>
 #include <memory>
+#include <vector>
+#include "Framebuffer.hpp"
+#include "Instruction.hpp"
+#include "Quirks.hpp"
+#include "Random.hpp"
 
 /** Chip8 RAM size 4096 KB */
 constexpr uint16_t g_chipRamSize = 4096;
+/** Mask wrapping an address to the Chip8 RAM */
+constexpr uint16_t g_chipAddressMask = g_chipRamSize - 1;
 /** Size of a Chip8 instruction (16 bits) */
 constexpr uint8_t g_chipInstructionSize = 2;
 /** Size of the Chip8 register bank */
 constexpr uint8_t g_chipRegisterBankSize = 16;
 /** Size of the Chip8 stack */
 constexpr uint8_t g_chipStackSize = 16;
+/** Mask wrapping a stack pointer to a slot of the stack */
+constexpr uint8_t g_chipStackMask = g_chipStackSize - 1;
 /** Number of keys available on a Chip8 */
 constexpr uint8_t g_chipKeyboardSize = 16;
+/** Largest ROM that fits in memory after the reserved first 512 bytes */
+constexpr uint16_t g_chipRomMaxSize = g_chipRamSize - 0x0200;
 /** Chip8 fonstset size */
 constexpr uint8_t g_chipFontsetSize = 80;
+/** SUPER-CHIP large fontset size, 10 bytes per digit */
+constexpr uint8_t g_chipBigFontsetSize = 160;
+/** Address of the large fontset, right after the small one */
+constexpr uint16_t g_chipBigFontAddress = g_chipFontsetSize;
+/** Number of SUPER-CHIP flag registers */
+constexpr uint8_t g_chipFlagRegisterCount = 16;
+/** XO-CHIP RAM size, data can be anywhere in it while code stays in the first 4K */
+constexpr uint32_t g_xoRamSize = 0x10000;
+/** Largest XO-CHIP ROM */
+constexpr uint32_t g_xoRomMaxSize = g_xoRamSize - 0x0200;
+/** Size of the XO-CHIP audio pattern, one bit per sample */
+constexpr uint8_t g_xoAudioPatternSize = 16;
+/** XO-CHIP pitch register after reset, plays the pattern at 4000 Hz */
+constexpr uint8_t g_xoDefaultPitch = 64;
+/** Longest wait loop, in instructions, that Execute() recognizes when skipping idle time */
+constexpr uint8_t g_idleMaxLoopLength = 8;
+/** Instructions run between two checks for a wait loop when skipping idle time */
+constexpr uint32_t g_idleCheckCycles = 256;
+
+/** Save state format identifier, "C8ST" */
+constexpr uint32_t g_saveStateMagic = 0x54533843;
+/** Save state format version, bumped whenever the layout changes */
+constexpr uint16_t g_saveStateVersion = 3;
+/**
+	Size of a save state without memory and the screen.
+	Header (magic, version, screen size, framebuffer width and height, platform),
+	registers, stack, keyboard, PC, I, SP, DT, ST, the cycle count, the random
+	generator, selected planes, flag registers, audio pattern and pitch.
+ */
+constexpr size_t g_saveStateFixedSize = 13 +
+	g_chipRegisterBankSize + g_chipStackSize * sizeof(uint16_t) + g_chipKeyboardSize +
+	2 + 2 + 1 + 1 + 1 + 8 + 8 +
+	1 + g_chipFlagRegisterCount + g_xoAudioPatternSize + 1;
+/** Largest possible save state, a buffer of this size always fits */
+constexpr size_t g_saveStateMaxSize = g_saveStateFixedSize + g_xoRamSize +
+	g_framebufferMaxPlanes * g_framebufferMaxHeight * (g_framebufferMaxWidth / g_framebufferWordBits) * sizeof(uint64_t);
+
+/** Chip8 fontset, placed at the start of memory */
+extern const std::array<uint8_t, g_chipFontsetSize> g_chipFontset;
+/** SUPER-CHIP large fontset, 8 x 10 pixel digits placed at g_chipBigFontAddress */
+extern const std::array<uint8_t, g_chipBigFontsetSize> g_chipBigFontset;
 
 /**
 	Allows for easier handling of multiple screen sizes.
 		Chip8 - 64 x 32 pixels
 		ETTI - 64 x 48 pixels
+		HiRes - 128 x 64 pixels, SUPER-CHIP and XO-CHIP after 00FF
  */
 enum class ScreenSize : uint16_t
 {
 	Chip8 = 0x4020,
-	ETTI = 0x4030
+	ETTI = 0x4030,
+	HiRes = 0x8040
+};
+
+/**
+	Engines available to Interpreter::Execute().
+		Interpreter - Predecoded instruction interpreter, always available.
+		Recompiler - x86-64 basic block recompiler, falls back to the interpreter.
+		Aot - Blocks chip8-aot translated ahead of time for the loaded ROM, falls back to the interpreter.
+ */
+enum class Backend : uint8_t
+{
+	Interpreter,
+	Recompiler,
+	Aot
+};
+
+/**
+	Retrieve the stack pointer after a call, the slot the return address goes in.\n
+	The stack wraps around, a 17th nested call overwrites the oldest return address.
+	Every engine uses this so a guest bug never reaches past the stack.
+
+	@param[in] stackPointer Stack pointer before the call, -1 to 15.
+ */
+inline int8_t GetStackPointerAfterCall(int8_t stackPointer)
+{
+	return static_cast<int8_t>((stackPointer + 1) & g_chipStackMask);
+};
+
+/**
+	Retrieve the stack pointer after a return.\n
+	The return address is in slot stackPointer & g_chipStackMask, so a return
+	on an empty stack pops the last slot and wraps like a call does.
+
+	@param[in] stackPointer Stack pointer before the return, -1 to 15.
+	@return Stack pointer after the return, -1 once the stack is empty.
+ */
+inline int8_t GetStackPointerAfterReturn(int8_t stackPointer)
+{
+	return stackPointer == 0 ? -1 : static_cast<int8_t>((stackPointer - 1) & g_chipStackMask);
+};
+
+class AotEngine;
+class Profiler;
+class Recompiler;
+struct RomAnalysis;
+
+/**
+	Receives the beeper turning on and off.\n
+	Called on the thread running the interpreter, implementations must not block.
+ */
+class SoundListener
+{
+	public:
+
+		virtual ~SoundListener() = default;
+
+		/**
+			The sound timer became non zero or reached zero.
+
+			@param[in] cycle Cycle count of the interpreter at the change.
+			@param[in] isActive true while the beeper sounds.
+		 */
+		virtual void OnSoundChanged(uint64_t cycle, bool isActive) = 0;
+
+		/**
+			XO-CHIP loaded a new audio pattern or changed the pitch, nothing by default.
+
+			@param[in] cycle Cycle count of the interpreter at the change.
+			@param[in] pattern 128 one bit samples, most significant bit first.
+			@param[in] pitch Pitch register, the pattern plays at 4000 * 2 ^ ((pitch - 64) / 48) samples per second.
+		 */
+		virtual void OnPatternChanged(uint64_t cycle, const std::array<uint8_t, g_xoAudioPatternSize>& pattern, uint8_t pitch)
+		{
+			(void)cycle;
+			(void)pattern;
+			(void)pitch;
+		};
 };
 
 class Interpreter
 {
+	friend class AotEngine;
+	friend class Recompiler;
+
 	public:
 	
 		Interpreter();
 		~Interpreter();
     
-        bool Initialize(const char* filePath, ScreenSize screenSize);
+        bool Initialize(const char* filePath, ScreenSize screenSize, Platform platform = Platform::Chip8);
         void Run();
+        uint32_t Execute(uint32_t cycles);
+        void TickTimers();
+        bool IsSoundActive() const;
+        void SetSoundListener(SoundListener* pListener);
     
-        void Draw(uint32_t* pScreen, uint32_t windowWidth, uint32_t windowHeight);
+        const Framebuffer& GetFramebuffer() const;
+        bool IsFrameDirty() const;
+        uint64_t GetDirtyRows() const;
+        void ClearDirtyRows();
     
         void OnKeyPressed(uint8_t keyIndex);
         void OnKeyReleased(uint8_t keyIndex);
 
+		bool SetBackend(Backend backend);
+		Backend GetBackend() const;
+
+		void SetRandomSeed(uint64_t seed);
+
+		Platform GetPlatform() const;
+		void SetQuirkProfile(QuirkProfile profile);
+		QuirkProfile GetQuirkProfile() const;
+		uint64_t GetRomHash() const;
+		void Prepare(const RomAnalysis& analysis);
+
+		uint64_t GetCycleCount() const;
+		void SetIdleSkipping(bool isSkippingIdle);
+		uint64_t GetIdleCycleCount() const;
+		uint64_t GetRecompiledCycleCount() const;
+#if CHIP8_PROFILER
+		void SetProfiler(Profiler* pProfiler);
+#endif
+		uint64_t GetStateHash() const;
+
+		size_t GetSaveStateSize() const;
+		size_t SaveState(uint8_t* pBuffer, size_t bufferSize) const;
+		bool LoadState(const uint8_t* pBuffer, size_t bufferSize);
+
     private:
     
         bool InitializeEmulatorRAM();
@@ -55,6 +220,112 @@ class Interpreter
 
 		uint16_t GetEmulatorWidth() const;
 		uint16_t GetEmulatorHeight() const;
+
+		/** Member function executing a decoded instruction */
+		typedef void (Interpreter::*Handler)(const Instruction& instruction);
+
+		/** Entry in the decoded instruction cache */
+		struct DecodedInstruction
+		{
+			/** Handler executing the instruction */
+			Handler handler;
+			/** Instruction with its operands extracted */
+			Instruction instruction;
+		};
+
+		/** GetHandler() instantiated for one quirk policy */
+		typedef Handler (*HandlerLookup)(Operation operation);
+#if CHIP8_THREADED_DISPATCH
+		/** ExecuteThreaded() instantiated for one quirk policy */
+		typedef uint32_t (Interpreter::*ThreadedEngine)(uint32_t cycles);
+#endif
+
+		void Dispatch();
+		uint32_t ExecuteBackend(uint32_t cycles);
+		uint32_t ExecuteInterpreted(uint32_t cycles);
+		uint32_t FindIdleLoop() const;
+		void BindAotProgram();
+#if CHIP8_THREADED_DISPATCH
+		template <typename Quirks>
+		uint32_t ExecuteThreaded(uint32_t cycles);
+#endif
+
+		void BindQuirks(QuirkProfile profile);
+		template <typename Quirks>
+		void BindPolicy();
+		DecodedInstruction DecodeAt(uint16_t address) const;
+		template <typename Quirks>
+		static Handler GetHandler(Operation operation);
+		void InvalidateDecodedInstructions();
+		void WriteMemory(uint16_t address, uint8_t value);
+		void SetSoundTimer(uint8_t value);
+		void SetPlatform(Platform platform);
+		uint16_t GetSkipSize() const;
+		uint16_t GetSkipSize(uint16_t address) const;
+		void SetResolution(ScreenSize screenSize);
+		void NotifyPatternChanged();
+
+		void OpDecode(const Instruction& instruction);
+		void OpUnknown(const Instruction& instruction);
+		void Op00Cn(const Instruction& instruction);
+		void Op00Dn(const Instruction& instruction);
+		void Op00E0(const Instruction& instruction);
+		void Op00EE(const Instruction& instruction);
+		void Op00FB(const Instruction& instruction);
+		void Op00FC(const Instruction& instruction);
+		void Op00FD(const Instruction& instruction);
+		void Op00FE(const Instruction& instruction);
+		void Op00FF(const Instruction& instruction);
+		void Op1nnn(const Instruction& instruction);
+		void Op2nnn(const Instruction& instruction);
+		void Op3xkk(const Instruction& instruction);
+		void Op4xkk(const Instruction& instruction);
+		void Op5xy0(const Instruction& instruction);
+		void Op5xy2(const Instruction& instruction);
+		void Op5xy3(const Instruction& instruction);
+		void Op6xkk(const Instruction& instruction);
+		void Op7xkk(const Instruction& instruction);
+		void Op8xy0(const Instruction& instruction);
+		template <typename Quirks>
+		void Op8xy1(const Instruction& instruction);
+		template <typename Quirks>
+		void Op8xy2(const Instruction& instruction);
+		template <typename Quirks>
+		void Op8xy3(const Instruction& instruction);
+		void Op8xy4(const Instruction& instruction);
+		void Op8xy5(const Instruction& instruction);
+		template <typename Quirks>
+		void Op8xy6(const Instruction& instruction);
+		void Op8xy7(const Instruction& instruction);
+		template <typename Quirks>
+		void Op8xyE(const Instruction& instruction);
+		void Op9xy0(const Instruction& instruction);
+		void OpAnnn(const Instruction& instruction);
+		template <typename Quirks>
+		void OpBnnn(const Instruction& instruction);
+		void OpCxkk(const Instruction& instruction);
+		template <typename Quirks>
+		void OpDxyn(const Instruction& instruction);
+		void OpEx9E(const Instruction& instruction);
+		void OpExA1(const Instruction& instruction);
+		void OpF000(const Instruction& instruction);
+		void OpFn01(const Instruction& instruction);
+		void OpF002(const Instruction& instruction);
+		void OpFx07(const Instruction& instruction);
+		void OpFx0A(const Instruction& instruction);
+		void OpFx15(const Instruction& instruction);
+		void OpFx18(const Instruction& instruction);
+		void OpFx1E(const Instruction& instruction);
+		void OpFx29(const Instruction& instruction);
+		void OpFx30(const Instruction& instruction);
+		void OpFx33(const Instruction& instruction);
+		void OpFx3A(const Instruction& instruction);
+		template <typename Quirks>
+		void OpFx55(const Instruction& instruction);
+		template <typename Quirks>
+		void OpFx65(const Instruction& instruction);
+		void OpFx75(const Instruction& instruction);
+		void OpFx85(const Instruction& instruction);
     
 	private:
 
@@ -66,8 +337,22 @@ class Interpreter
         int8_t m_stackPointer;
 		/** Holds the screen size (ex. 0x4020 = 64*32) */
 		ScreenSize m_screenSize;
-        /** Emulator RAM */
-        std::array<uint8_t, g_chipRamSize> m_memory;
+		/** Instruction set being emulated */
+		Platform m_platform;
+		/** Mask wrapping a data address to the memory of the platform */
+		uint16_t m_addressMask;
+		/** Behaviours the handlers were instantiated for */
+		QuirkProfile m_quirkProfile;
+		/** Handler lookup for m_quirkProfile */
+		HandlerLookup m_getHandler;
+#if CHIP8_THREADED_DISPATCH
+		/** Threaded engine for m_quirkProfile */
+		ThreadedEngine m_executeThreaded;
+#endif
+		/** Content hash of the loaded ROM */
+		uint64_t m_romHash;
+        /** Emulator RAM, sized to the address space of m_platform */
+        std::vector<uint8_t> m_memory;
         /** Emulator keyboard */
         std::array<uint8_t, g_chipKeyboardSize> m_keyboard;
         /** Emulator program counter, starts at byte 512 */
@@ -80,8 +365,34 @@ class Interpreter
         std::array<uint8_t, g_chipRegisterBankSize> m_registerV;
         /** Emulator fontset */
         std::array<uint8_t, g_chipFontsetSize> m_fontset;
-        /** Emulator screen buffer (ex. 64*32) */
-        std::unique_ptr<uint8_t[]> m_pScreenBuffer;
+        /** SUPER-CHIP flag registers, kept across Fx75 and Fx85 */
+        std::array<uint8_t, g_chipFlagRegisterCount> m_flagRegisters;
+        /** XO-CHIP audio pattern */
+        std::array<uint8_t, g_xoAudioPatternSize> m_audioPattern;
+        /** XO-CHIP pitch register */
+        uint8_t m_pitch;
+        /** Emulator screen buffer (ex. 64*32), one bit per pixel */
+        Framebuffer m_framebuffer;
+        /** Decoded instruction cache, one entry per even address */
+        std::array<DecodedInstruction, g_chipRamSize / g_chipInstructionSize> m_decodedInstructions;
+        /** Number of instructions executed since construction */
+        uint64_t m_cycleCount;
+        /** Instructions of m_cycleCount that were skipped in a wait loop instead of executed */
+        uint64_t m_idleCycleCount;
+        /** Execute() skips the iterations of wait loops */
+        bool m_isSkippingIdle;
+        /** Source of Cxkk, owned per instance so runs are reproducible */
+        Random m_random;
+        /** Told when the beeper turns on or off, may be null */
+        SoundListener* m_pSoundListener;
+        /** Recompiler used by Execute(), null when interpreting */
+        std::unique_ptr<Recompiler> m_pRecompiler;
+        /** Ahead of time engine used by Execute(), null unless selected */
+        std::unique_ptr<AotEngine> m_pAotEngine;
+#if CHIP8_PROFILER
+        /** Profiler counting every instruction, null when not profiling */
+        Profiler* m_pProfiler;
+#endif
 
 }; // Interpreter
 
@@ -0,0 +1,672 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include "LockstepEngine.hpp"
+#include "RomCache.hpp"
+
+/**
+	Default Constructor
+
+	@param[in] laneCount Number of machines to run in lockstep.
+ */
+LockstepEngine::LockstepEngine(uint32_t laneCount) :
+	m_laneCount(laneCount),
+	m_paddedLaneCount((laneCount + g_simdLaneAlignment - 1) / g_simdLaneAlignment * g_simdLaneAlignment),
+	m_cycleCount(0)
+{
+	m_memory.assign(g_chipRamSize * m_paddedLaneCount, 0x00);
+	m_registers.assign(g_chipRegisterBankSize * m_paddedLaneCount, 0x00);
+	m_stack.assign(g_chipStackSize * m_paddedLaneCount, 0x0000);
+	m_keyboard.assign(g_chipKeyboardSize * m_paddedLaneCount, 0x00);
+	m_programCounter.assign(m_paddedLaneCount, 0x0200);
+	m_I.assign(m_paddedLaneCount, 0x0000);
+	m_stackPointer.assign(m_paddedLaneCount, -1);
+	m_delayTimer.assign(m_paddedLaneCount, 0x00);
+	m_soundTimer.assign(m_paddedLaneCount, 0x00);
+	m_random.resize(m_paddedLaneCount);
+	SetRandomSeed(g_defaultRandomSeed);
+	m_pendingLanes.assign(m_paddedLaneCount, 0x00);
+	m_groupLanes.assign(m_paddedLaneCount, 0x00);
+
+	m_activeLanes.assign(m_paddedLaneCount, 0x00);
+	std::fill(m_activeLanes.begin(), m_activeLanes.begin() + m_laneCount, 0xFF);
+
+	uint16_t height = static_cast<uint16_t>(ScreenSize::Chip8) & 0x00FF;
+	m_screen.assign(height * m_paddedLaneCount, 0);
+
+	Instruction undecoded = DecodeInstruction(0x0000);
+	undecoded.operation = Operation::Undecoded;
+	m_decoded.fill(undecoded);
+};
+
+/**
+	Default Destructor
+ */
+LockstepEngine::~LockstepEngine()
+{
+};
+
+/**
+	Loads the fontset and the same ROM in to every lane.
+
+	@param[in] filePath Path to the ROM file to load.
+	@return false if the ROM could not be read or does not fit in memory.
+ */
+bool LockstepEngine::Initialize(const char* filePath)
+{
+	RomStatus status;
+	std::shared_ptr<const Rom> pRom = RomCache::GetInstance().Load(filePath, g_chipRomMaxSize, status);
+	if (status == RomStatus::TooLarge)
+	{
+		printf("File to large, a ROM can be at most %u bytes\n", g_chipRomMaxSize);
+		return false;
+	};
+
+	if (!pRom)
+	{
+		printf("Failed to open %s\n", filePath);
+		return false;
+	};
+	const std::vector<uint8_t>& rom = pRom->data;
+
+	for (uint16_t address = 0; address < g_chipFontsetSize; address++)
+	{
+		std::fill_n(GetMemoryRow(address), m_paddedLaneCount, g_chipFontset[address]);
+	};
+
+	for (uint16_t i = 0; i < rom.size(); i++)
+	{
+		std::fill_n(GetMemoryRow(0x0200 + i), m_paddedLaneCount, rom[i]);
+	};
+
+	return true;
+};
+
+/**
+	Runs every lane for a number of instructions.
+
+	@param[in] cycles Number of instructions each lane executes.
+	@return Number of instructions each lane executed.
+ */
+uint32_t LockstepEngine::Execute(uint32_t cycles)
+{
+	for (uint32_t i = 0; i < cycles; i++)
+	{
+		Step();
+	};
+
+	m_cycleCount += cycles;
+	return cycles;
+};
+
+/**
+	Counts the delay and sound timers of every lane down by one, see Interpreter::TickTimers().
+ */
+void LockstepEngine::TickTimers()
+{
+	const SimdVector one = SimdSetU8(0x01);
+	for (uint32_t i = 0; i < m_paddedLaneCount; i += g_simdBytes)
+	{
+		SimdStore(&m_delayTimer[i], SimdSubSaturateU8(SimdLoad(&m_delayTimer[i]), one));
+		SimdStore(&m_soundTimer[i], SimdSubSaturateU8(SimdLoad(&m_soundTimer[i]), one));
+	};
+};
+
+/**
+	Retrieve the number of machines.
+ */
+uint32_t LockstepEngine::GetLaneCount() const
+{
+	return m_laneCount;
+};
+
+/**
+	Retrieve the number of instructions every lane executed.
+ */
+uint64_t LockstepEngine::GetCycleCount() const
+{
+	return m_cycleCount;
+};
+
+/**
+	Sets a register of one lane, used to give lanes different inputs.
+
+	@param[in] lane Index of the lane.
+	@param[in] index Register index, 0x0 to 0xF.
+	@param[in] value Value to store.
+ */
+void LockstepEngine::SetRegister(uint32_t lane, uint8_t index, uint8_t value)
+{
+	m_registers[(index & 0x0F) * m_paddedLaneCount + lane] = value;
+};
+
+/**
+	Retrieve a register of one lane.
+
+	@param[in] lane Index of the lane.
+	@param[in] index Register index, 0x0 to 0xF.
+ */
+uint8_t LockstepEngine::GetRegister(uint32_t lane, uint8_t index) const
+{
+	return m_registers[(index & 0x0F) * m_paddedLaneCount + lane];
+};
+
+/**
+	Seeds the random generators, lane n gets seed + n.\n
+	Lane 0 draws the same numbers as an Interpreter given the same seed.
+
+	@param[in] seed Seed of lane 0.
+ */
+void LockstepEngine::SetRandomSeed(uint64_t seed)
+{
+	for (uint32_t lane = 0; lane < m_random.size(); lane++)
+	{
+		m_random[lane].Seed(seed + lane);
+	};
+};
+
+/**
+	Sets pressed key of one lane to 0x01
+
+	@param[in] lane Index of the lane.
+	@param[in] keyIndex of key in keyboard array.
+ */
+void LockstepEngine::OnKeyPressed(uint32_t lane, uint8_t keyIndex)
+{
+	m_keyboard[(keyIndex & 0x0F) * m_paddedLaneCount + lane] = 0x01;
+};
+
+/**
+	Sets the released key of one lane to 0x00
+
+	@param[in] lane Index of the lane.
+	@param[in] keyIndex of key in keyboard array.
+ */
+void LockstepEngine::OnKeyReleased(uint32_t lane, uint8_t keyIndex)
+{
+	m_keyboard[(keyIndex & 0x0F) * m_paddedLaneCount + lane] = 0x00;
+};
+
+/**
+	Computes a hash over the state of one lane.\n
+	Hashes the same fields in the same order as Interpreter::GetStateHash(),
+	so a lane can be compared against an interpreter running the same ROM.
+
+	@param[in] lane Index of the lane.
+ */
+uint64_t LockstepEngine::GetStateHash(uint32_t lane) const
+{
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	auto mix = [&hash](const uint8_t* pData, size_t size)
+	{
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ pData[i]) * 0x100000001B3ULL;
+		};
+	};
+	auto mixStrided = [&](const uint8_t* pData, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			mix(&pData[i * m_paddedLaneCount + lane], 1);
+		};
+	};
+
+	mixStrided(m_memory.data(), g_chipRamSize);
+	mixStrided(m_registers.data(), g_chipRegisterBankSize);
+	for (uint32_t i = 0; i < g_chipStackSize; i++)
+	{
+		mix(reinterpret_cast<const uint8_t*>(&m_stack[i * m_paddedLaneCount + lane]), sizeof(uint16_t));
+	};
+	mix(reinterpret_cast<const uint8_t*>(&m_I[lane]), sizeof(uint16_t));
+	mix(reinterpret_cast<const uint8_t*>(&m_programCounter[lane]), sizeof(uint16_t));
+	mix(reinterpret_cast<const uint8_t*>(&m_stackPointer[lane]), sizeof(int8_t));
+	mix(&m_delayTimer[lane], sizeof(uint8_t));
+	mix(&m_soundTimer[lane], sizeof(uint8_t));
+	for (size_t row = 0; row < m_screen.size() / m_paddedLaneCount; row++)
+	{
+		mix(reinterpret_cast<const uint8_t*>(&m_screen[row * m_paddedLaneCount + lane]), sizeof(uint64_t));
+	};
+	return hash;
+};
+
+/**
+	Executes one instruction on every lane.\n
+	Lanes are grouped by program counter and opcode, the first pending lane
+	leads each group.
+ */
+void LockstepEngine::Step()
+{
+	std::copy(m_activeLanes.begin(), m_activeLanes.end(), m_pendingLanes.begin());
+
+	uint32_t chunk = 0;
+	while (chunk < m_paddedLaneCount)
+	{
+		uint32_t pending = SimdMoveMask(SimdLoad(&m_pendingLanes[chunk]));
+		if (pending == 0)
+		{
+			chunk += g_simdBytes;
+			continue;
+		};
+
+		uint32_t leader = chunk + CountTrailingZeros(pending);
+		uint16_t address = BuildGroup(leader);
+		uint16_t opcode = (GetMemory(leader, address) << 8) | GetMemory(leader, address + 1);
+
+		Instruction& instruction = m_decoded[address];
+		if (instruction.operation == Operation::Undecoded || instruction.opcode != opcode)
+		{
+			instruction = DecodeInstruction(opcode);
+		};
+
+		ExecuteGroup(address, instruction);
+	};
+};
+
+/**
+	Selects every pending lane at the leader's program counter with the same opcode.
+
+	@param[in] leader Lane whose instruction the group executes.
+	@return Address of the instruction the group executes.
+ */
+uint16_t LockstepEngine::BuildGroup(uint32_t leader)
+{
+	uint16_t address = m_programCounter[leader] & g_chipAddressMask;
+	const SimdVector opcodeHigh = SimdSetU8(GetMemory(leader, address));
+	const SimdVector opcodeLow = SimdSetU8(GetMemory(leader, address + 1));
+	const SimdVector addressMask = SimdSetU16(g_chipAddressMask);
+	const SimdVector addressValue = SimdSetU16(address);
+	const uint8_t* pHigh = GetMemoryRow(address);
+	const uint8_t* pLow = GetMemoryRow(address + 1);
+
+	for (uint32_t i = 0; i < m_paddedLaneCount; i += g_simdBytes)
+	{
+		SimdVector pending = SimdLoad(&m_pendingLanes[i]);
+		SimdVector pcLow = SimdEqualU16(SimdAnd(SimdLoad(&m_programCounter[i]), addressMask), addressValue);
+		SimdVector pcHigh = SimdEqualU16(SimdAnd(SimdLoad(&m_programCounter[i + g_simdBytes / 2]), addressMask), addressValue);
+		SimdVector group = SimdAnd(pending, SimdNarrowMask(pcLow, pcHigh));
+		group = SimdAnd(group, SimdEqualU8(SimdLoad(&pHigh[i]), opcodeHigh));
+		group = SimdAnd(group, SimdEqualU8(SimdLoad(&pLow[i]), opcodeLow));
+
+		SimdStore(&m_groupLanes[i], group);
+		SimdStore(&m_pendingLanes[i], SimdAndNot(group, pending));
+	};
+
+	return address;
+};
+
+/**
+	Calls kernel(chunk, mask) for every vector of lanes with at least one lane in the group.
+ */
+template <typename Kernel>
+void LockstepEngine::ForEachChunk(Kernel kernel)
+{
+	for (uint32_t i = 0; i < m_paddedLaneCount; i += g_simdBytes)
+	{
+		SimdVector mask = SimdLoad(&m_groupLanes[i]);
+		if (SimdMoveMask(mask) != 0)
+		{
+			kernel(i, mask);
+		};
+	};
+};
+
+/**
+	Calls function(lane) for every lane in the group.
+ */
+template <typename Function>
+void LockstepEngine::ForEachLane(Function function)
+{
+	for (uint32_t i = 0; i < m_paddedLaneCount; i += g_simdBytes)
+	{
+		uint32_t bits = SimdMoveMask(SimdLoad(&m_groupLanes[i]));
+		while (bits != 0)
+		{
+			function(i + CountTrailingZeros(bits));
+			bits &= bits - 1;
+		};
+	};
+};
+
+/**
+	Sets the program counter of the masked lanes in a chunk.
+ */
+void LockstepEngine::StoreProgramCounter(uint32_t chunk, SimdVector mask, uint16_t value)
+{
+	const SimdVector pc = SimdSetU16(value);
+	uint16_t* pLow = &m_programCounter[chunk];
+	uint16_t* pHigh = &m_programCounter[chunk + g_simdBytes / 2];
+	SimdStore(pLow, SimdBlend(SimdWidenLowMask(mask), SimdLoad(pLow), pc));
+	SimdStore(pHigh, SimdBlend(SimdWidenHighMask(mask), SimdLoad(pHigh), pc));
+};
+
+/**
+	Advances the masked lanes in a chunk past the instruction, skipping the next one where condition is set.
+ */
+void LockstepEngine::StoreSkip(uint32_t chunk, SimdVector mask, SimdVector condition, uint16_t address)
+{
+	const SimdVector next = SimdSetU16(address + g_chipInstructionSize);
+	const SimdVector skip = SimdSetU16(address + g_chipInstructionSize * 2);
+	uint16_t* pLow = &m_programCounter[chunk];
+	uint16_t* pHigh = &m_programCounter[chunk + g_simdBytes / 2];
+	SimdVector low = SimdBlend(SimdWidenLowMask(condition), next, skip);
+	SimdVector high = SimdBlend(SimdWidenHighMask(condition), next, skip);
+	SimdStore(pLow, SimdBlend(SimdWidenLowMask(mask), SimdLoad(pLow), low));
+	SimdStore(pHigh, SimdBlend(SimdWidenHighMask(mask), SimdLoad(pHigh), high));
+};
+
+/**
+	Executes one instruction for every lane in m_groupLanes.\n
+	Register, timer and control flow operations run as SIMD kernels, the
+	remaining operations are executed lane by lane.
+
+	@param[in] address Address of the instruction.
+	@param[in] instruction The decoded instruction.
+ */
+void LockstepEngine::ExecuteGroup(uint16_t address, const Instruction& instruction)
+{
+	const uint16_t next = address + g_chipInstructionSize;
+	const SimdVector one = SimdSetU8(0x01);
+	uint8_t* pX = GetRegisterRow(instruction.x);
+	uint8_t* pY = GetRegisterRow(instruction.y);
+	uint8_t* pF = GetRegisterRow(0x0F);
+
+	// Register operations, result is stored in Vx and the flag in VF after it.
+	auto arithmetic = [&](auto operation, bool writesFlag)
+	{
+		ForEachChunk([&](uint32_t i, SimdVector mask)
+		{
+			SimdVector x = SimdLoad(&pX[i]);
+			SimdVector flag = SimdZero();
+			SimdVector result = operation(x, SimdLoad(&pY[i]), flag);
+			SimdStore(&pX[i], SimdBlend(mask, x, result));
+			if (writesFlag)
+			{
+				SimdStore(&pF[i], SimdBlend(mask, SimdLoad(&pF[i]), flag));
+			};
+			StoreProgramCounter(i, mask, next);
+		});
+	};
+
+	// Conditional skips.
+	auto skip = [&](auto condition)
+	{
+		ForEachChunk([&](uint32_t i, SimdVector mask)
+		{
+			StoreSkip(i, mask, condition(SimdLoad(&pX[i]), SimdLoad(&pY[i])), address);
+		});
+	};
+
+	// Moves between a register and a per lane byte array.
+	auto move = [&](uint8_t* pDestination, const uint8_t* pSource)
+	{
+		ForEachChunk([&](uint32_t i, SimdVector mask)
+		{
+			SimdStore(&pDestination[i], SimdBlend(mask, SimdLoad(&pDestination[i]), SimdLoad(&pSource[i])));
+			StoreProgramCounter(i, mask, next);
+		});
+	};
+
+	const SimdVector kk = SimdSetU8(instruction.kk);
+	const SimdVector allOnes = SimdSetU8(0xFF);
+
+	switch (instruction.operation)
+	{
+		case Operation::Unknown:
+			ForEachChunk([&](uint32_t i, SimdVector mask) { StoreProgramCounter(i, mask, next); });
+			break;
+
+		case Operation::Op1nnn:
+			ForEachChunk([&](uint32_t i, SimdVector mask) { StoreProgramCounter(i, mask, instruction.nnn); });
+			break;
+
+		case Operation::Op3xkk:
+			skip([&](SimdVector x, SimdVector) { return SimdEqualU8(x, kk); });
+			break;
+
+		case Operation::Op4xkk:
+			skip([&](SimdVector x, SimdVector) { return SimdXor(SimdEqualU8(x, kk), allOnes); });
+			break;
+
+		case Operation::Op5xy0:
+			skip([&](SimdVector x, SimdVector y) { return SimdEqualU8(x, y); });
+			break;
+
+		case Operation::Op9xy0:
+			skip([&](SimdVector x, SimdVector y) { return SimdXor(SimdEqualU8(x, y), allOnes); });
+			break;
+
+		case Operation::Op6xkk:
+			arithmetic([&](SimdVector, SimdVector, SimdVector&) { return kk; }, false);
+			break;
+
+		case Operation::Op7xkk:
+			arithmetic([&](SimdVector x, SimdVector, SimdVector&) { return SimdAddU8(x, kk); }, false);
+			break;
+
+		case Operation::Op8xy0:
+			arithmetic([&](SimdVector, SimdVector y, SimdVector&) { return y; }, false);
+			break;
+
+		case Operation::Op8xy1:
+			arithmetic([&](SimdVector x, SimdVector y, SimdVector&) { return SimdOr(x, y); }, false);
+			break;
+
+		case Operation::Op8xy2:
+			arithmetic([&](SimdVector x, SimdVector y, SimdVector&) { return SimdAnd(x, y); }, false);
+			break;
+
+		case Operation::Op8xy3:
+			arithmetic([&](SimdVector x, SimdVector y, SimdVector&) { return SimdXor(x, y); }, false);
+			break;
+
+		case Operation::Op8xy4:
+			arithmetic([&](SimdVector x, SimdVector y, SimdVector& flag)
+			{
+				SimdVector sum = SimdAddU8(x, y);
+				// No carry when sum >= x.
+				flag = SimdAndNot(SimdEqualU8(SimdMaxU8(sum, x), sum), one);
+				return sum;
+			}, true);
+			break;
+
+		case Operation::Op8xy5:
+			arithmetic([&](SimdVector x, SimdVector y, SimdVector& flag)
+			{
+				flag = SimdAnd(SimdEqualU8(SimdMaxU8(x, y), x), one);
+				return SimdSubU8(x, y);
+			}, true);
+			break;
+
+		case Operation::Op8xy6:
+			arithmetic([&](SimdVector x, SimdVector, SimdVector& flag)
+			{
+				flag = SimdAnd(x, one);
+				return SimdAnd(SimdShiftRightU16(x, 1), SimdSetU8(0x7F));
+			}, true);
+			break;
+
+		case Operation::Op8xy7:
+			arithmetic([&](SimdVector x, SimdVector y, SimdVector& flag)
+			{
+				flag = SimdAnd(SimdEqualU8(SimdMaxU8(y, x), y), one);
+				return SimdSubU8(y, x);
+			}, true);
+			break;
+
+		case Operation::Op8xyE:
+			arithmetic([&](SimdVector x, SimdVector, SimdVector& flag)
+			{
+				flag = SimdAnd(SimdShiftRightU16(x, 7), one);
+				return SimdAddU8(x, x);
+			}, true);
+			break;
+
+		case Operation::OpAnnn:
+		{
+			const SimdVector nnn = SimdSetU16(instruction.nnn);
+			ForEachChunk([&](uint32_t i, SimdVector mask)
+			{
+				uint16_t* pLow = &m_I[i];
+				uint16_t* pHigh = &m_I[i + g_simdBytes / 2];
+				SimdStore(pLow, SimdBlend(SimdWidenLowMask(mask), SimdLoad(pLow), nnn));
+				SimdStore(pHigh, SimdBlend(SimdWidenHighMask(mask), SimdLoad(pHigh), nnn));
+				StoreProgramCounter(i, mask, next);
+			});
+		}
+			break;
+
+		case Operation::OpFx07:
+			move(pX, m_delayTimer.data());
+			break;
+
+		case Operation::OpFx15:
+			move(m_delayTimer.data(), pX);
+			break;
+
+		case Operation::OpFx18:
+			move(m_soundTimer.data(), pX);
+			break;
+
+		case Operation::OpFx1E:
+			ForEachChunk([&](uint32_t i, SimdVector mask)
+			{
+				SimdVector x = SimdLoad(&pX[i]);
+				uint16_t* pLow = &m_I[i];
+				uint16_t* pHigh = &m_I[i + g_simdBytes / 2];
+				SimdVector low = SimdLoad(pLow);
+				SimdVector high = SimdLoad(pHigh);
+				SimdStore(pLow, SimdBlend(SimdWidenLowMask(mask), low, SimdAddU16(low, SimdWidenLowU8(x))));
+				SimdStore(pHigh, SimdBlend(SimdWidenHighMask(mask), high, SimdAddU16(high, SimdWidenHighU8(x))));
+				StoreProgramCounter(i, mask, next);
+			});
+			break;
+
+		default:
+			ForEachLane([&](uint32_t lane) { ExecuteLane(lane, address, instruction); });
+			break;
+	};
+};
+
+/**
+	Executes an instruction on a single lane, for operations without a SIMD kernel.
+	Mirrors the Interpreter handlers.
+
+	@param[in] lane Index of the lane.
+	@param[in] address Address of the instruction.
+	@param[in] instruction The decoded instruction.
+ */
+void LockstepEngine::ExecuteLane(uint32_t lane, uint16_t address, const Instruction& instruction)
+{
+	const uint32_t lanes = m_paddedLaneCount;
+	uint16_t& pc = m_programCounter[lane];
+	uint16_t& I = m_I[lane];
+	int8_t& sp = m_stackPointer[lane];
+	uint8_t& vx = m_registers[instruction.x * lanes + lane];
+	uint8_t& vf = m_registers[0x0F * lanes + lane];
+
+	pc = address + g_chipInstructionSize;
+
+	switch (instruction.operation)
+	{
+		case Operation::Op00E0:
+			for (size_t row = lane; row < m_screen.size(); row += lanes)
+			{
+				m_screen[row] = 0;
+			};
+			break;
+
+		case Operation::Op00EE:
+			pc = m_stack[(sp & g_chipStackMask) * lanes + lane];
+			sp = GetStackPointerAfterReturn(sp);
+			break;
+
+		case Operation::Op2nnn:
+			sp = GetStackPointerAfterCall(sp);
+			m_stack[sp * lanes + lane] = pc;
+			pc = instruction.nnn;
+			break;
+
+		case Operation::OpBnnn:
+			pc = instruction.nnn + m_registers[lane];
+			break;
+
+		case Operation::OpCxkk:
+			vx = m_random[lane].NextByte() & instruction.kk;
+			break;
+
+		case Operation::OpDxyn:
+		{
+			// Same wrapping and clipping as Framebuffer::DrawSprite() on a 64 pixel wide screen.
+			const uint16_t width = static_cast<uint16_t>(ScreenSize::Chip8) >> 8;
+			const uint16_t height = static_cast<uint16_t>(ScreenSize::Chip8) & 0x00FF;
+			uint16_t posX = vx % width;
+			uint16_t posY = m_registers[instruction.y * lanes + lane] % height;
+
+			uint64_t collision = 0;
+			for (uint16_t y = 0; y < instruction.n && posY + y < height; y++)
+			{
+				uint64_t bits = (static_cast<uint64_t>(GetMemory(lane, I + y)) << 56) >> posX;
+				uint64_t& row = m_screen[(posY + y) * lanes + lane];
+				collision |= row & bits;
+				row ^= bits;
+			};
+			vf = collision != 0 ? 0x01 : 0x00;
+		}
+			break;
+
+		case Operation::OpEx9E:
+			pc += m_keyboard[(m_registers[instruction.x * lanes + lane] & 0x0F) * lanes + lane] != 0 ? g_chipInstructionSize : 0;
+			break;
+
+		case Operation::OpExA1:
+			pc += m_keyboard[(m_registers[instruction.x * lanes + lane] & 0x0F) * lanes + lane] == 0 ? g_chipInstructionSize : 0;
+			break;
+
+		case Operation::OpFx0A:
+		{
+			bool isKeyPressed = false;
+			for (uint8_t i = 0; i < g_chipKeyboardSize && !isKeyPressed; i++)
+			{
+				if (m_keyboard[i * lanes + lane] == 0x01)
+				{
+					vx = i;
+					isKeyPressed = true;
+				};
+			};
+
+			if (!isKeyPressed)
+			{
+				pc -= g_chipInstructionSize;
+			};
+		}
+			break;
+
+		case Operation::OpFx29:
+			I = (vx & 0x0F) * 5;
+			break;
+
+		case Operation::OpFx33:
+			GetMemory(lane, I) = (vx / 100) % 10;
+			GetMemory(lane, I + 1) = (vx / 10) % 10;
+			GetMemory(lane, I + 2) = vx % 10;
+			break;
+
+		case Operation::OpFx55:
+			for (uint8_t i = 0; i <= instruction.x; i++)
+			{
+				GetMemory(lane, I + i) = m_registers[i * lanes + lane];
+			};
+			break;
+
+		case Operation::OpFx65:
+			for (uint8_t i = 0; i <= instruction.x; i++)
+			{
+				m_registers[i * lanes + lane] = GetMemory(lane, I + i);
+			};
+			break;
+
+		default:
+			break;
+	};
+};
@@ -0,0 +1,107 @@
+#ifndef LOCKSTEPENGINE_HPP_INCLUDED
+#define LOCKSTEPENGINE_HPP_INCLUDED
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "Instruction.hpp"
+#include "Interpreter.hpp"
+#include "Random.hpp"
+#include "Simd.hpp"
+
+/**
+	Runs many Chip8 machines in lockstep with their state stored as a
+	structure of arrays.\n
+	Every piece of state is an array with one entry per machine (lane), so V3
+	of all lanes is contiguous in memory. Each step finds the lanes sharing the
+	same program counter and opcode and executes that instruction for all of
+	them at once with SIMD kernels, masking out the other lanes. Lanes that
+	diverge are stepped as separate groups. Meant for parameter sweeps where
+	many machines run the same ROM with different inputs.
+ */
+class LockstepEngine
+{
+	public:
+
+		explicit LockstepEngine(uint32_t laneCount);
+		~LockstepEngine();
+
+		bool Initialize(const char* filePath);
+		uint32_t Execute(uint32_t cycles);
+		void TickTimers();
+
+		uint32_t GetLaneCount() const;
+		uint64_t GetCycleCount() const;
+
+		void SetRegister(uint32_t lane, uint8_t index, uint8_t value);
+		uint8_t GetRegister(uint32_t lane, uint8_t index) const;
+
+		void SetRandomSeed(uint64_t seed);
+
+		void OnKeyPressed(uint32_t lane, uint8_t keyIndex);
+		void OnKeyReleased(uint32_t lane, uint8_t keyIndex);
+
+		uint64_t GetStateHash(uint32_t lane) const;
+
+	private:
+
+		void Step();
+		uint16_t BuildGroup(uint32_t leader);
+		void ExecuteGroup(uint16_t address, const Instruction& instruction);
+		void ExecuteLane(uint32_t lane, uint16_t address, const Instruction& instruction);
+
+		template <typename Kernel>
+		void ForEachChunk(Kernel kernel);
+		template <typename Function>
+		void ForEachLane(Function function);
+
+		void StoreProgramCounter(uint32_t chunk, SimdVector mask, uint16_t value);
+		void StoreSkip(uint32_t chunk, SimdVector mask, SimdVector condition, uint16_t address);
+
+		uint8_t* GetRegisterRow(uint8_t index) { return &m_registers[index * m_paddedLaneCount]; };
+		uint8_t* GetMemoryRow(uint16_t address) { return &m_memory[(address & g_chipAddressMask) * m_paddedLaneCount]; };
+		uint8_t& GetMemory(uint32_t lane, uint16_t address) { return m_memory[(address & g_chipAddressMask) * m_paddedLaneCount + lane]; };
+
+	private:
+
+		/** Number of machines */
+		uint32_t m_laneCount;
+		/** Number of lanes including padding up to a whole vector */
+		uint32_t m_paddedLaneCount;
+		/** Instructions executed by every lane */
+		uint64_t m_cycleCount;
+		/** Emulator RAM, [address][lane] */
+		std::vector<uint8_t> m_memory;
+		/** Registers V0 to VF, [register][lane] */
+		std::vector<uint8_t> m_registers;
+		/** Stack, [slot][lane] */
+		std::vector<uint16_t> m_stack;
+		/** Keyboard, [key][lane] */
+		std::vector<uint8_t> m_keyboard;
+		/** Screen buffer, one bit per pixel, [row][lane] */
+		std::vector<uint64_t> m_screen;
+		/** Program counters */
+		std::vector<uint16_t> m_programCounter;
+		/** Index registers */
+		std::vector<uint16_t> m_I;
+		/** Stack pointers */
+		std::vector<int8_t> m_stackPointer;
+		/** Delay timers */
+		std::vector<uint8_t> m_delayTimer;
+		/** Sound timers */
+		std::vector<uint8_t> m_soundTimer;
+		/** Random generator per lane, for Cxkk */
+		std::vector<Random> m_random;
+		/** 0xFF for real lanes, 0x00 for padding */
+		std::vector<uint8_t> m_activeLanes;
+		/** Lanes that still have to execute in the current step */
+		std::vector<uint8_t> m_pendingLanes;
+		/** Lanes executing the current group */
+		std::vector<uint8_t> m_groupLanes;
+		/** Decoded instruction per address, reused while the opcode matches */
+		std::array<Instruction, g_chipRamSize> m_decoded;
+
+}; // LockstepEngine
+
+#endif // LOCKSTEPENGINE_HPP_INCLUDED
@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <cstdio>
+#include "Movie.hpp"
+#include "StateBuffer.hpp"
+
+namespace
+{
+	/** Magic, version, seed, end cycle, end state hash and event count */
+	constexpr size_t g_movieHeaderSize = 4 + 2 + 8 + 8 + 8 + 4;
+	/** Largest encoded event, a 64-bit delta takes ten bytes plus the event byte */
+	constexpr size_t g_movieMaxEventSize = 11;
+}
+
+/**
+	Default Constructor
+ */
+Movie::Movie() : m_seed(g_defaultRandomSeed), m_endCycle(0), m_endStateHash(0)
+{
+};
+
+/**
+	Drops any previous recording and starts a new one.
+
+	@param[in] seed Random seed the interpreter was given.
+ */
+void Movie::Start(uint64_t seed)
+{
+	m_seed = seed;
+	m_endCycle = 0;
+	m_endStateHash = 0;
+	m_entries.clear();
+};
+
+/**
+	Appends an input, cycles must not decrease between calls.
+
+	@param[in] cycle Cycle count of the interpreter when the input arrived.
+	@param[in] event What happened.
+	@param[in] key Key index for key events.
+ */
+void Movie::Record(uint64_t cycle, MovieEvent event, uint8_t key)
+{
+	MovieEntry entry;
+	entry.cycle = cycle;
+	entry.event = event;
+	entry.key = key & (g_chipKeyboardSize - 1);
+	m_entries.push_back(entry);
+};
+
+/**
+	Stores where the recording ended, so a replay can check it got there.
+
+	@param[in] interpreter Interpreter that was recorded.
+ */
+void Movie::Finish(const Interpreter& interpreter)
+{
+	m_endCycle = interpreter.GetCycleCount();
+	m_endStateHash = interpreter.GetStateHash();
+};
+
+/**
+	Plays the movie back on a freshly initialized interpreter.\n
+	Every input is applied at exactly the cycle it was recorded at.
+
+	@param[in] interpreter Interpreter with the recorded ROM loaded and nothing executed.
+	@return true if the interpreter ended in the recorded state.
+ */
+bool Movie::Replay(Interpreter& interpreter) const
+{
+	interpreter.SetRandomSeed(m_seed);
+
+	auto runTo = [&interpreter](uint64_t cycle)
+	{
+		while (interpreter.GetCycleCount() < cycle)
+		{
+			uint64_t remaining = cycle - interpreter.GetCycleCount();
+			interpreter.Execute(static_cast<uint32_t>(std::min<uint64_t>(remaining, UINT32_MAX)));
+		};
+	};
+
+	for (const MovieEntry& entry : m_entries)
+	{
+		runTo(entry.cycle);
+		switch (entry.event)
+		{
+			case MovieEvent::KeyPressed:
+				interpreter.OnKeyPressed(entry.key);
+				break;
+
+			case MovieEvent::KeyReleased:
+				interpreter.OnKeyReleased(entry.key);
+				break;
+
+			case MovieEvent::Frame:
+				interpreter.TickTimers();
+				break;
+		};
+	};
+
+	runTo(m_endCycle);
+	return interpreter.GetCycleCount() == m_endCycle && interpreter.GetStateHash() == m_endStateHash;
+};
+
+/**
+	Writes the movie to a file.
+
+	@param[in] filePath Path of the file to write.
+	@return false if the file could not be written.
+ */
+bool Movie::Save(const char* filePath) const
+{
+	std::vector<uint8_t> buffer(g_movieHeaderSize + m_entries.size() * g_movieMaxEventSize);
+	StateWriter writer(buffer.data(), buffer.size());
+	writer.WriteU32(g_movieMagic);
+	writer.WriteU16(g_movieVersion);
+	writer.WriteU64(m_seed);
+	writer.WriteU64(m_endCycle);
+	writer.WriteU64(m_endStateHash);
+	writer.WriteU32(static_cast<uint32_t>(m_entries.size()));
+
+	// Cycles are stored as the distance to the previous event, seven bits per byte.
+	uint64_t previousCycle = 0;
+	for (const MovieEntry& entry : m_entries)
+	{
+		uint64_t delta = entry.cycle - previousCycle;
+		previousCycle = entry.cycle;
+		while (delta >= 0x80)
+		{
+			writer.WriteU8(static_cast<uint8_t>(delta) | 0x80);
+			delta >>= 7;
+		};
+		writer.WriteU8(static_cast<uint8_t>(delta));
+		writer.WriteU8(static_cast<uint8_t>(static_cast<uint8_t>(entry.event) << 4 | entry.key));
+	};
+
+	FILE* pFile = std::fopen(filePath, "wb");
+	if (pFile == nullptr)
+	{
+		return false;
+	};
+
+	bool isWritten = writer.IsValid() && std::fwrite(buffer.data(), 1, writer.GetOffset(), pFile) == writer.GetOffset();
+	std::fclose(pFile);
+	return isWritten;
+};
+
+/**
+	Reads a movie written by Save().\n
+	The movie is left untouched if the file is not a valid movie.
+
+	@param[in] filePath Path of the file to read.
+	@return false if the file could not be read or is not a movie.
+ */
+bool Movie::Load(const char* filePath)
+{
+	FILE* pFile = std::fopen(filePath, "rb");
+	if (pFile == nullptr)
+	{
+		return false;
+	};
+
+	std::vector<uint8_t> buffer;
+	uint8_t chunk[4096];
+	size_t size;
+	while ((size = std::fread(chunk, 1, sizeof(chunk), pFile)) > 0)
+	{
+		buffer.insert(buffer.end(), chunk, chunk + size);
+	};
+	std::fclose(pFile);
+
+	StateReader reader(buffer.data(), buffer.size());
+	uint32_t magic = reader.ReadU32();
+	uint16_t version = reader.ReadU16();
+	uint64_t seed = reader.ReadU64();
+	uint64_t endCycle = reader.ReadU64();
+	uint64_t endStateHash = reader.ReadU64();
+	uint32_t count = reader.ReadU32();
+
+	// Every event takes at least two bytes.
+	if (!reader.IsValid() || magic != g_movieMagic || version != g_movieVersion || count > (buffer.size() - g_movieHeaderSize) / 2)
+	{
+		return false;
+	};
+
+	std::vector<MovieEntry> entries(count);
+	uint64_t cycle = 0;
+	for (MovieEntry& entry : entries)
+	{
+		uint64_t delta = 0;
+		uint8_t byte;
+		uint32_t shift = 0;
+		do
+		{
+			byte = reader.ReadU8();
+			delta |= static_cast<uint64_t>(byte & 0x7F) << shift;
+			shift += 7;
+		}
+		while ((byte & 0x80) != 0 && shift < 64);
+
+		uint8_t packed = reader.ReadU8();
+		cycle += delta;
+		entry.cycle = cycle;
+		entry.event = static_cast<MovieEvent>(packed >> 4);
+		entry.key = packed & 0x0F;
+
+		if (!reader.IsValid() || (byte & 0x80) != 0 || entry.event > MovieEvent::Frame || entry.cycle > endCycle)
+		{
+			return false;
+		};
+	};
+
+	m_seed = seed;
+	m_endCycle = endCycle;
+	m_endStateHash = endStateHash;
+	m_entries = std::move(entries);
+	return true;
+};
+
+/**
+	Retrieve the random seed of the recording.
+ */
+uint64_t Movie::GetSeed() const
+{
+	return m_seed;
+};
+
+/**
+	Retrieve the cycle count the recording ended at.
+ */
+uint64_t Movie::GetEndCycle() const
+{
+	return m_endCycle;
+};
+
+/**
+	Retrieve the state hash the recording ended with.
+ */
+uint64_t Movie::GetEndStateHash() const
+{
+	return m_endStateHash;
+};
+
+/**
+	Retrieve the number of recorded inputs, frames included.
+ */
+size_t Movie::GetEventCount() const
+{
+	return m_entries.size();
+};
+
+/**
+	Retrieve the number of recorded frames.
+ */
+uint64_t Movie::GetFrameCount() const
+{
+	return std::count_if(m_entries.begin(), m_entries.end(), [](const MovieEntry& entry) { return entry.event == MovieEvent::Frame; });
+};
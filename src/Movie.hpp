@@ -0,0 +1,82 @@
+#ifndef MOVIE_HPP_INCLUDED
+#define MOVIE_HPP_INCLUDED
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Interpreter.hpp"
+
+/** Movie file identifier, "C8MV" */
+constexpr uint32_t g_movieMagic = 0x564D3843;
+/** Movie format version, bumped whenever the layout changes */
+constexpr uint16_t g_movieVersion = 1;
+
+/**
+	Inputs a movie records.
+		KeyPressed - OnKeyPressed() with the key of the event.
+		KeyReleased - OnKeyReleased() with the key of the event.
+		Frame - TickTimers(), frames are recorded so replays do not depend on the pacing of the recording.
+ */
+enum class MovieEvent : uint8_t
+{
+	KeyPressed,
+	KeyReleased,
+	Frame
+};
+
+/**
+	One recorded input.
+ */
+struct MovieEntry
+{
+	/** Cycle count of the interpreter when the input arrived */
+	uint64_t cycle;
+	/** What happened */
+	MovieEvent event;
+	/** Key index for key events */
+	uint8_t key;
+};
+
+/**
+	Recording of everything that reaches an interpreter from outside.\n
+	Together with the random seed this determines every instruction of a
+	run, so replaying a movie on a freshly initialized interpreter ends in
+	exactly the recorded state. On disk every event takes a variable length
+	cycle delta and one byte, a frame is usually two bytes.
+ */
+class Movie
+{
+	public:
+
+		Movie();
+
+		void Start(uint64_t seed);
+		void Record(uint64_t cycle, MovieEvent event, uint8_t key = 0);
+		void Finish(const Interpreter& interpreter);
+
+		bool Replay(Interpreter& interpreter) const;
+
+		bool Save(const char* filePath) const;
+		bool Load(const char* filePath);
+
+		uint64_t GetSeed() const;
+		uint64_t GetEndCycle() const;
+		uint64_t GetEndStateHash() const;
+		size_t GetEventCount() const;
+		uint64_t GetFrameCount() const;
+
+	private:
+
+		/** Random seed the interpreter was started with */
+		uint64_t m_seed;
+		/** Cycle count when the recording finished */
+		uint64_t m_endCycle;
+		/** Interpreter state hash when the recording finished */
+		uint64_t m_endStateHash;
+		/** Inputs ordered by cycle */
+		std::vector<MovieEntry> m_entries;
+
+}; // Movie
+
+#endif // MOVIE_HPP_INCLUDED
@@ -0,0 +1,234 @@
+#include <algorithm>
+#include "Profiler.hpp"
+
+/**
+	Default Constructor
+ */
+Profiler::Profiler()
+{
+	Reset();
+};
+
+/**
+	Drops every count and the call tree.
+ */
+void Profiler::Reset()
+{
+	m_instructionCount = 0;
+	m_operationCounts.fill(0);
+	m_addressCounts.fill(0);
+	m_callCounts.fill(0);
+	m_frames.clear();
+	m_frames.push_back({ 0, 0x0200, 0 });
+	m_children.clear();
+	m_currentFrame = 0;
+	m_depth = 0;
+	m_overflowDepth = 0;
+};
+
+/**
+	Moves to the call tree frame matching an interpreter's stack.\n
+	Each stack slot holds a return address, the subroutine it belongs to
+	is the target of the 2nnn right before it. Counts are kept.
+
+	@param[in] pStack Return addresses, oldest first.
+	@param[in] stackPointer Index of the newest return address, -1 if the stack is empty.
+	@param[in] pMemory Guest memory, g_chipRamSize bytes.
+ */
+void Profiler::Resync(const uint16_t* pStack, int8_t stackPointer, const uint8_t* pMemory)
+{
+	m_currentFrame = 0;
+	m_depth = 0;
+	m_overflowDepth = 0;
+
+	for (int32_t i = 0; i <= stackPointer && i < g_chipStackSize; i++)
+	{
+		uint16_t callAddress = (pStack[i] - g_chipInstructionSize) & g_chipAddressMask;
+		uint16_t opcode = static_cast<uint16_t>(pMemory[callAddress] << 8 | pMemory[(callAddress + 1) & g_chipAddressMask]);
+		Call(opcode & 0x0FFF);
+	};
+};
+
+/**
+	Retrieve the number of instructions counted.
+ */
+uint64_t Profiler::GetInstructionCount() const
+{
+	return m_instructionCount;
+};
+
+/**
+	Retrieve the number of times an operation was executed.
+ */
+uint64_t Profiler::GetOperationCount(Operation operation) const
+{
+	return m_operationCounts[static_cast<size_t>(operation)];
+};
+
+/**
+	Retrieve the number of instructions executed at an address.
+ */
+uint64_t Profiler::GetAddressCount(uint16_t address) const
+{
+	return m_addressCounts[address & g_chipAddressMask];
+};
+
+/**
+	Retrieve the number of calls to a subroutine.
+ */
+uint64_t Profiler::GetCallCount(uint16_t address) const
+{
+	return m_callCounts[address & g_chipAddressMask];
+};
+
+/**
+	Prints the operation mix and the hottest addresses and subroutines.
+
+	@param[in] pFile Stream to print to.
+	@param[in] topCount Number of addresses and subroutines to list.
+ */
+void Profiler::WriteReport(FILE* pFile, uint32_t topCount) const
+{
+	double total = m_instructionCount > 0 ? static_cast<double>(m_instructionCount) : 1.0;
+	fprintf(pFile, "Profiled %llu instructions\n", static_cast<unsigned long long>(m_instructionCount));
+
+	// Sorts indices of a count table by descending count and prints the non zero ones.
+	auto printTop = [pFile, total](const uint64_t* pCounts, size_t size, size_t limit, const char* pFormat)
+	{
+		std::vector<uint16_t> order;
+		for (size_t i = 0; i < size; i++)
+		{
+			if (pCounts[i] > 0)
+			{
+				order.push_back(static_cast<uint16_t>(i));
+			};
+		};
+		std::sort(order.begin(), order.end(), [pCounts](uint16_t a, uint16_t b) { return pCounts[a] > pCounts[b] || (pCounts[a] == pCounts[b] && a < b); });
+
+		for (size_t i = 0; i < order.size() && i < limit; i++)
+		{
+			fprintf(pFile, pFormat, order[i], static_cast<unsigned long long>(pCounts[order[i]]), pCounts[order[i]] * 100.0 / total);
+		};
+	};
+
+	fprintf(pFile, "\nOperations:\n");
+	std::array<uint64_t, static_cast<size_t>(Operation::Count)> operationCounts = m_operationCounts;
+	std::vector<size_t> operations;
+	for (size_t i = 0; i < operationCounts.size(); i++)
+	{
+		if (operationCounts[i] > 0)
+		{
+			operations.push_back(i);
+		};
+	};
+	std::sort(operations.begin(), operations.end(), [&operationCounts](size_t a, size_t b) { return operationCounts[a] > operationCounts[b]; });
+	for (size_t operation : operations)
+	{
+		fprintf(pFile, "  %-9s %14llu %6.2f%%\n",
+			GetOperationName(static_cast<Operation>(operation)),
+			static_cast<unsigned long long>(operationCounts[operation]),
+			operationCounts[operation] * 100.0 / total);
+	};
+
+	fprintf(pFile, "\nHottest addresses:\n");
+	printTop(m_addressCounts.data(), m_addressCounts.size(), topCount, "  0x%03X %14llu %6.2f%%\n");
+
+	// Percentages of calls are relative to all instructions, which is still a useful scale.
+	fprintf(pFile, "\nMost called subroutines:\n");
+	printTop(m_callCounts.data(), m_callCounts.size(), topCount, "  0x%03X %14llu calls (%.2f%% of instructions)\n");
+};
+
+/**
+	Writes the call tree in the folded format read by flamegraph.pl and speedscope.\n
+	One line per call stack, "main;sub_0x2A0;sub_0x310 1234", where the
+	number is the instructions executed in the last frame of the stack.
+
+	@param[in] filePath Path of the file to write.
+	@return false if the file could not be written.
+ */
+bool Profiler::WriteFoldedStacks(const char* filePath) const
+{
+	FILE* pFile = std::fopen(filePath, "w");
+	if (pFile == nullptr)
+	{
+		return false;
+	};
+
+	std::vector<uint16_t> path;
+	for (uint32_t i = 0; i < m_frames.size(); i++)
+	{
+		if (m_frames[i].samples == 0)
+		{
+			continue;
+		};
+
+		path.clear();
+		for (uint32_t frame = i; frame != 0; frame = m_frames[frame].parent)
+		{
+			path.push_back(m_frames[frame].address);
+		};
+
+		fprintf(pFile, "main");
+		for (auto it = path.rbegin(); it != path.rend(); ++it)
+		{
+			fprintf(pFile, ";sub_0x%03X", *it);
+		};
+		fprintf(pFile, " %llu\n", static_cast<unsigned long long>(m_frames[i].samples));
+	};
+
+	bool isWritten = std::ferror(pFile) == 0;
+	std::fclose(pFile);
+	return isWritten;
+};
+
+/**
+	Enters a subroutine.\n
+	Calls deeper than the guest stack stay in the current frame.
+ */
+void Profiler::Call(uint16_t address)
+{
+	if (m_depth >= g_chipStackSize)
+	{
+		m_overflowDepth++;
+		return;
+	};
+
+	m_currentFrame = GetChild(m_currentFrame, address);
+	m_depth++;
+};
+
+/**
+	Leaves the current subroutine, a return from the root is ignored.
+ */
+void Profiler::Return()
+{
+	if (m_overflowDepth > 0)
+	{
+		m_overflowDepth--;
+		return;
+	};
+
+	if (m_depth > 0)
+	{
+		m_currentFrame = m_frames[m_currentFrame].parent;
+		m_depth--;
+	};
+};
+
+/**
+	Finds or adds the frame for a call from a parent frame.
+ */
+uint32_t Profiler::GetChild(uint32_t parent, uint16_t address)
+{
+	uint64_t key = static_cast<uint64_t>(parent) << 16 | address;
+	auto it = m_children.find(key);
+	if (it != m_children.end())
+	{
+		return it->second;
+	};
+
+	uint32_t child = static_cast<uint32_t>(m_frames.size());
+	m_frames.push_back({ parent, address, 0 });
+	m_children.emplace(key, child);
+	return child;
+};
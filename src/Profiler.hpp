@@ -0,0 +1,103 @@
+#ifndef PROFILER_HPP_INCLUDED
+#define PROFILER_HPP_INCLUDED
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <unordered_map>
+#include <vector>
+#include "Instruction.hpp"
+#include "Interpreter.hpp"
+
+/**
+	Counts where a guest program spends its instructions.\n
+	Attached to an Interpreter with SetProfiler() in builds configured with
+	CHIP8_PROFILER. Every executed instruction is counted per operation, per
+	address and per call stack. Call stacks follow 2nnn and 00EE and are kept
+	as a tree of subroutine entry points, so counting an instruction is a
+	few array increments. The tree is rebuilt from the interpreter's stack
+	whenever the profiler is attached or a state is loaded.
+ */
+class Profiler
+{
+	public:
+
+		Profiler();
+
+		void Reset();
+		void Resync(const uint16_t* pStack, int8_t stackPointer, const uint8_t* pMemory);
+
+		/**
+			Counts an instruction, called before it executes.
+
+			@param[in] address Address of the instruction.
+			@param[in] instruction The decoded instruction.
+		 */
+		void OnInstruction(uint16_t address, const Instruction& instruction)
+		{
+			m_instructionCount++;
+			m_operationCounts[static_cast<size_t>(instruction.operation)]++;
+			m_addressCounts[address & g_chipAddressMask]++;
+			m_frames[m_currentFrame].samples++;
+
+			if (instruction.operation == Operation::Op2nnn)
+			{
+				m_callCounts[instruction.nnn]++;
+				Call(instruction.nnn);
+			}
+			else if (instruction.operation == Operation::Op00EE)
+			{
+				Return();
+			};
+		};
+
+		uint64_t GetInstructionCount() const;
+		uint64_t GetOperationCount(Operation operation) const;
+		uint64_t GetAddressCount(uint16_t address) const;
+		uint64_t GetCallCount(uint16_t address) const;
+
+		void WriteReport(FILE* pFile, uint32_t topCount) const;
+		bool WriteFoldedStacks(const char* filePath) const;
+
+	private:
+
+		/** One node of the call tree */
+		struct Frame
+		{
+			/** Index of the calling frame, the root is its own parent */
+			uint32_t parent;
+			/** Entry point of the subroutine, 0x200 for the root */
+			uint16_t address;
+			/** Instructions executed in this frame itself */
+			uint64_t samples;
+		};
+
+		void Call(uint16_t address);
+		void Return();
+		uint32_t GetChild(uint32_t parent, uint16_t address);
+
+	private:
+
+		/** Instructions counted since the last reset */
+		uint64_t m_instructionCount;
+		/** Instructions per operation */
+		std::array<uint64_t, static_cast<size_t>(Operation::Count)> m_operationCounts;
+		/** Instructions per guest address */
+		std::array<uint64_t, g_chipRamSize> m_addressCounts;
+		/** Calls per subroutine entry point */
+		std::array<uint64_t, g_chipRamSize> m_callCounts;
+		/** Call tree, index 0 is the root */
+		std::vector<Frame> m_frames;
+		/** Child frames, keyed by parent index and entry point */
+		std::unordered_map<uint64_t, uint32_t> m_children;
+		/** Frame the guest is executing in */
+		uint32_t m_currentFrame;
+		/** Depth of m_currentFrame below the root */
+		uint32_t m_depth;
+		/** Calls made past the depth of the guest stack, returned from without leaving the frame */
+		uint32_t m_overflowDepth;
+
+}; // Profiler
+
+#endif // PROFILER_HPP_INCLUDED
@@ -0,0 +1,169 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "Quirks.hpp"
+
+namespace
+{
+	/** Command line and database names, ordered like QuirkProfile */
+	const char* const g_quirkProfileNames[] = { "default", "vip", "schip", "xochip" };
+	static_assert(sizeof(g_quirkProfileNames) / sizeof(g_quirkProfileNames[0]) == static_cast<size_t>(QuirkProfile::Count), "Quirk profile names out of sync with the enum");
+
+	/** Longest line read from a database file */
+	constexpr size_t g_quirkLineSize = 256;
+
+	/** Copies a compile time policy in to run time flags */
+	template <typename Quirks>
+	constexpr QuirkFlags MakeQuirkFlags()
+	{
+		return { Quirks::shiftsVy, Quirks::incrementsI, Quirks::jumpsWithVx, Quirks::resetsVF, Quirks::wrapsSprites };
+	};
+}
+
+/**
+	Retrieve the behaviours of a profile.
+ */
+QuirkFlags GetQuirkFlags(QuirkProfile profile)
+{
+	switch (profile)
+	{
+		case QuirkProfile::Vip: return MakeQuirkFlags<VipQuirks>();
+		case QuirkProfile::SuperChip: return MakeQuirkFlags<SuperChipQuirks>();
+		case QuirkProfile::XoChip: return MakeQuirkFlags<XoChipQuirks>();
+		default: return MakeQuirkFlags<DefaultQuirks>();
+	};
+};
+
+/**
+	Retrieve the profile ROMs written for a platform usually expect.
+ */
+QuirkProfile GetDefaultQuirkProfile(Platform platform)
+{
+	switch (platform)
+	{
+		case Platform::SuperChip: return QuirkProfile::SuperChip;
+		case Platform::XoChip: return QuirkProfile::XoChip;
+		default: return QuirkProfile::Default;
+	};
+};
+
+/**
+	Retrieve the name used for a profile on the command line and in database files.
+ */
+const char* GetQuirkProfileName(QuirkProfile profile)
+{
+	size_t index = static_cast<size_t>(profile);
+	return index < static_cast<size_t>(QuirkProfile::Count) ? g_quirkProfileNames[index] : "unknown";
+};
+
+/**
+	Looks up a profile by name.
+
+	@param[in] pName Name of the profile, default, vip, schip or xochip.
+	@param[out] profile The profile, untouched if the name is unknown.
+	@return false if there is no profile with that name.
+ */
+bool FindQuirkProfile(const char* pName, QuirkProfile& profile)
+{
+	for (size_t i = 0; i < static_cast<size_t>(QuirkProfile::Count); i++)
+	{
+		if (std::strcmp(g_quirkProfileNames[i], pName) == 0)
+		{
+			profile = static_cast<QuirkProfile>(i);
+			return true;
+		};
+	};
+
+	return false;
+};
+
+/**
+	Retrieve the database shared by the whole process.
+ */
+QuirkDatabase& QuirkDatabase::GetInstance()
+{
+	static QuirkDatabase s_instance;
+	return s_instance;
+};
+
+/**
+	Adds the entries of a database file, replacing entries for the same ROMs.
+
+	@param[in] filePath Path to the database file.
+	@return false if the file could not be read or has a malformed line, entries before it are kept.
+ */
+bool QuirkDatabase::Load(const char* filePath)
+{
+	FILE* pFile = std::fopen(filePath, "r");
+	if (pFile == nullptr)
+	{
+		return false;
+	};
+
+	bool isValid = true;
+	char line[g_quirkLineSize];
+	while (isValid && std::fgets(line, sizeof(line), pFile) != nullptr)
+	{
+		char* pComment = std::strchr(line, '#');
+		if (pComment != nullptr)
+		{
+			*pComment = '\0';
+		};
+
+		char hash[g_quirkLineSize];
+		char name[g_quirkLineSize];
+		int fields = std::sscanf(line, "%255s %255s", hash, name);
+		if (fields <= 0)
+		{
+			// Blank or comment only.
+			continue;
+		};
+
+		char* pEnd = nullptr;
+		uint64_t romHash = std::strtoull(hash, &pEnd, 16);
+		QuirkProfile profile;
+		isValid = fields == 2 && *pEnd == '\0' && FindQuirkProfile(name, profile);
+		if (isValid)
+		{
+			Add(romHash, profile);
+		};
+	};
+
+	std::fclose(pFile);
+	return isValid;
+};
+
+/**
+	Sets the profile of a ROM.
+
+	@param[in] romHash Content hash of the ROM, see RomCache::Hash().
+	@param[in] profile Profile the ROM needs.
+ */
+void QuirkDatabase::Add(uint64_t romHash, QuirkProfile profile)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_profiles[romHash] = profile;
+};
+
+/**
+	Retrieve the profile a ROM needs.
+
+	@param[in] romHash Content hash of the ROM, see RomCache::Hash().
+	@param[in] platform Platform the ROM runs on, picks the profile for ROMs without an entry.
+	@return The profile.
+ */
+QuirkProfile QuirkDatabase::Find(uint64_t romHash, Platform platform) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = m_profiles.find(romHash);
+	return it != m_profiles.end() ? it->second : GetDefaultQuirkProfile(platform);
+};
+
+/**
+	Retrieve the number of ROMs with an entry.
+ */
+size_t QuirkDatabase::GetEntryCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_profiles.size();
+};
@@ -0,0 +1,107 @@
+#ifndef QUIRKS_HPP_INCLUDED
+#define QUIRKS_HPP_INCLUDED
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include "Instruction.hpp"
+
+/**
+	Sets of behaviours ROMs disagree on, named after the machine that defined them.
+		Default - What this emulator always did: shifts use Vx, Fx55 and Fx65 leave I alone, Bnnn adds V0, logic ops keep VF, sprites are clipped.
+		Vip - COSMAC VIP: shifts use Vy, Fx55 and Fx65 advance I, Bnnn adds V0, logic ops reset VF, sprites are clipped.
+		SuperChip - SUPER-CHIP 1.1: shifts use Vx, Fx55 and Fx65 leave I alone, Bxnn adds Vx, logic ops keep VF, sprites are clipped.
+		XoChip - XO-CHIP: shifts use Vy, Fx55 and Fx65 advance I, Bnnn adds V0, logic ops keep VF, sprites wrap.
+ */
+enum class QuirkProfile : uint8_t
+{
+	Default,
+	Vip,
+	SuperChip,
+	XoChip,
+	Count
+};
+
+/**
+	Compile time quirk policy.\n
+	The interpreter instantiates the affected handlers once per policy, so
+	which behaviour a ROM gets is decided when it is loaded and costs no
+	branch while executing.
+ */
+template <bool ShiftsVy, bool IncrementsI, bool JumpsWithVx, bool ResetsVF, bool WrapsSprites>
+struct QuirkPolicy
+{
+	/** 8xy6 and 8xyE shift Vy in to Vx instead of shifting Vx in place */
+	static constexpr bool shiftsVy = ShiftsVy;
+	/** Fx55 and Fx65 leave I pointing past the last register */
+	static constexpr bool incrementsI = IncrementsI;
+	/** Bxnn jumps to xnn + Vx instead of nnn + V0 */
+	static constexpr bool jumpsWithVx = JumpsWithVx;
+	/** 8xy1, 8xy2 and 8xy3 set VF to 0 */
+	static constexpr bool resetsVF = ResetsVF;
+	/** Sprite pixels past an edge wrap to the opposite edge instead of being clipped */
+	static constexpr bool wrapsSprites = WrapsSprites;
+};
+
+typedef QuirkPolicy<false, false, false, false, false> DefaultQuirks;
+typedef QuirkPolicy<true, true, false, true, false> VipQuirks;
+typedef QuirkPolicy<false, false, true, false, false> SuperChipQuirks;
+typedef QuirkPolicy<true, true, false, false, true> XoChipQuirks;
+
+/**
+	Run time copy of a quirk policy, for the recompiler which specializes
+	while translating instead of while compiling.
+ */
+struct QuirkFlags
+{
+	/** See QuirkPolicy::shiftsVy */
+	bool shiftsVy;
+	/** See QuirkPolicy::incrementsI */
+	bool incrementsI;
+	/** See QuirkPolicy::jumpsWithVx */
+	bool jumpsWithVx;
+	/** See QuirkPolicy::resetsVF */
+	bool resetsVF;
+	/** See QuirkPolicy::wrapsSprites */
+	bool wrapsSprites;
+};
+
+QuirkFlags GetQuirkFlags(QuirkProfile profile);
+QuirkProfile GetDefaultQuirkProfile(Platform platform);
+const char* GetQuirkProfileName(QuirkProfile profile);
+bool FindQuirkProfile(const char* pName, QuirkProfile& profile);
+
+/**
+	Process wide table of the quirk profile each ROM needs, by ROM content hash.\n
+	Entries are read from text files with one ROM per line: the 16 digit hex
+	hash chip8-headless prints for the ROM, then a profile name. Everything
+	after a '#' is a comment. ROMs without an entry get the profile of the
+	platform they run on. Safe to use from several threads.
+ */
+class QuirkDatabase
+{
+	public:
+
+		static QuirkDatabase& GetInstance();
+
+		bool Load(const char* filePath);
+		void Add(uint64_t romHash, QuirkProfile profile);
+		QuirkProfile Find(uint64_t romHash, Platform platform) const;
+		size_t GetEntryCount() const;
+
+	private:
+
+		QuirkDatabase() = default;
+
+	private:
+
+		/** Guards m_profiles */
+		mutable std::mutex m_mutex;
+		/** Profiles by ROM content hash */
+		std::unordered_map<uint64_t, QuirkProfile> m_profiles;
+
+}; // QuirkDatabase
+
+#endif // QUIRKS_HPP_INCLUDED
@@ -0,0 +1,64 @@
+#ifndef RANDOM_HPP_INCLUDED
+#define RANDOM_HPP_INCLUDED
+#pragma once
+
+#include <cstdint>
+
+/** Seed used until one is set, so runs are reproducible by default */
+constexpr uint64_t g_defaultRandomSeed = 0x43484950382D3031ULL;
+
+/**
+	Small seedable pseudo random generator (xorshift64*).\n
+	Every machine owns one, so instances on different threads do not share
+	state and a run is fully determined by its seed. The state is a single
+	64-bit value that is stored in save states.
+ */
+class Random
+{
+	public:
+
+		explicit Random(uint64_t seed = g_defaultRandomSeed) { Seed(seed); };
+
+		/**
+			Restarts the sequence.\n
+			The seed is scrambled first so nearby seeds give unrelated sequences.
+
+			@param[in] seed Any value, including 0.
+		 */
+		void Seed(uint64_t seed)
+		{
+			// splitmix64
+			uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			SetState(z ^ (z >> 31));
+		};
+
+		/**
+			Retrieve the next random byte.
+		 */
+		uint8_t NextByte()
+		{
+			m_state ^= m_state >> 12;
+			m_state ^= m_state << 25;
+			m_state ^= m_state >> 27;
+			// The upper bits are the best distributed.
+			return static_cast<uint8_t>((m_state * 0x2545F4914F6CDD1DULL) >> 56);
+		};
+
+		uint64_t GetState() const { return m_state; };
+
+		/**
+			Restores a state returned by GetState().\n
+			Zero would repeat forever and is replaced by the default seed.
+		 */
+		void SetState(uint64_t state) { m_state = state != 0 ? state : g_defaultRandomSeed; };
+
+	private:
+
+		/** Generator state, never zero */
+		uint64_t m_state;
+
+}; // Random
+
+#endif // RANDOM_HPP_INCLUDED
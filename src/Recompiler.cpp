@@ -0,0 +1,551 @@
+#include <cstdio>
+#include <cstring>
+#include "Recompiler.hpp"
+#include "RomAnalyzer.hpp"
+
+#if defined(__x86_64__) && defined(__linux__)
+#define CHIP8_RECOMPILER_SUPPORTED 1
+#include <sys/mman.h>
+#else
+#define CHIP8_RECOMPILER_SUPPORTED 0
+#endif
+
+namespace
+{
+	/** Bytes of the exit CheckBudget() jumps over, StoreWord(), mov eax and Epilogue() */
+	constexpr uint8_t g_budgetExitSize = 9 + 5 + 6;
+
+	/**
+		Writes x86-64 machine code in to a buffer.\n
+		Guest state is addressed relative to rbx, which holds &m_registerV[0].
+		r12 holds the Interpreter pointer passed to helper calls and r13d the
+		budget of instructions the block may execute.
+	 */
+	class Emitter
+	{
+		public:
+
+			Emitter(uint8_t* pBuffer, size_t capacity) : m_pBuffer(pBuffer), m_capacity(capacity), m_size(0), m_overflow(false)
+			{
+			};
+
+			size_t GetSize() const { return m_size; };
+			bool HasOverflowed() const { return m_overflow; };
+
+			void Byte(uint8_t value)
+			{
+				if (m_size < m_capacity)
+				{
+					m_pBuffer[m_size++] = value;
+				}
+				else
+				{
+					m_overflow = true;
+				};
+			};
+
+			void Word(uint16_t value)
+			{
+				Byte(value & 0xFF);
+				Byte(value >> 8);
+			};
+
+			void Dword(uint32_t value)
+			{
+				Word(value & 0xFFFF);
+				Word(value >> 16);
+			};
+
+			void Qword(uint64_t value)
+			{
+				Dword(value & 0xFFFFFFFF);
+				Dword(value >> 32);
+			};
+
+			/** opcode with a [rbx + disp32] operand, reg is the ModRM reg field */
+			void RbxOperand(uint8_t opcode, uint8_t reg, int32_t displacement)
+			{
+				Byte(opcode);
+				Byte(0x80 | (reg << 3) | 0x03);
+				Dword(static_cast<uint32_t>(displacement));
+			};
+
+			void Prologue()
+			{
+				Byte(0x53);							// push rbx
+				Byte(0x41); Byte(0x54);				// push r12
+				Byte(0x41); Byte(0x55);				// push r13 (keeps the stack 16 byte aligned)
+				Byte(0x48); Byte(0x89); Byte(0xFB);	// mov rbx, rdi
+				Byte(0x49); Byte(0x89); Byte(0xF4);	// mov r12, rsi
+				Byte(0x41); Byte(0x89); Byte(0xD5);	// mov r13d, edx
+			};
+
+			void Epilogue()
+			{
+				Byte(0x41); Byte(0x5D);				// pop r13
+				Byte(0x41); Byte(0x5C);				// pop r12
+				Byte(0x5B);							// pop rbx
+				Byte(0xC3);							// ret
+			};
+
+			/** Returns the number of instructions the block executed */
+			void Return(uint32_t executed)
+			{
+				Byte(0xB8); Dword(executed);		// mov eax, executed
+				Epilogue();
+			};
+
+			/**
+				Returns from the block when executed instructions used up the
+				budget in r13d, leaving the program counter at the next one.
+			 */
+			void CheckBudget(uint8_t executed, int32_t programCounter, uint16_t address)
+			{
+				Byte(0x41); Byte(0x83); Byte(0xFD); Byte(executed);	// cmp r13d, executed
+				Byte(0x75); Byte(g_budgetExitSize);					// jne past the exit
+				StoreWord(programCounter, address);
+				Return(executed);
+			};
+
+			/** mov al, [rbx + displacement] */
+			void LoadAl(int32_t displacement) { RbxOperand(0x8A, 0, displacement); };
+			/** mov [rbx + displacement], al */
+			void StoreAl(int32_t displacement) { RbxOperand(0x88, 0, displacement); };
+			/** mov [rbx + displacement], cl */
+			void StoreCl(int32_t displacement) { RbxOperand(0x88, 1, displacement); };
+			/** movzx eax, byte [rbx + displacement] */
+			void LoadZeroExtendedEax(int32_t displacement) { Byte(0x0F); RbxOperand(0xB6, 0, displacement); };
+
+			/** mov byte [rbx + displacement], value */
+			void StoreByte(int32_t displacement, uint8_t value)
+			{
+				RbxOperand(0xC6, 0, displacement);
+				Byte(value);
+			};
+
+			/** mov word [rbx + displacement], value */
+			void StoreWord(int32_t displacement, uint16_t value)
+			{
+				Byte(0x66);
+				RbxOperand(0xC7, 0, displacement);
+				Word(value);
+			};
+
+			/** setc cl */
+			void SetCarryCl() { Byte(0x0F); Byte(0x92); Byte(0xC1); };
+			/** setnc cl */
+			void SetNotCarryCl() { Byte(0x0F); Byte(0x93); Byte(0xC1); };
+
+			/** Calls helper(pInterpreter, argument) */
+			void CallHelper(void (*pHelper)(Interpreter*, uint32_t), uint32_t argument)
+			{
+				Byte(0x4C); Byte(0x89); Byte(0xE7);	// mov rdi, r12
+				Byte(0xBE); Dword(argument);		// mov esi, argument
+				Byte(0x48); Byte(0xB8);				// mov rax, pHelper
+				Qword(reinterpret_cast<uint64_t>(pHelper));
+				Byte(0xFF); Byte(0xD0);				// call rax
+			};
+
+		private:
+
+			uint8_t* m_pBuffer;
+			size_t m_capacity;
+			size_t m_size;
+			bool m_overflow;
+	};
+
+	/**
+		Operations that end a block. Their next program counter is only
+		known at run time or they write to memory.
+	 */
+	bool IsBlockTerminator(Operation operation)
+	{
+		switch (operation)
+		{
+			case Operation::Op00EE:
+			case Operation::Op1nnn:
+			case Operation::Op2nnn:
+			case Operation::Op3xkk:
+			case Operation::Op4xkk:
+			case Operation::Op5xy0:
+			case Operation::Op9xy0:
+			case Operation::OpBnnn:
+			case Operation::OpEx9E:
+			case Operation::OpExA1:
+			case Operation::OpFx0A:
+			case Operation::OpFx33:
+			case Operation::OpFx55:
+			case Operation::Op00FD:
+			case Operation::Op5xy2:
+			case Operation::OpF000:
+				return true;
+			default:
+				return false;
+		};
+	};
+
+	/**
+		Operations that skip the next instruction. On XO-CHIP the size of the
+		skip depends on the instruction after them.
+	 */
+	bool IsSkip(Operation operation)
+	{
+		switch (operation)
+		{
+			case Operation::Op3xkk:
+			case Operation::Op4xkk:
+			case Operation::Op5xy0:
+			case Operation::Op9xy0:
+			case Operation::OpEx9E:
+			case Operation::OpExA1:
+				return true;
+			default:
+				return false;
+		};
+	};
+}
+
+/**
+	Default Constructor
+
+	@param[in] interpreter Interpreter whose state the translated code operates on.
+ */
+Recompiler::Recompiler(Interpreter& interpreter) : m_interpreter(interpreter), m_pCode(nullptr), m_codeUsed(0), m_nativeCycleCount(0)
+{
+	m_blocks.fill(Block{ nullptr, 0 });
+};
+
+/**
+	Default Destructor
+ */
+Recompiler::~Recompiler()
+{
+#if CHIP8_RECOMPILER_SUPPORTED
+	if (m_pCode != nullptr)
+	{
+		munmap(m_pCode, g_recompilerCodeSize);
+		m_pCode = nullptr;
+	};
+#endif
+};
+
+/**
+	Checks if native code generation is available on this platform.
+ */
+bool Recompiler::IsSupported()
+{
+	return CHIP8_RECOMPILER_SUPPORTED != 0;
+};
+
+/**
+	Allocates the executable code buffer.
+
+	@return false if the platform is not supported or executable memory could not be allocated.
+ */
+bool Recompiler::Initialize()
+{
+#if CHIP8_RECOMPILER_SUPPORTED
+	void* pCode = mmap(nullptr, g_recompilerCodeSize, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (pCode == MAP_FAILED)
+	{
+		printf("Error: Failed to allocate executable memory for the recompiler!\n");
+		return false;
+	};
+
+	m_pCode = static_cast<uint8_t*>(pCode);
+	Flush();
+	return true;
+#else
+	return false;
+#endif
+};
+
+/**
+	Runs translated blocks for a number of guest instructions.\n
+	A block stops early once it used up the remaining budget, so the result
+	is identical to calling Interpreter::Run() cycles times.
+
+	@param[in] cycles Number of instructions to execute.
+	@return Number of instructions executed.
+ */
+uint32_t Recompiler::Execute(uint32_t cycles)
+{
+	uint32_t executed = 0;
+	while (executed < cycles)
+	{
+		uint16_t address = m_interpreter.m_programCounter & g_chipAddressMask;
+		if (m_blocks[address].function == nullptr && !Compile(address))
+		{
+			m_interpreter.Run();
+			executed++;
+			continue;
+		};
+
+		m_interpreter.m_programCounter = address;
+		uint32_t blockExecuted = m_blocks[address].function(m_interpreter.m_registerV.data(), &m_interpreter, cycles - executed);
+		m_interpreter.m_cycleCount += blockExecuted;
+		m_nativeCycleCount += blockExecuted;
+		executed += blockExecuted;
+	};
+
+	return executed;
+};
+
+/**
+	Retrieve how many instructions ran inside translated blocks.
+ */
+uint64_t Recompiler::GetNativeCycleCount() const
+{
+	return m_nativeCycleCount;
+};
+
+/**
+	Drops every block translated from the given guest address.
+
+	@param[in] address Guest address that was written to.
+ */
+void Recompiler::Invalidate(uint16_t address)
+{
+	// Self modifying code is rare, throwing away every block keeps this simple.
+	if (m_translatedBytes.test(address & g_chipAddressMask))
+	{
+		Flush();
+	};
+};
+
+/**
+	Drops every translated block.
+ */
+void Recompiler::Flush()
+{
+	m_blocks.fill(Block{ nullptr, 0 });
+	m_translatedBytes.reset();
+	m_codeUsed = 0;
+};
+
+/**
+	Translates every block the analysis found that is not translated yet.\n
+	Stops before the buffer would have to be flushed, the blocks left over
+	are translated when they first run like without an analysis.
+
+	@param[in] analysis Analysis of the loaded ROM.
+ */
+void Recompiler::Prepare(const RomAnalysis& analysis)
+{
+	for (const BasicBlock& block : analysis.blocks)
+	{
+		if (g_recompilerCodeSize - m_codeUsed < g_recompilerBlockReserve)
+		{
+			break;
+		};
+
+		if (m_blocks[block.start].function == nullptr)
+		{
+			Compile(block.start);
+		};
+	};
+};
+
+/**
+	Translates the block starting at a guest address.
+
+	@param[in] address Guest address of the first instruction.
+	@return false if the block could not be translated.
+ */
+bool Recompiler::Compile(uint16_t address)
+{
+	if (m_pCode == nullptr)
+	{
+		return false;
+	};
+
+	// Out of space, start over with an empty buffer.
+	if (g_recompilerCodeSize - m_codeUsed < g_recompilerBlockReserve)
+	{
+		Flush();
+	};
+
+	const uint8_t* pRegisters = m_interpreter.m_registerV.data();
+	const int32_t programCounter = static_cast<int32_t>(reinterpret_cast<const uint8_t*>(&m_interpreter.m_programCounter) - pRegisters);
+	const int32_t indexRegister = static_cast<int32_t>(reinterpret_cast<const uint8_t*>(&m_interpreter.m_I) - pRegisters);
+	const int32_t flagRegister = 0x0F;
+	// Quirks are fixed while translating, the emitted code never tests them.
+	const QuirkFlags quirks = GetQuirkFlags(m_interpreter.m_quirkProfile);
+
+	Emitter emitter(m_pCode + m_codeUsed, g_recompilerCodeSize - m_codeUsed);
+	emitter.Prologue();
+
+	uint16_t current = address;
+	uint16_t length = 0;
+	bool terminated = false;
+
+	while (!terminated && length < g_recompilerMaxBlockLength && current + 1 < g_chipRamSize)
+	{
+		uint16_t opcode = (m_interpreter.m_memory[current] << 8) | m_interpreter.m_memory[current + 1];
+		Instruction instruction = DecodeInstruction(opcode, m_interpreter.m_platform);
+		const int32_t x = instruction.x;
+		const int32_t y = instruction.y;
+		const uint16_t next = current + g_chipInstructionSize;
+
+		// The first instruction always fits, Execute() never passes an empty budget.
+		if (length > 0)
+		{
+			emitter.CheckBudget(static_cast<uint8_t>(length), programCounter, current);
+		};
+
+		// XO-CHIP skips are left to the interpreter, which knows the size of the instruction skipped.
+		const bool isNative = m_interpreter.m_platform != Platform::XoChip || !IsSkip(instruction.operation);
+
+		switch (isNative ? instruction.operation : Operation::Count)
+		{
+			case Operation::Op1nnn:
+				emitter.StoreWord(programCounter, instruction.nnn);
+				break;
+
+			case Operation::Op3xkk:
+			case Operation::Op4xkk:
+				emitter.StoreWord(programCounter, next);
+				emitter.RbxOperand(0x80, 7, x);					// cmp byte [rbx + x], kk
+				emitter.Byte(instruction.kk);
+				emitter.Byte(instruction.operation == Operation::Op3xkk ? 0x75 : 0x74);	// jne / je
+				emitter.Byte(9);
+				emitter.StoreWord(programCounter, next + g_chipInstructionSize);
+				break;
+
+			case Operation::Op5xy0:
+			case Operation::Op9xy0:
+				emitter.StoreWord(programCounter, next);
+				emitter.LoadAl(x);
+				emitter.RbxOperand(0x3A, 0, y);					// cmp al, [rbx + y]
+				emitter.Byte(instruction.operation == Operation::Op5xy0 ? 0x75 : 0x74);	// jne / je
+				emitter.Byte(9);
+				emitter.StoreWord(programCounter, next + g_chipInstructionSize);
+				break;
+
+			case Operation::Op6xkk:
+				emitter.StoreByte(x, instruction.kk);
+				break;
+
+			case Operation::Op7xkk:
+				emitter.RbxOperand(0x80, 0, x);					// add byte [rbx + x], kk
+				emitter.Byte(instruction.kk);
+				break;
+
+			case Operation::Op8xy0:
+				emitter.LoadAl(y);
+				emitter.StoreAl(x);
+				break;
+
+			case Operation::Op8xy1:
+			case Operation::Op8xy2:
+			case Operation::Op8xy3:
+				emitter.LoadAl(y);
+				emitter.RbxOperand(
+					instruction.operation == Operation::Op8xy1 ? 0x08 :	// or [rbx + x], al
+					instruction.operation == Operation::Op8xy2 ? 0x20 :	// and [rbx + x], al
+					0x30,												// xor [rbx + x], al
+					0, x);
+				if (quirks.resetsVF)
+				{
+					emitter.StoreByte(flagRegister, 0x00);
+				};
+				break;
+
+			case Operation::Op8xy4:
+				emitter.LoadAl(x);
+				emitter.RbxOperand(0x02, 0, y);					// add al, [rbx + y]
+				emitter.SetCarryCl();
+				emitter.StoreAl(x);
+				emitter.StoreCl(flagRegister);
+				break;
+
+			case Operation::Op8xy5:
+				emitter.LoadAl(x);
+				emitter.RbxOperand(0x2A, 0, y);					// sub al, [rbx + y]
+				emitter.SetNotCarryCl();
+				emitter.StoreAl(x);
+				emitter.StoreCl(flagRegister);
+				break;
+
+			case Operation::Op8xy6:
+			case Operation::Op8xyE:
+				emitter.LoadAl(quirks.shiftsVy ? y : x);
+				emitter.Byte(0xD0);								// shr al, 1 / shl al, 1
+				emitter.Byte(instruction.operation == Operation::Op8xy6 ? 0xE8 : 0xE0);
+				emitter.SetCarryCl();
+				emitter.StoreAl(x);
+				emitter.StoreCl(flagRegister);
+				break;
+
+			case Operation::Op8xy7:
+				emitter.LoadAl(y);
+				emitter.RbxOperand(0x2A, 0, x);					// sub al, [rbx + x]
+				emitter.SetNotCarryCl();
+				emitter.StoreAl(x);
+				emitter.StoreCl(flagRegister);
+				break;
+
+			case Operation::OpAnnn:
+				emitter.StoreWord(indexRegister, instruction.nnn);
+				break;
+
+			case Operation::OpFx1E:
+				emitter.LoadZeroExtendedEax(x);
+				emitter.Byte(0x66);
+				emitter.RbxOperand(0x01, 0, indexRegister);		// add word [rbx + I], ax
+				break;
+
+			case Operation::OpFx29:
+				emitter.LoadZeroExtendedEax(x);
+				emitter.Byte(0x83); emitter.Byte(0xE0); emitter.Byte(0x0F);	// and eax, 0x0F
+				emitter.Byte(0x8D); emitter.Byte(0x04); emitter.Byte(0x80);	// lea eax, [rax + rax * 4]
+				emitter.Byte(0x66);
+				emitter.RbxOperand(0x89, 0, indexRegister);		// mov word [rbx + I], ax
+				break;
+
+			case Operation::Unknown:
+				break;
+
+			default:
+				// Everything else runs through the interpreter handler.
+				emitter.CallHelper(&Recompiler::ExecuteInstruction, current);
+				break;
+		};
+
+		m_translatedBytes.set(current);
+		m_translatedBytes.set(current + 1);
+		terminated = IsBlockTerminator(instruction.operation);
+		current = next;
+		length++;
+	};
+
+	// Blocks that run in to the next one continue after their last instruction.
+	if (!terminated)
+	{
+		emitter.StoreWord(programCounter, current);
+	};
+	emitter.Return(length);
+
+	if (emitter.HasOverflowed() || length == 0)
+	{
+		return false;
+	};
+
+	Block& block = m_blocks[address];
+	block.function = reinterpret_cast<BlockFunction>(m_pCode + m_codeUsed);
+	block.length = length;
+	m_codeUsed += emitter.GetSize();
+	return true;
+};
+
+/**
+	Called from translated code to execute a single instruction with the interpreter.
+
+	@param[in] pInterpreter Interpreter to execute the instruction on.
+	@param[in] address Guest address of the instruction.
+ */
+void Recompiler::ExecuteInstruction(Interpreter* pInterpreter, uint32_t address)
+{
+	pInterpreter->m_programCounter = static_cast<uint16_t>(address);
+	pInterpreter->Dispatch();
+};
@@ -0,0 +1,77 @@
+#ifndef RECOMPILER_HPP_INCLUDED
+#define RECOMPILER_HPP_INCLUDED
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include "Interpreter.hpp"
+
+/** Size of the executable buffer holding translated blocks */
+constexpr size_t g_recompilerCodeSize = 1024 * 1024;
+/** Maximum number of guest instructions in a translated block */
+constexpr uint16_t g_recompilerMaxBlockLength = 64;
+/** Space kept free for the next block, the largest block never needs more */
+constexpr size_t g_recompilerBlockReserve = 4096;
+
+struct RomAnalysis;
+
+/**
+	Translates guest basic blocks in to native x86-64 code.\n
+	Blocks are cached by guest address and dropped when guest code writes to
+	memory a block was translated from. Instructions the recompiler does not
+	translate are executed by calling back in to the interpreter.
+ */
+class Recompiler
+{
+	public:
+
+		explicit Recompiler(Interpreter& interpreter);
+		~Recompiler();
+
+		static bool IsSupported();
+
+		bool Initialize();
+		uint32_t Execute(uint32_t cycles);
+		uint64_t GetNativeCycleCount() const;
+
+		void Invalidate(uint16_t address);
+		void Flush();
+		void Prepare(const RomAnalysis& analysis);
+
+	private:
+
+		/** Signature of a translated block, called with &m_registerV[0], the interpreter and the most instructions to execute, returns the number executed */
+		typedef uint32_t (*BlockFunction)(uint8_t* pRegisters, Interpreter* pInterpreter, uint32_t budget);
+
+		/** Translated guest block */
+		struct Block
+		{
+			/** Native code, null when not translated */
+			BlockFunction function;
+			/** Number of guest instructions in the block */
+			uint16_t length;
+		};
+
+		bool Compile(uint16_t address);
+		static void ExecuteInstruction(Interpreter* pInterpreter, uint32_t address);
+
+	private:
+
+		/** Interpreter owning the state the blocks operate on */
+		Interpreter& m_interpreter;
+		/** Executable memory for translated blocks */
+		uint8_t* m_pCode;
+		/** Number of bytes used in m_pCode */
+		size_t m_codeUsed;
+		/** Translated blocks indexed by guest address */
+		std::array<Block, g_chipRamSize> m_blocks;
+		/** Guest bytes covered by a translated block */
+		std::bitset<g_chipRamSize> m_translatedBytes;
+		/** Instructions executed by translated blocks */
+		uint64_t m_nativeCycleCount;
+
+}; // Recompiler
+
+#endif // RECOMPILER_HPP_INCLUDED
@@ -0,0 +1,364 @@
+#include <algorithm>
+#include <cstring>
+#include "RewindBuffer.hpp"
+
+namespace
+{
+	/** Marks m_keyframeSequence as holding no keyframe */
+	constexpr uint64_t g_noKeyframe = ~0ULL;
+	/** Zero bytes needed to end a literal run, shorter runs are cheaper stored as literals */
+	constexpr size_t g_minimumZeroRun = 4;
+}
+
+/**
+	Default Constructor
+
+	@param[in] capacity Bytes reserved for encoded frames.
+	@param[in] keyframeInterval Frames between two keyframes.
+	@param[in] maxFrames Most frames kept, older ones are dropped.
+ */
+RewindBuffer::RewindBuffer(size_t capacity, uint32_t keyframeInterval, uint32_t maxFrames) :
+	m_keyframeInterval(std::max(keyframeInterval, 1u)),
+	m_data(capacity),
+	m_head(0),
+	m_usedBytes(0),
+	m_entries(std::max(maxFrames, 1u)),
+	m_first(0),
+	m_count(0),
+	m_nextSequence(0),
+	m_keyframeSequence(g_noKeyframe)
+{
+};
+
+/**
+	Records the current state of an interpreter as the newest frame.
+
+	@param[in] interpreter Interpreter to record.
+	@return false if the frame did not fit in the buffer.
+ */
+bool RewindBuffer::Push(const Interpreter& interpreter)
+{
+	size_t stateSize = interpreter.SaveState(m_state.data(), m_state.size());
+	if (stateSize == 0)
+	{
+		return false;
+	};
+
+	// Deltas need the same layout as their keyframe.
+	bool isKeyframe = m_count == 0;
+	if (!isKeyframe)
+	{
+		const Entry& newest = GetEntry(m_count - 1);
+		isKeyframe = newest.keyframeDistance + 1 >= m_keyframeInterval || newest.stateSize != stateSize;
+		if (!isKeyframe && m_keyframeSequence != newest.sequence - newest.keyframeDistance)
+		{
+			isKeyframe = !LoadKeyframe(GetEntry(m_count - 1 - newest.keyframeDistance));
+		};
+
+		if (!isKeyframe)
+		{
+			size_t size = Encode(m_state.data(), m_keyframe.data(), stateSize, m_encoded.data());
+			if (Store(size, stateSize, newest.keyframeDistance + 1))
+			{
+				return true;
+			};
+
+			// Making room dropped the keyframe, start a new one instead.
+		};
+	};
+
+	size_t size = Encode(m_state.data(), nullptr, stateSize, m_encoded.data());
+	if (!Store(size, stateSize, 0))
+	{
+		return false;
+	};
+
+	std::memcpy(m_keyframe.data(), m_state.data(), stateSize);
+	m_keyframeSequence = GetEntry(m_count - 1).sequence;
+	return true;
+};
+
+/**
+	Restores the newest frame and removes it from the buffer.
+
+	@param[in] interpreter Interpreter to restore.
+	@return false if there is no frame left.
+ */
+bool RewindBuffer::Rewind(Interpreter& interpreter)
+{
+	if (m_count == 0)
+	{
+		return false;
+	};
+
+	const Entry newest = GetEntry(m_count - 1);
+	if (newest.keyframeDistance != 0 && m_keyframeSequence != newest.sequence - newest.keyframeDistance)
+	{
+		if (!LoadKeyframe(GetEntry(m_count - 1 - newest.keyframeDistance)))
+		{
+			Clear();
+			return false;
+		};
+	};
+
+	const uint8_t* pKeyframe = newest.keyframeDistance != 0 ? m_keyframe.data() : nullptr;
+	bool isDecoded = Decode(&m_data[newest.offset], newest.size, pKeyframe, m_state.data(), newest.stateSize);
+	DropNewest();
+
+	return isDecoded && interpreter.LoadState(m_state.data(), newest.stateSize);
+};
+
+/**
+	Drops every recorded frame.
+ */
+void RewindBuffer::Clear()
+{
+	m_head = 0;
+	m_usedBytes = 0;
+	m_first = 0;
+	m_count = 0;
+	m_keyframeSequence = g_noKeyframe;
+};
+
+/**
+	Retrieve the number of frames that can be stepped back.
+ */
+uint32_t RewindBuffer::GetFrameCount() const
+{
+	return m_count;
+};
+
+/**
+	Retrieve the number of bytes used by the encoded frames.
+ */
+size_t RewindBuffer::GetUsedBytes() const
+{
+	return m_usedBytes;
+};
+
+/**
+	Retrieve a frame, index 0 is the oldest.
+ */
+RewindBuffer::Entry& RewindBuffer::GetEntry(uint32_t index)
+{
+	return m_entries[(m_first + index) % m_entries.size()];
+};
+
+/**
+	Copies the encoded frame in m_encoded to the ring, dropping the oldest frames to make room.
+
+	@return false if the frame is larger than the buffer or a delta lost its keyframe.
+ */
+bool RewindBuffer::Store(size_t size, size_t stateSize, uint32_t keyframeDistance)
+{
+	if (size > m_data.size())
+	{
+		return false;
+	};
+
+	if (m_count == m_entries.size())
+	{
+		DropOldest();
+	};
+
+	// Find a contiguous free range after the newest frame.
+	size_t offset = 0;
+	for (;;)
+	{
+		if (m_count == 0)
+		{
+			m_head = 0;
+			offset = 0;
+			break;
+		};
+
+		size_t tail = GetEntry(0).offset;
+		if (m_head > tail || (m_head == tail && m_usedBytes == 0))
+		{
+			if (m_data.size() - m_head >= size)
+			{
+				offset = m_head;
+				break;
+			};
+			if (tail >= size)
+			{
+				offset = 0;
+				break;
+			};
+		}
+		else if (tail - m_head >= size)
+		{
+			offset = m_head;
+			break;
+		};
+
+		DropOldest();
+	};
+
+	uint64_t sequence = m_count > 0 ? GetEntry(m_count - 1).sequence + 1 : m_nextSequence;
+	if (keyframeDistance != 0 && (m_count == 0 || GetEntry(0).sequence > sequence - keyframeDistance))
+	{
+		return false;
+	};
+
+	std::memcpy(&m_data[offset], m_encoded.data(), size);
+	m_head = offset + size;
+	m_usedBytes += size;
+
+	Entry& entry = GetEntry(m_count);
+	entry.offset = offset;
+	entry.size = size;
+	entry.stateSize = stateSize;
+	entry.keyframeDistance = keyframeDistance;
+	entry.sequence = sequence;
+	m_count++;
+	m_nextSequence = sequence + 1;
+	return true;
+};
+
+/**
+	Drops the oldest frame and every delta that depended on it.
+ */
+void RewindBuffer::DropOldest()
+{
+	do
+	{
+		m_usedBytes -= GetEntry(0).size;
+		m_first = (m_first + 1) % m_entries.size();
+		m_count--;
+	}
+	while (m_count > 0 && GetEntry(0).keyframeDistance != 0);
+};
+
+/**
+	Drops the newest frame, its space is reused by the next push.
+ */
+void RewindBuffer::DropNewest()
+{
+	Entry& newest = GetEntry(m_count - 1);
+	if (newest.keyframeDistance == 0 && newest.sequence == m_keyframeSequence)
+	{
+		m_keyframeSequence = g_noKeyframe;
+	};
+
+	m_head = newest.offset;
+	m_usedBytes -= newest.size;
+	m_nextSequence = newest.sequence;
+	m_count--;
+};
+
+/**
+	Decodes a keyframe in to m_keyframe.
+ */
+bool RewindBuffer::LoadKeyframe(const Entry& entry)
+{
+	if (!Decode(&m_data[entry.offset], entry.size, nullptr, m_keyframe.data(), entry.stateSize))
+	{
+		m_keyframeSequence = g_noKeyframe;
+		return false;
+	};
+
+	m_keyframeSequence = entry.sequence;
+	return true;
+};
+
+/**
+	Run length encodes the XOR of a state against a keyframe.\n
+	The output is a list of segments, each a 16-bit count of unchanged bytes,
+	a 16-bit count of changed bytes and the XORed changed bytes. It is never
+	larger than twice the input.
+
+	@param[in] pState State to encode.
+	@param[in] pKeyframe State to XOR against, null to store the state as is.
+	@param[in] size Size of both states.
+	@param[out] pOutput Encoded data.
+	@return Size of the encoded data.
+ */
+size_t RewindBuffer::Encode(const uint8_t* pState, const uint8_t* pKeyframe, size_t size, uint8_t* pOutput)
+{
+	auto delta = [&](size_t i) -> uint8_t
+	{
+		return pKeyframe != nullptr ? pState[i] ^ pKeyframe[i] : pState[i];
+	};
+
+	uint8_t* pWrite = pOutput;
+	size_t i = 0;
+	while (i < size)
+	{
+		size_t zeroStart = i;
+		while (i < size && i - zeroStart < 0xFFFF && delta(i) == 0)
+		{
+			i++;
+		};
+		size_t zeroCount = i - zeroStart;
+
+		// Literals run until enough zero bytes in a row are found.
+		size_t literalStart = i;
+		size_t zeroRun = 0;
+		while (i < size && i - literalStart < 0xFFFF && zeroRun < g_minimumZeroRun)
+		{
+			zeroRun = delta(i) == 0 ? zeroRun + 1 : 0;
+			i++;
+		};
+		if (zeroRun == g_minimumZeroRun)
+		{
+			i -= zeroRun;
+		};
+		size_t literalCount = i - literalStart;
+
+		*pWrite++ = static_cast<uint8_t>(zeroCount);
+		*pWrite++ = static_cast<uint8_t>(zeroCount >> 8);
+		*pWrite++ = static_cast<uint8_t>(literalCount);
+		*pWrite++ = static_cast<uint8_t>(literalCount >> 8);
+		for (size_t j = literalStart; j < literalStart + literalCount; j++)
+		{
+			*pWrite++ = delta(j);
+		};
+	};
+
+	return static_cast<size_t>(pWrite - pOutput);
+};
+
+/**
+	Reverses Encode().
+
+	@param[in] pInput Encoded data.
+	@param[in] inputSize Size of the encoded data.
+	@param[in] pKeyframe State the data was XORed against, null if it was not.
+	@param[out] pState Decoded state.
+	@param[in] size Size of the decoded state.
+	@return false if the data is corrupt.
+ */
+bool RewindBuffer::Decode(const uint8_t* pInput, size_t inputSize, const uint8_t* pKeyframe, uint8_t* pState, size_t size)
+{
+	const uint8_t* pEnd = pInput + inputSize;
+	size_t i = 0;
+	while (pInput + 4 <= pEnd)
+	{
+		size_t zeroCount = pInput[0] | (pInput[1] << 8);
+		size_t literalCount = pInput[2] | (pInput[3] << 8);
+		pInput += 4;
+		if (size - i < zeroCount + literalCount || static_cast<size_t>(pEnd - pInput) < literalCount)
+		{
+			return false;
+		};
+
+		if (pKeyframe != nullptr)
+		{
+			std::memcpy(pState + i, pKeyframe + i, zeroCount);
+		}
+		else
+		{
+			std::memset(pState + i, 0, zeroCount);
+		};
+		i += zeroCount;
+
+		for (size_t j = 0; j < literalCount; j++, i++)
+		{
+			pState[i] = pKeyframe != nullptr ? pInput[j] ^ pKeyframe[i] : pInput[j];
+		};
+		pInput += literalCount;
+	};
+
+	return i == size && pInput == pEnd;
+};
@@ -0,0 +1,95 @@
+#ifndef REWINDBUFFER_HPP_INCLUDED
+#define REWINDBUFFER_HPP_INCLUDED
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Interpreter.hpp"
+
+/** Bytes of history kept unless configured otherwise */
+constexpr size_t g_rewindDefaultCapacity = 4 * 1024 * 1024;
+/** Frames between two full snapshots unless configured otherwise */
+constexpr uint32_t g_rewindDefaultKeyframeInterval = 30;
+/** Most frames kept unless configured otherwise, ten minutes at 60 Hz */
+constexpr uint32_t g_rewindDefaultMaxFrames = 60 * 60 * 10;
+
+/**
+	Fixed size history of save states, one per frame.\n
+	Every K frames a keyframe is stored, the frames in between store the XOR
+	of their save state against that keyframe. Both are run length encoded,
+	so unchanged memory costs next to nothing. Stepping back decodes at most
+	one keyframe and one delta, which takes the same time for every frame.
+	When the buffer is full the oldest keyframe is dropped together with its
+	deltas. All memory is allocated up front.
+ */
+class RewindBuffer
+{
+	public:
+
+		explicit RewindBuffer(size_t capacity = g_rewindDefaultCapacity, uint32_t keyframeInterval = g_rewindDefaultKeyframeInterval, uint32_t maxFrames = g_rewindDefaultMaxFrames);
+
+		bool Push(const Interpreter& interpreter);
+		bool Rewind(Interpreter& interpreter);
+		void Clear();
+
+		uint32_t GetFrameCount() const;
+		size_t GetUsedBytes() const;
+
+	private:
+
+		/** One recorded frame */
+		struct Entry
+		{
+			/** Offset of the encoded data in m_data */
+			size_t offset;
+			/** Size of the encoded data */
+			size_t size;
+			/** Size of the decoded save state */
+			size_t stateSize;
+			/** Frames since the keyframe this entry is relative to, 0 for a keyframe */
+			uint32_t keyframeDistance;
+			/** Increases by one for every pushed frame */
+			uint64_t sequence;
+		};
+
+		Entry& GetEntry(uint32_t index);
+		bool Store(size_t size, size_t stateSize, uint32_t keyframeDistance);
+		void DropNewest();
+		void DropOldest();
+		bool LoadKeyframe(const Entry& entry);
+
+		static size_t Encode(const uint8_t* pState, const uint8_t* pKeyframe, size_t size, uint8_t* pOutput);
+		static bool Decode(const uint8_t* pInput, size_t inputSize, const uint8_t* pKeyframe, uint8_t* pState, size_t size);
+
+	private:
+
+		/** Frames between two keyframes */
+		uint32_t m_keyframeInterval;
+		/** Encoded frames, used as a ring */
+		std::vector<uint8_t> m_data;
+		/** Offset in m_data the next frame is written to */
+		size_t m_head;
+		/** Bytes of m_data used by stored frames */
+		size_t m_usedBytes;
+		/** Ring of recorded frames */
+		std::vector<Entry> m_entries;
+		/** Index of the oldest frame in m_entries */
+		uint32_t m_first;
+		/** Number of frames stored */
+		uint32_t m_count;
+		/** Sequence number of the next pushed frame */
+		uint64_t m_nextSequence;
+		/** Sequence number of the keyframe held decoded in m_keyframe, ~0 if none */
+		uint64_t m_keyframeSequence;
+		/** Decoded keyframe the newest deltas are relative to */
+		std::array<uint8_t, g_saveStateMaxSize> m_keyframe;
+		/** Save state being pushed or restored */
+		std::array<uint8_t, g_saveStateMaxSize> m_state;
+		/** Encoder output, large enough for the worst case */
+		std::array<uint8_t, g_saveStateMaxSize * 2> m_encoded;
+
+}; // RewindBuffer
+
+#endif // REWINDBUFFER_HPP_INCLUDED
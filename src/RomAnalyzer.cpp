@@ -0,0 +1,556 @@
+#include <algorithm>
+#include "RomAnalyzer.hpp"
+
+namespace
+{
+	/** Times the I interval of a block may grow before it is widened to everything */
+	constexpr uint8_t g_analyzerWidenVisits = 16;
+	/** Address a ROM is loaded at and starts executing from */
+	constexpr uint16_t g_analyzerEntry = 0x0200;
+
+	/**
+		Operations that skip the next instruction.
+	 */
+	bool IsSkip(Operation operation)
+	{
+		switch (operation)
+		{
+			case Operation::Op3xkk:
+			case Operation::Op4xkk:
+			case Operation::Op5xy0:
+			case Operation::Op9xy0:
+			case Operation::OpEx9E:
+			case Operation::OpExA1:
+				return true;
+			default:
+				return false;
+		};
+	};
+}
+
+/**
+	Retrieve the block containing an address.
+
+	@param[in] address Address of any byte of an instruction.
+	@return The block or null if no reachable block covers the address.
+ */
+const BasicBlock* RomAnalysis::FindBlock(uint16_t address) const
+{
+	auto it = std::upper_bound(blocks.begin(), blocks.end(), address, [](uint16_t value, const BasicBlock& block)
+	{
+		return value < block.start;
+	});
+
+	if (it == blocks.begin())
+	{
+		return nullptr;
+	};
+
+	--it;
+	return address < it->start + it->size ? &*it : nullptr;
+};
+
+/**
+	Retrieve whether the ROM is safe for engines that assume code never changes.\n
+	True if every jump target is known, no store may hit reachable code and
+	no two instructions share bytes.
+ */
+bool RomAnalysis::IsStatic() const
+{
+	return computedJumps.empty() && selfModifyingCode.empty() && !hasOverlappingCode;
+};
+
+/**
+	Default Constructor
+
+	@param[in] platform Instruction set to decode the ROM with.
+	@param[in] quirks Behaviours to assume, Fx55 and Fx65 may move I.
+ */
+RomAnalyzer::RomAnalyzer(Platform platform, QuirkProfile quirks) :
+	m_platform(platform),
+	m_quirks(GetQuirkFlags(quirks)),
+	m_addressMask(platform == Platform::XoChip ? g_xoRamSize - 1 : g_chipAddressMask)
+{
+};
+
+/**
+	Analyzes a ROM image.
+
+	@param[in] pRom The ROM, loaded at 0x200 like the interpreter does.
+	@param[in] romSize Size of the ROM in bytes, anything past the memory of the platform is ignored.
+	@return What was found.
+ */
+RomAnalysis RomAnalyzer::Analyze(const uint8_t* pRom, size_t romSize)
+{
+	m_memory.assign(m_addressMask + 1, 0x00);
+	romSize = std::min(romSize, m_memory.size() - g_analyzerEntry);
+	std::copy(pRom, pRom + romSize, m_memory.begin() + g_analyzerEntry);
+	m_leaders.reset();
+	m_callTargets.reset();
+
+	RomAnalysis analysis;
+	analysis.platform = m_platform;
+	analysis.entry = g_analyzerEntry;
+	analysis.unknownOpcodes = 0;
+	analysis.hasOverlappingCode = false;
+
+	FindInstructions(analysis);
+	BuildBlocks(analysis);
+	BuildSubroutines(analysis);
+	FindCodeWrites(analysis);
+	FindDataRegions(analysis, romSize);
+	return analysis;
+};
+
+/**
+	Decodes the instruction at an address, wrapping like the interpreter's program counter.
+ */
+Instruction RomAnalyzer::DecodeAt(uint16_t address) const
+{
+	uint16_t opcode = (m_memory[address & g_chipAddressMask] << 8) | m_memory[(address + 1) & g_chipAddressMask];
+	return DecodeInstruction(opcode, m_platform);
+};
+
+/**
+	Retrieve the size of an instruction in bytes, F000 nnnn takes four.
+ */
+uint16_t RomAnalyzer::GetInstructionSize(const Instruction& instruction) const
+{
+	return instruction.operation == Operation::OpF000 ? g_chipInstructionSize * 2 : g_chipInstructionSize;
+};
+
+/**
+	Retrieve how far a taken skip moves past the instruction at an address, like Interpreter::GetSkipSize().
+ */
+uint16_t RomAnalyzer::GetSkipSize(uint16_t address) const
+{
+	if (m_platform == Platform::XoChip &&
+		m_memory[address & g_chipAddressMask] == 0xF0 && m_memory[(address + 1) & g_chipAddressMask] == 0x00)
+	{
+		return g_chipInstructionSize * 2;
+	};
+
+	return g_chipInstructionSize;
+};
+
+/**
+	Follows every path from the entry point, marking the reachable instructions and the block leaders.
+ */
+void RomAnalyzer::FindInstructions(RomAnalysis& analysis)
+{
+	std::vector<uint16_t> pending;
+	auto branch = [this, &pending](uint16_t target)
+	{
+		target &= g_chipAddressMask;
+		m_leaders.set(target);
+		pending.push_back(target);
+	};
+
+	branch(analysis.entry);
+	while (!pending.empty())
+	{
+		uint16_t address = pending.back();
+		pending.pop_back();
+
+		while (!analysis.instructions.test(address))
+		{
+			Instruction instruction = DecodeAt(address);
+			uint16_t size = GetInstructionSize(instruction);
+			analysis.instructions.set(address);
+			for (uint16_t i = 0; i < size; i++)
+			{
+				uint16_t byte = (address + i) & g_chipAddressMask;
+				analysis.hasOverlappingCode |= analysis.code.test(byte);
+				analysis.code.set(byte);
+			};
+
+			uint16_t next = (address + size) & g_chipAddressMask;
+			bool continues = false;
+			switch (instruction.operation)
+			{
+				case Operation::Op1nnn:
+					branch(instruction.nnn);
+					break;
+
+				case Operation::Op2nnn:
+					m_callTargets.set(instruction.nnn);
+					branch(instruction.nnn);
+					branch(next);
+					break;
+
+				case Operation::Op00EE:
+				case Operation::Op00FD:
+					break;
+
+				case Operation::OpBnnn:
+					analysis.computedJumps.push_back(address);
+					break;
+
+				case Operation::OpFx0A:
+					branch(next);
+					break;
+
+				case Operation::Unknown:
+					analysis.unknownOpcodes++;
+					continues = true;
+					break;
+
+				default:
+					if (IsSkip(instruction.operation))
+					{
+						branch(next);
+						branch(next + GetSkipSize(next));
+						break;
+					};
+					continues = true;
+					break;
+			};
+
+			if (!continues)
+			{
+				break;
+			};
+
+			// Falling in to code found earlier, which makes it a merge point.
+			if (analysis.instructions.test(next))
+			{
+				m_leaders.set(next);
+			};
+			address = next;
+		};
+	};
+
+	std::sort(analysis.computedJumps.begin(), analysis.computedJumps.end());
+};
+
+/**
+	Splits the reachable instructions in to basic blocks at the leaders.
+ */
+void RomAnalyzer::BuildBlocks(RomAnalysis& analysis)
+{
+	for (uint32_t start = 0; start < g_chipRamSize; start++)
+	{
+		if (!m_leaders.test(start) || !analysis.instructions.test(start))
+		{
+			continue;
+		};
+
+		BasicBlock block;
+		block.start = static_cast<uint16_t>(start);
+		block.size = 0;
+		block.instructionCount = 0;
+		block.exit = BlockExit::Fallthrough;
+		block.callee = 0;
+
+		uint16_t address = block.start;
+		while (true)
+		{
+			Instruction instruction = DecodeAt(address);
+			uint16_t size = GetInstructionSize(instruction);
+			uint16_t next = (address + size) & g_chipAddressMask;
+			block.size += size;
+			block.instructionCount++;
+
+			bool ends = true;
+			switch (instruction.operation)
+			{
+				case Operation::Op1nnn:
+					block.exit = BlockExit::Jump;
+					block.successors.push_back(instruction.nnn);
+					break;
+
+				case Operation::Op2nnn:
+					block.exit = BlockExit::Call;
+					block.callee = instruction.nnn;
+					block.successors.push_back(next);
+					break;
+
+				case Operation::Op00EE:
+					block.exit = BlockExit::Return;
+					break;
+
+				case Operation::Op00FD:
+					block.exit = BlockExit::Halt;
+					break;
+
+				case Operation::OpBnnn:
+					block.exit = BlockExit::Computed;
+					break;
+
+				case Operation::OpFx0A:
+					block.exit = BlockExit::Wait;
+					block.successors.push_back(next);
+					break;
+
+				default:
+					if (IsSkip(instruction.operation))
+					{
+						block.exit = BlockExit::Skip;
+						block.successors.push_back(next);
+						block.successors.push_back((next + GetSkipSize(next)) & g_chipAddressMask);
+						break;
+					};
+					ends = false;
+					break;
+			};
+
+			if (ends)
+			{
+				break;
+			};
+
+			if (m_leaders.test(next) || !analysis.instructions.test(next) || block.instructionCount == g_chipRamSize / g_chipInstructionSize)
+			{
+				block.successors.push_back(next);
+				break;
+			};
+			address = next;
+		};
+
+		analysis.blocks.push_back(block);
+	};
+};
+
+/**
+	Groups the blocks in to the main program and the subroutines it calls.
+ */
+void RomAnalyzer::BuildSubroutines(RomAnalysis& analysis)
+{
+	std::vector<int32_t> blockIndex(g_chipRamSize, -1);
+	for (size_t i = 0; i < analysis.blocks.size(); i++)
+	{
+		blockIndex[analysis.blocks[i].start] = static_cast<int32_t>(i);
+	};
+
+	std::bitset<g_chipRamSize> entries = m_callTargets;
+	entries.set(analysis.entry);
+
+	for (uint32_t entry = 0; entry < g_chipRamSize; entry++)
+	{
+		if (!entries.test(entry) || blockIndex[entry] < 0)
+		{
+			continue;
+		};
+
+		Subroutine subroutine;
+		subroutine.entry = static_cast<uint16_t>(entry);
+
+		std::vector<bool> visited(analysis.blocks.size(), false);
+		std::vector<int32_t> pending = { blockIndex[entry] };
+		visited[blockIndex[entry]] = true;
+		while (!pending.empty())
+		{
+			const BasicBlock& block = analysis.blocks[pending.back()];
+			pending.pop_back();
+			subroutine.blocks.push_back(block.start);
+			if (block.exit == BlockExit::Call)
+			{
+				subroutine.callees.push_back(block.callee);
+			};
+
+			for (uint16_t successor : block.successors)
+			{
+				int32_t index = blockIndex[successor];
+				if (index >= 0 && !visited[index])
+				{
+					visited[index] = true;
+					pending.push_back(index);
+				};
+			};
+		};
+
+		std::sort(subroutine.blocks.begin(), subroutine.blocks.end());
+		std::sort(subroutine.callees.begin(), subroutine.callees.end());
+		subroutine.callees.erase(std::unique(subroutine.callees.begin(), subroutine.callees.end()), subroutine.callees.end());
+		analysis.subroutines.push_back(subroutine);
+	};
+};
+
+/**
+	Tracks the values I can have at every store and reports the stores that may hit reachable code.\n
+	I is an interval per block entry, merged over all predecessors until
+	nothing changes. Calls hand I to the subroutine and assume it comes
+	back holding anything.
+ */
+void RomAnalyzer::FindCodeWrites(RomAnalysis& analysis)
+{
+	const Interval anything = { 0, 0xFFFF };
+	std::vector<int32_t> blockIndex(g_chipRamSize, -1);
+	for (size_t i = 0; i < analysis.blocks.size(); i++)
+	{
+		blockIndex[analysis.blocks[i].start] = static_cast<int32_t>(i);
+	};
+
+	std::vector<Interval> entryValues(analysis.blocks.size(), anything);
+	std::vector<bool> isReached(analysis.blocks.size(), false);
+	std::vector<uint8_t> visits(analysis.blocks.size(), 0);
+	std::vector<int32_t> pending;
+
+	auto merge = [&](uint16_t target, Interval value)
+	{
+		int32_t index = blockIndex[target];
+		if (index < 0)
+		{
+			return;
+		};
+
+		Interval& current = entryValues[index];
+		if (isReached[index])
+		{
+			value = { std::min(value.low, current.low), std::max(value.high, current.high) };
+			if (value.low == current.low && value.high == current.high)
+			{
+				return;
+			};
+
+			// Loops stepping I would otherwise grow the interval one step per pass.
+			if (++visits[index] > g_analyzerWidenVisits)
+			{
+				value = anything;
+			};
+		};
+
+		current = value;
+		isReached[index] = true;
+		pending.push_back(index);
+	};
+
+	// Stores per writer, grown as the values of I grow.
+	std::vector<Interval> stores(g_chipRamSize, Interval{ 1, 0 });
+	auto store = [&stores](uint16_t writer, Interval target)
+	{
+		Interval& current = stores[writer];
+		current = current.low > current.high ? target : Interval{ std::min(current.low, target.low), std::max(current.high, target.high) };
+	};
+
+	// I is zero at power on.
+	merge(analysis.entry, Interval{ 0, 0 });
+	while (!pending.empty())
+	{
+		const BasicBlock& block = analysis.blocks[pending.back()];
+		Interval value = entryValues[pending.back()];
+		pending.pop_back();
+
+		uint16_t address = block.start;
+		for (uint16_t i = 0; i < block.instructionCount; i++)
+		{
+			Instruction instruction = DecodeAt(address);
+			uint16_t advance = m_quirks.incrementsI ? instruction.x + 1 : 0;
+			switch (instruction.operation)
+			{
+				case Operation::OpAnnn:
+					value = { instruction.nnn, instruction.nnn };
+					break;
+
+				case Operation::OpF000:
+				{
+					uint32_t target = (m_memory[(address + 2) & g_chipAddressMask] << 8) | m_memory[(address + 3) & g_chipAddressMask];
+					value = { target, target };
+					break;
+				}
+
+				case Operation::OpFx1E:
+					value = Widen({ value.low, value.high + 0xFF });
+					break;
+
+				case Operation::OpFx29:
+					value = { 0, g_chipFontsetSize - 1 };
+					break;
+
+				case Operation::OpFx30:
+					value = { g_chipBigFontAddress, g_chipBigFontAddress + g_chipBigFontsetSize - 1 };
+					break;
+
+				case Operation::OpFx33:
+					store(address, { value.low, value.high + 2 });
+					break;
+
+				case Operation::OpFx55:
+					store(address, { value.low, value.high + instruction.x });
+					value = Widen({ value.low + advance, value.high + advance });
+					break;
+
+				case Operation::OpFx65:
+					value = Widen({ value.low + advance, value.high + advance });
+					break;
+
+				case Operation::Op5xy2:
+					store(address, { value.low, value.high + (instruction.x > instruction.y ? instruction.x - instruction.y : instruction.y - instruction.x) });
+					break;
+
+				case Operation::Op2nnn:
+					merge(instruction.nnn, value);
+					value = anything;
+					break;
+
+				default:
+					break;
+			};
+
+			address = (address + GetInstructionSize(instruction)) & g_chipAddressMask;
+		};
+
+		for (uint16_t successor : block.successors)
+		{
+			merge(successor, value);
+		};
+	};
+
+	for (uint32_t writer = 0; writer < g_chipRamSize; writer++)
+	{
+		Interval target = stores[writer];
+		if (target.low > target.high)
+		{
+			continue;
+		};
+
+		// Stores past the end of memory wrap around to its start.
+		if (target.high > m_addressMask)
+		{
+			target = { 0, m_addressMask };
+		};
+
+		uint32_t last = std::min<uint32_t>(target.high, g_chipRamSize - 1);
+		for (uint32_t byte = target.low; byte <= last; byte++)
+		{
+			if (analysis.code.test(byte))
+			{
+				bool isResolved = target.low != 0 || target.high != m_addressMask;
+				analysis.selfModifyingCode.push_back(WriteCandidate{ static_cast<uint16_t>(writer), MemoryRegion{ target.low, target.high }, isResolved });
+				break;
+			};
+		};
+	};
+};
+
+/**
+	Collects the runs of ROM bytes no reachable instruction covers.
+ */
+void RomAnalyzer::FindDataRegions(RomAnalysis& analysis, size_t romSize)
+{
+	uint32_t end = g_analyzerEntry + static_cast<uint32_t>(romSize);
+	for (uint32_t address = g_analyzerEntry; address < end; address++)
+	{
+		if (address < g_chipRamSize && analysis.code.test(address))
+		{
+			continue;
+		};
+
+		if (!analysis.dataRegions.empty() && analysis.dataRegions.back().last + 1 == address)
+		{
+			analysis.dataRegions.back().last = address;
+		}
+		else
+		{
+			analysis.dataRegions.push_back(MemoryRegion{ address, address });
+		};
+	};
+};
+
+/**
+	Retrieve an interval of I, or every value if it ran past the 16 bits of I.
+ */
+RomAnalyzer::Interval RomAnalyzer::Widen(Interval interval) const
+{
+	return interval.high > 0xFFFF ? Interval{ 0, 0xFFFF } : interval;
+};
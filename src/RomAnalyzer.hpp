@@ -0,0 +1,183 @@
+#ifndef ROMANALYZER_HPP_INCLUDED
+#define ROMANALYZER_HPP_INCLUDED
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Instruction.hpp"
+#include "Interpreter.hpp"
+#include "Quirks.hpp"
+
+/**
+	How control leaves a basic block.
+		Fallthrough - Runs in to the next block.
+		Jump - 1nnn.
+		Call - 2nnn, continues after the call once the subroutine returns.
+		Return - 00EE.
+		Skip - A conditional skip, continues at the next instruction or the one after.
+		Computed - Bnnn, the target is only known at run time.
+		Wait - Fx0A, repeats until a key is pressed.
+		Halt - 00FD, repeats forever.
+ */
+enum class BlockExit : uint8_t
+{
+	Fallthrough,
+	Jump,
+	Call,
+	Return,
+	Skip,
+	Computed,
+	Wait,
+	Halt
+};
+
+/**
+	Straight line run of instructions with a single entry at the top.
+ */
+struct BasicBlock
+{
+	/** Address of the first instruction */
+	uint16_t start;
+	/** Size in bytes */
+	uint16_t size;
+	/** Number of instructions */
+	uint16_t instructionCount;
+	/** How control leaves the block */
+	BlockExit exit;
+	/** Entry point called by a Call block */
+	uint16_t callee;
+	/** Blocks control continues in within the same subroutine, the return site for a Call */
+	std::vector<uint16_t> successors;
+};
+
+/**
+	Code reachable from an entry point without following calls.
+ */
+struct Subroutine
+{
+	/** Entry point, the ROM start for the main program */
+	uint16_t entry;
+	/** Start addresses of the blocks belonging to the subroutine */
+	std::vector<uint16_t> blocks;
+	/** Entry points of the subroutines it calls */
+	std::vector<uint16_t> callees;
+};
+
+/**
+	Range of memory, both ends inclusive.
+ */
+struct MemoryRegion
+{
+	/** First address */
+	uint32_t first;
+	/** Last address */
+	uint32_t last;
+};
+
+/**
+	A store that may overwrite code.
+ */
+struct WriteCandidate
+{
+	/** Address of the storing instruction */
+	uint16_t writer;
+	/** Addresses it may write to */
+	MemoryRegion target;
+	/** false if I could not be narrowed down and the store may write anywhere */
+	bool isResolved;
+};
+
+/**
+	Everything RomAnalyzer found out about a ROM.
+ */
+struct RomAnalysis
+{
+	/** Instruction set the ROM was decoded with */
+	Platform platform;
+	/** Address execution starts at */
+	uint16_t entry;
+	/** Basic blocks ordered by start address */
+	std::vector<BasicBlock> blocks;
+	/** Main program and every called subroutine, ordered by entry point */
+	std::vector<Subroutine> subroutines;
+	/** ROM bytes no reachable instruction covers */
+	std::vector<MemoryRegion> dataRegions;
+	/** Stores that may modify reachable code */
+	std::vector<WriteCandidate> selfModifyingCode;
+	/** Addresses of Bnnn instructions */
+	std::vector<uint16_t> computedJumps;
+	/** Bit a is set if a reachable instruction starts at address a */
+	std::bitset<g_chipRamSize> instructions;
+	/** Bit a is set if a reachable instruction covers address a */
+	std::bitset<g_chipRamSize> code;
+	/** Reachable opcodes the platform does not know, executed as no-ops */
+	uint32_t unknownOpcodes;
+	/** Some reachable instructions share bytes */
+	bool hasOverlappingCode;
+
+	const BasicBlock* FindBlock(uint16_t address) const;
+	bool IsStatic() const;
+};
+
+/**
+	Decodes a ROM without running it.\n
+	Starting at the entry point, 1nnn, 2nnn and skips are followed
+	recursively with the same decoding and the same program counter rules
+	as the interpreter, which yields the reachable instructions, their basic
+	blocks and the call graph. Everything in the ROM that is never reached
+	is reported as data. The possible values of I are tracked as an interval
+	per block so stores can be checked against the code they might
+	overwrite. Computed jumps end the search, code only reachable through
+	them shows up as data.
+ */
+class RomAnalyzer
+{
+	public:
+
+		explicit RomAnalyzer(Platform platform = Platform::Chip8, QuirkProfile quirks = QuirkProfile::Default);
+
+		RomAnalysis Analyze(const uint8_t* pRom, size_t romSize);
+
+	private:
+
+		/** Possible values of I, both ends inclusive */
+		struct Interval
+		{
+			/** Smallest value */
+			uint32_t low;
+			/** Largest value */
+			uint32_t high;
+		};
+
+		Instruction DecodeAt(uint16_t address) const;
+		uint16_t GetInstructionSize(const Instruction& instruction) const;
+		uint16_t GetSkipSize(uint16_t address) const;
+
+		void FindInstructions(RomAnalysis& analysis);
+		void BuildBlocks(RomAnalysis& analysis);
+		void BuildSubroutines(RomAnalysis& analysis);
+		void FindCodeWrites(RomAnalysis& analysis);
+		void FindDataRegions(RomAnalysis& analysis, size_t romSize);
+
+		Interval Widen(Interval interval) const;
+
+	private:
+
+		/** Instruction set to decode */
+		Platform m_platform;
+		/** Behaviours affecting I */
+		QuirkFlags m_quirks;
+		/** Mask wrapping a data address to the memory of the platform */
+		uint32_t m_addressMask;
+		/** Memory as the interpreter sees it after loading the ROM */
+		std::vector<uint8_t> m_memory;
+		/** Addresses starting a basic block */
+		std::bitset<g_chipRamSize> m_leaders;
+		/** Entry points of called subroutines */
+		std::bitset<g_chipRamSize> m_callTargets;
+
+}; // RomAnalyzer
+
+#endif // ROMANALYZER_HPP_INCLUDED
@@ -0,0 +1,136 @@
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#include "RomCache.hpp"
+
+/**
+	Retrieve the cache shared by the whole process.
+ */
+RomCache& RomCache::GetInstance()
+{
+	static RomCache s_instance;
+	return s_instance;
+};
+
+/**
+	Loads a ROM file, reading it only if it is not cached yet.
+
+	@param[in] filePath Path to the ROM file.
+	@param[in] maxSize Largest accepted file size.
+	@param[out] status Why no ROM was returned.
+	@return The ROM or null on failure.
+ */
+std::shared_ptr<const Rom> RomCache::Load(const char* filePath, size_t maxSize, RomStatus& status)
+{
+	struct stat info;
+	if (filePath == nullptr || stat(filePath, &info) != 0)
+	{
+		status = RomStatus::NotFound;
+		return nullptr;
+	};
+
+	if (static_cast<uint64_t>(info.st_size) > maxSize)
+	{
+		status = RomStatus::TooLarge;
+		return nullptr;
+	};
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_paths.find(filePath);
+		if (it != m_paths.end() && it->second.size == static_cast<uint64_t>(info.st_size) && it->second.modified == static_cast<int64_t>(info.st_mtime))
+		{
+			status = RomStatus::Loaded;
+			return it->second.pRom;
+		};
+	};
+
+	FILE* pFile = std::fopen(filePath, "rb");
+	if (pFile == nullptr)
+	{
+		status = RomStatus::NotFound;
+		return nullptr;
+	};
+
+	// One unbuffered read of one byte more than allowed, so a file that grew since stat() is still caught.
+	std::setvbuf(pFile, nullptr, _IONBF, 0);
+	std::shared_ptr<Rom> pRom = std::make_shared<Rom>();
+	pRom->data.resize(maxSize + 1);
+	size_t size = std::fread(pRom->data.data(), 1, pRom->data.size(), pFile);
+	bool isReadError = std::ferror(pFile) != 0;
+	std::fclose(pFile);
+
+	if (isReadError)
+	{
+		status = RomStatus::ReadError;
+		return nullptr;
+	};
+
+	if (size > maxSize)
+	{
+		status = RomStatus::TooLarge;
+		return nullptr;
+	};
+
+	pRom->data.resize(size);
+	pRom->data.shrink_to_fit();
+	pRom->hash = Hash(pRom->data.data(), size);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// Share the contents with an identical ROM loaded through another path.
+	std::shared_ptr<const Rom> pShared = pRom;
+	auto range = m_roms.equal_range(pRom->hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second->data == pRom->data)
+		{
+			pShared = it->second;
+			break;
+		};
+	};
+	if (pShared == pRom)
+	{
+		m_roms.emplace(pRom->hash, pShared);
+	};
+
+	PathEntry& entry = m_paths[filePath];
+	entry.size = static_cast<uint64_t>(info.st_size);
+	entry.modified = static_cast<int64_t>(info.st_mtime);
+	entry.pRom = pShared;
+
+	status = RomStatus::Loaded;
+	return pShared;
+};
+
+/**
+	Forgets every cached ROM, instances keep the ROMs they hold.
+ */
+void RomCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_paths.clear();
+	m_roms.clear();
+};
+
+/**
+	Retrieve the number of distinct ROM contents cached.
+ */
+size_t RomCache::GetRomCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_roms.size();
+};
+
+/**
+	Hashes ROM contents (FNV-1a).
+ */
+uint64_t RomCache::Hash(const uint8_t* pData, size_t size)
+{
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash = (hash ^ pData[i]) * 0x100000001B3ULL;
+	};
+	return hash;
+};
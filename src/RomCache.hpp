@@ -0,0 +1,86 @@
+#ifndef ROMCACHE_HPP_INCLUDED
+#define ROMCACHE_HPP_INCLUDED
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+	Outcome of RomCache::Load().
+		Loaded - The ROM is returned.
+		NotFound - The file could not be opened.
+		TooLarge - The file is larger than the requested maximum.
+		ReadError - The file could not be read completely.
+ */
+enum class RomStatus : uint8_t
+{
+	Loaded,
+	NotFound,
+	TooLarge,
+	ReadError
+};
+
+/**
+	Contents of a ROM file, shared by every instance running it.
+ */
+struct Rom
+{
+	/** FNV-1a hash of the data */
+	uint64_t hash;
+	/** The file contents */
+	std::vector<uint8_t> data;
+};
+
+/**
+	Process wide cache of ROM files.\n
+	Files are read with one bulk read and stored by content hash, so ROMs
+	with identical contents are kept once no matter how many paths lead to
+	them. A path is remembered together with its size and modification
+	time, loading it again only costs a stat() until the file changes.
+	Safe to use from several threads.
+ */
+class RomCache
+{
+	public:
+
+		static RomCache& GetInstance();
+
+		std::shared_ptr<const Rom> Load(const char* filePath, size_t maxSize, RomStatus& status);
+		void Clear();
+		size_t GetRomCount() const;
+
+		static uint64_t Hash(const uint8_t* pData, size_t size);
+
+	private:
+
+		RomCache() = default;
+
+		/** What a path referred to when it was read */
+		struct PathEntry
+		{
+			/** File size */
+			uint64_t size;
+			/** Modification time */
+			int64_t modified;
+			/** The contents */
+			std::shared_ptr<const Rom> pRom;
+		};
+
+	private:
+
+		/** Guards both maps */
+		mutable std::mutex m_mutex;
+		/** Loaded paths */
+		std::unordered_map<std::string, PathEntry> m_paths;
+		/** ROMs by content hash, identical files share one entry */
+		std::multimap<uint64_t, std::shared_ptr<const Rom>> m_roms;
+
+}; // RomCache
+
+#endif // ROMCACHE_HPP_INCLUDED
@@ -0,0 +1,189 @@
+#include <thread>
+#include "Scheduler.hpp"
+
+/**
+	Default Constructor
+
+	@param[in] instructionsPerSecond Guest speed.
+ */
+Scheduler::Scheduler(uint32_t instructionsPerSecond) : m_instructionsPerSecond(instructionsPerSecond), m_instructionRemainder(0), m_ticks(0), m_speed(1), m_frameSkip(1), m_presentTick(0)
+{
+	SetRefreshRate(g_timerFrequency);
+	Start();
+};
+
+/**
+	Sets the guest speed, takes effect from the next tick.
+ */
+void Scheduler::SetInstructionsPerSecond(uint32_t instructionsPerSecond)
+{
+	m_instructionsPerSecond = instructionsPerSecond;
+};
+
+/**
+	Retrieve the guest speed.
+ */
+uint32_t Scheduler::GetInstructionsPerSecond() const
+{
+	return m_instructionsPerSecond;
+};
+
+/**
+	Sets the refresh rate of the display frames are presented on.
+
+	@param[in] refreshRate Display refresh rate in Hz, 0 if unknown.
+ */
+void Scheduler::SetRefreshRate(uint32_t refreshRate)
+{
+	if (refreshRate == 0)
+	{
+		refreshRate = g_timerFrequency;
+	};
+
+	// Allow an eighth of a refresh of jitter so a frame is not dropped when a tick runs late.
+	m_presentInterval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / refreshRate));
+	m_presentInterval -= m_presentInterval / 8;
+};
+
+/**
+	Sets how fast guest time runs, takes effect immediately.\n
+	Timers still tick once per guest tick, so the guest sees no difference.
+
+	@param[in] multiplier Guest seconds per wall clock second, 1 for real time or g_schedulerUnthrottled.
+ */
+void Scheduler::SetSpeed(uint32_t multiplier)
+{
+	m_speed = multiplier;
+
+	// Continue from now, the tick due at this moment already ran.
+	m_start = Clock::now();
+	m_ticks = 1;
+	m_presentTick = 0;
+};
+
+/**
+	Retrieve how fast guest time runs, see SetSpeed().
+ */
+uint32_t Scheduler::GetSpeed() const
+{
+	return m_speed;
+};
+
+/**
+	Sets the fewest ticks between two presented frames when not running in real time.
+
+	@param[in] ticks Present at most one frame in this many ticks.
+ */
+void Scheduler::SetFrameSkip(uint32_t ticks)
+{
+	m_frameSkip = ticks;
+};
+
+/**
+	Starts guest time at the current wall clock time.
+ */
+void Scheduler::Start()
+{
+	m_start = Clock::now();
+	m_lastPresent = m_start - m_presentInterval;
+	m_ticks = 0;
+	m_presentTick = 0;
+	m_instructionRemainder = 0;
+};
+
+/**
+	Retrieve the number of ticks that became due since the last call.\n
+	When the host falls behind by more than g_schedulerMaxCatchUpTicks of
+	wall clock time the extra ticks are dropped, so the guest slows down
+	instead of spiralling. Unthrottled, a fixed number of ticks is always due.
+ */
+uint32_t Scheduler::PollTicks()
+{
+	if (m_speed == g_schedulerUnthrottled)
+	{
+		m_ticks += g_schedulerUnthrottledTicks;
+		return g_schedulerUnthrottledTicks;
+	};
+
+	Clock::duration elapsed = Clock::now() - m_start;
+	uint64_t due = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) * g_timerFrequency * m_speed / 1000000000ULL + 1;
+	if (due <= m_ticks)
+	{
+		return 0;
+	};
+
+	uint64_t pending = due - m_ticks;
+	if (pending > g_schedulerMaxCatchUpTicks * m_speed)
+	{
+		pending = g_schedulerMaxCatchUpTicks * m_speed;
+	};
+
+	m_ticks = due;
+	return static_cast<uint32_t>(pending);
+};
+
+/**
+	Retrieve the number of instructions to run for the next tick.\n
+	Spreads instructions per second that are not a multiple of 60 evenly over the ticks.
+ */
+uint32_t Scheduler::GetTickInstructions()
+{
+	m_instructionRemainder += m_instructionsPerSecond;
+	uint32_t instructions = m_instructionRemainder / g_timerFrequency;
+	m_instructionRemainder %= g_timerFrequency;
+	return instructions;
+};
+
+/**
+	Checks if enough time passed since the last presented frame.
+
+	@return true if a frame should be presented now, which restarts the interval.
+ */
+bool Scheduler::ShouldPresent()
+{
+	if (!IsRealTime() && m_ticks - m_presentTick < m_frameSkip)
+	{
+		return false;
+	};
+
+	Clock::time_point now = Clock::now();
+	if (now - m_lastPresent < m_presentInterval)
+	{
+		return false;
+	};
+
+	m_lastPresent = now;
+	m_presentTick = m_ticks;
+	return true;
+};
+
+/**
+	Sleeps until the next tick is due, returns at once when unthrottled.
+ */
+void Scheduler::WaitForNextTick() const
+{
+	if (m_speed == g_schedulerUnthrottled)
+	{
+		return;
+	};
+
+	std::this_thread::sleep_until(GetTickDeadline(m_ticks));
+};
+
+/**
+	Retrieve the wall clock time a tick is due.
+
+	@param[in] tick Index of the tick, the first tick is due at Start().
+ */
+Scheduler::Clock::time_point Scheduler::GetTickDeadline(uint64_t tick) const
+{
+	return m_start + std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(tick * 1000000000ULL / (g_timerFrequency * m_speed)));
+};
+
+/**
+	Checks if guest time runs at wall clock speed.
+ */
+bool Scheduler::IsRealTime() const
+{
+	return m_speed == 1;
+};
@@ -0,0 +1,78 @@
+#ifndef SCHEDULER_HPP_INCLUDED
+#define SCHEDULER_HPP_INCLUDED
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+/** Rate of the delay and sound timers */
+constexpr uint32_t g_timerFrequency = 60;
+/** Guest speed used when none is configured */
+constexpr uint32_t g_defaultInstructionsPerSecond = 700;
+/** Most timer ticks run back to back after the host fell behind, older ones are dropped */
+constexpr uint32_t g_schedulerMaxCatchUpTicks = 6;
+/** Speed multiplier running the guest as fast as the host can */
+constexpr uint32_t g_schedulerUnthrottled = 0;
+/** Ticks handed out by each poll while unthrottled */
+constexpr uint32_t g_schedulerUnthrottledTicks = 16;
+
+/**
+	Fixed timestep clock pacing the guest against wall clock time.\n
+	Guest time advances in 60 Hz timer ticks, each tick runs its share of the
+	configured instructions per second followed by one timer decrement.
+	Presentation is limited to the display refresh rate and the host sleeps
+	until the next tick is due instead of spinning.
+	Guest time can run at a multiple of wall clock time, or unthrottled, in
+	which case at most one frame in every few ticks is presented.
+ */
+class Scheduler
+{
+	public:
+
+		/** Clock used for all deadlines */
+		typedef std::chrono::steady_clock Clock;
+
+		explicit Scheduler(uint32_t instructionsPerSecond = g_defaultInstructionsPerSecond);
+
+		void SetInstructionsPerSecond(uint32_t instructionsPerSecond);
+		uint32_t GetInstructionsPerSecond() const;
+		void SetRefreshRate(uint32_t refreshRate);
+		void SetSpeed(uint32_t multiplier);
+		uint32_t GetSpeed() const;
+		void SetFrameSkip(uint32_t ticks);
+
+		void Start();
+		uint32_t PollTicks();
+		uint32_t GetTickInstructions();
+		bool ShouldPresent();
+		void WaitForNextTick() const;
+
+	private:
+
+		Clock::time_point GetTickDeadline(uint64_t tick) const;
+		bool IsRealTime() const;
+
+	private:
+
+		/** Guest instructions per second of guest time */
+		uint32_t m_instructionsPerSecond;
+		/** Instructions carried over between ticks, in 1/60 instructions */
+		uint32_t m_instructionRemainder;
+		/** Shortest time between two presented frames */
+		Clock::duration m_presentInterval;
+		/** Time the first tick was due */
+		Clock::time_point m_start;
+		/** Time of the last presented frame */
+		Clock::time_point m_lastPresent;
+		/** Ticks handed out since Start() */
+		uint64_t m_ticks;
+		/** Guest seconds per wall clock second, g_schedulerUnthrottled for as fast as possible */
+		uint32_t m_speed;
+		/** Fewest ticks between two presented frames when not running in real time */
+		uint32_t m_frameSkip;
+		/** Value of m_ticks at the last presented frame */
+		uint64_t m_presentTick;
+
+}; // Scheduler
+
+#endif // SCHEDULER_HPP_INCLUDED
@@ -0,0 +1,215 @@
+#ifndef SIMD_HPP_INCLUDED
+#define SIMD_HPP_INCLUDED
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+/*! \file
+		Thin wrappers over the widest integer vector the target supports.\n
+		AVX2 (32 lanes of 8 bits) when compiled with AVX2 enabled, SSE2 (16 lanes)
+		on any other x86-64 target and a plain array elsewhere. Masks are vectors
+		where every lane is either all zeros or all ones.
+ */
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CHIP8_SIMD_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CHIP8_SIMD_SSE2 1
+#endif
+
+#if CHIP8_SIMD_AVX2
+/** Vector register type */
+typedef __m256i SimdVector;
+/** Number of bytes in a SimdVector */
+constexpr uint32_t g_simdBytes = 32;
+#elif CHIP8_SIMD_SSE2
+typedef __m128i SimdVector;
+constexpr uint32_t g_simdBytes = 16;
+#else
+struct SimdVector
+{
+	uint8_t bytes[16];
+};
+constexpr uint32_t g_simdBytes = 16;
+#endif
+
+/** Lane counts are rounded up to a multiple of this, enough for every vector width */
+constexpr uint32_t g_simdLaneAlignment = 32;
+
+#if CHIP8_SIMD_AVX2
+
+inline SimdVector SimdLoad(const void* pSource) { return _mm256_loadu_si256(static_cast<const __m256i*>(pSource)); };
+inline void SimdStore(void* pDestination, SimdVector value) { _mm256_storeu_si256(static_cast<__m256i*>(pDestination), value); };
+inline SimdVector SimdZero() { return _mm256_setzero_si256(); };
+inline SimdVector SimdSetU8(uint8_t value) { return _mm256_set1_epi8(static_cast<char>(value)); };
+inline SimdVector SimdSetU16(uint16_t value) { return _mm256_set1_epi16(static_cast<short>(value)); };
+inline SimdVector SimdSetU32(uint32_t value) { return _mm256_set1_epi32(static_cast<int>(value)); };
+inline SimdVector SimdAnd(SimdVector a, SimdVector b) { return _mm256_and_si256(a, b); };
+inline SimdVector SimdOr(SimdVector a, SimdVector b) { return _mm256_or_si256(a, b); };
+inline SimdVector SimdXor(SimdVector a, SimdVector b) { return _mm256_xor_si256(a, b); };
+inline SimdVector SimdAndNot(SimdVector mask, SimdVector value) { return _mm256_andnot_si256(mask, value); };
+inline SimdVector SimdAddU8(SimdVector a, SimdVector b) { return _mm256_add_epi8(a, b); };
+inline SimdVector SimdSubU8(SimdVector a, SimdVector b) { return _mm256_sub_epi8(a, b); };
+inline SimdVector SimdSubSaturateU8(SimdVector a, SimdVector b) { return _mm256_subs_epu8(a, b); };
+inline SimdVector SimdMaxU8(SimdVector a, SimdVector b) { return _mm256_max_epu8(a, b); };
+inline SimdVector SimdEqualU8(SimdVector a, SimdVector b) { return _mm256_cmpeq_epi8(a, b); };
+inline SimdVector SimdAddU16(SimdVector a, SimdVector b) { return _mm256_add_epi16(a, b); };
+inline SimdVector SimdEqualU16(SimdVector a, SimdVector b) { return _mm256_cmpeq_epi16(a, b); };
+inline SimdVector SimdEqualU32(SimdVector a, SimdVector b) { return _mm256_cmpeq_epi32(a, b); };
+inline SimdVector SimdShiftRightU16(SimdVector a, int bits) { return _mm256_srli_epi16(a, bits); };
+inline SimdVector SimdBlend(SimdVector mask, SimdVector a, SimdVector b) { return _mm256_blendv_epi8(a, b, mask); };
+inline uint32_t SimdMoveMask(SimdVector mask) { return static_cast<uint32_t>(_mm256_movemask_epi8(mask)); };
+
+/** Widens the lower half of an 8 bit vector to 16 bit lanes, zero extended */
+inline SimdVector SimdWidenLowU8(SimdVector a) { return _mm256_cvtepu8_epi16(_mm256_castsi256_si128(a)); };
+/** Widens the upper half of an 8 bit vector to 16 bit lanes, zero extended */
+inline SimdVector SimdWidenHighU8(SimdVector a) { return _mm256_cvtepu8_epi16(_mm256_extracti128_si256(a, 1)); };
+/** Widens the lower half of an 8 bit mask to a 16 bit mask */
+inline SimdVector SimdWidenLowMask(SimdVector mask) { return _mm256_cvtepi8_epi16(_mm256_castsi256_si128(mask)); };
+/** Widens the upper half of an 8 bit mask to a 16 bit mask */
+inline SimdVector SimdWidenHighMask(SimdVector mask) { return _mm256_cvtepi8_epi16(_mm256_extracti128_si256(mask, 1)); };
+/** Narrows two 16 bit masks back to one 8 bit mask */
+inline SimdVector SimdNarrowMask(SimdVector low, SimdVector high) { return _mm256_permute4x64_epi64(_mm256_packs_epi16(low, high), 0xD8); };
+
+#elif CHIP8_SIMD_SSE2
+
+inline SimdVector SimdLoad(const void* pSource) { return _mm_loadu_si128(static_cast<const __m128i*>(pSource)); };
+inline void SimdStore(void* pDestination, SimdVector value) { _mm_storeu_si128(static_cast<__m128i*>(pDestination), value); };
+inline SimdVector SimdZero() { return _mm_setzero_si128(); };
+inline SimdVector SimdSetU8(uint8_t value) { return _mm_set1_epi8(static_cast<char>(value)); };
+inline SimdVector SimdSetU16(uint16_t value) { return _mm_set1_epi16(static_cast<short>(value)); };
+inline SimdVector SimdSetU32(uint32_t value) { return _mm_set1_epi32(static_cast<int>(value)); };
+inline SimdVector SimdAnd(SimdVector a, SimdVector b) { return _mm_and_si128(a, b); };
+inline SimdVector SimdOr(SimdVector a, SimdVector b) { return _mm_or_si128(a, b); };
+inline SimdVector SimdXor(SimdVector a, SimdVector b) { return _mm_xor_si128(a, b); };
+inline SimdVector SimdAndNot(SimdVector mask, SimdVector value) { return _mm_andnot_si128(mask, value); };
+inline SimdVector SimdAddU8(SimdVector a, SimdVector b) { return _mm_add_epi8(a, b); };
+inline SimdVector SimdSubU8(SimdVector a, SimdVector b) { return _mm_sub_epi8(a, b); };
+inline SimdVector SimdSubSaturateU8(SimdVector a, SimdVector b) { return _mm_subs_epu8(a, b); };
+inline SimdVector SimdMaxU8(SimdVector a, SimdVector b) { return _mm_max_epu8(a, b); };
+inline SimdVector SimdEqualU8(SimdVector a, SimdVector b) { return _mm_cmpeq_epi8(a, b); };
+inline SimdVector SimdAddU16(SimdVector a, SimdVector b) { return _mm_add_epi16(a, b); };
+inline SimdVector SimdEqualU16(SimdVector a, SimdVector b) { return _mm_cmpeq_epi16(a, b); };
+inline SimdVector SimdEqualU32(SimdVector a, SimdVector b) { return _mm_cmpeq_epi32(a, b); };
+inline SimdVector SimdShiftRightU16(SimdVector a, int bits) { return _mm_srli_epi16(a, bits); };
+inline SimdVector SimdBlend(SimdVector mask, SimdVector a, SimdVector b) { return _mm_or_si128(_mm_and_si128(mask, b), _mm_andnot_si128(mask, a)); };
+inline uint32_t SimdMoveMask(SimdVector mask) { return static_cast<uint32_t>(_mm_movemask_epi8(mask)); };
+inline SimdVector SimdWidenLowU8(SimdVector a) { return _mm_unpacklo_epi8(a, _mm_setzero_si128()); };
+inline SimdVector SimdWidenHighU8(SimdVector a) { return _mm_unpackhi_epi8(a, _mm_setzero_si128()); };
+inline SimdVector SimdWidenLowMask(SimdVector mask) { return _mm_unpacklo_epi8(mask, mask); };
+inline SimdVector SimdWidenHighMask(SimdVector mask) { return _mm_unpackhi_epi8(mask, mask); };
+inline SimdVector SimdNarrowMask(SimdVector low, SimdVector high) { return _mm_packs_epi16(low, high); };
+
+#else
+
+inline SimdVector SimdLoad(const void* pSource) { SimdVector v; std::memcpy(v.bytes, pSource, sizeof(v.bytes)); return v; };
+inline void SimdStore(void* pDestination, SimdVector value) { std::memcpy(pDestination, value.bytes, sizeof(value.bytes)); };
+
+/** Applies a byte wise operation to every lane */
+template <typename Function>
+inline SimdVector SimdMapU8(SimdVector a, SimdVector b, Function function)
+{
+	SimdVector result;
+	for (uint32_t i = 0; i < sizeof(result.bytes); i++)
+	{
+		result.bytes[i] = static_cast<uint8_t>(function(a.bytes[i], b.bytes[i]));
+	};
+	return result;
+};
+
+/** Applies a 16 bit wise operation to every lane */
+template <typename Function>
+inline SimdVector SimdMapU16(SimdVector a, SimdVector b, Function function)
+{
+	uint16_t wordsA[8], wordsB[8];
+	std::memcpy(wordsA, a.bytes, sizeof(wordsA));
+	std::memcpy(wordsB, b.bytes, sizeof(wordsB));
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		wordsA[i] = static_cast<uint16_t>(function(wordsA[i], wordsB[i]));
+	};
+	SimdVector result;
+	std::memcpy(result.bytes, wordsA, sizeof(wordsA));
+	return result;
+};
+
+inline SimdVector SimdSetU8(uint8_t value) { SimdVector v; std::memset(v.bytes, value, sizeof(v.bytes)); return v; };
+inline SimdVector SimdZero() { return SimdSetU8(0x00); };
+inline SimdVector SimdSetU16(uint16_t value) { uint16_t words[8]; for (uint16_t& word : words) { word = value; }; return SimdLoad(words); };
+inline SimdVector SimdSetU32(uint32_t value) { uint32_t words[4]; for (uint32_t& word : words) { word = value; }; return SimdLoad(words); };
+inline SimdVector SimdAnd(SimdVector a, SimdVector b) { return SimdMapU8(a, b, [](uint8_t x, uint8_t y) { return x & y; }); };
+inline SimdVector SimdOr(SimdVector a, SimdVector b) { return SimdMapU8(a, b, [](uint8_t x, uint8_t y) { return x | y; }); };
+inline SimdVector SimdXor(SimdVector a, SimdVector b) { return SimdMapU8(a, b, [](uint8_t x, uint8_t y) { return x ^ y; }); };
+inline SimdVector SimdAndNot(SimdVector mask, SimdVector value) { return SimdMapU8(mask, value, [](uint8_t x, uint8_t y) { return ~x & y; }); };
+inline SimdVector SimdAddU8(SimdVector a, SimdVector b) { return SimdMapU8(a, b, [](uint8_t x, uint8_t y) { return x + y; }); };
+inline SimdVector SimdSubU8(SimdVector a, SimdVector b) { return SimdMapU8(a, b, [](uint8_t x, uint8_t y) { return x - y; }); };
+inline SimdVector SimdSubSaturateU8(SimdVector a, SimdVector b) { return SimdMapU8(a, b, [](uint8_t x, uint8_t y) { return x > y ? x - y : 0; }); };
+inline SimdVector SimdMaxU8(SimdVector a, SimdVector b) { return SimdMapU8(a, b, [](uint8_t x, uint8_t y) { return x > y ? x : y; }); };
+inline SimdVector SimdEqualU8(SimdVector a, SimdVector b) { return SimdMapU8(a, b, [](uint8_t x, uint8_t y) { return x == y ? 0xFF : 0x00; }); };
+inline SimdVector SimdAddU16(SimdVector a, SimdVector b) { return SimdMapU16(a, b, [](uint16_t x, uint16_t y) { return x + y; }); };
+inline SimdVector SimdEqualU16(SimdVector a, SimdVector b) { return SimdMapU16(a, b, [](uint16_t x, uint16_t y) { return x == y ? 0xFFFF : 0x0000; }); };
+
+inline SimdVector SimdEqualU32(SimdVector a, SimdVector b)
+{
+	uint32_t wordsA[4], wordsB[4];
+	std::memcpy(wordsA, a.bytes, sizeof(wordsA));
+	std::memcpy(wordsB, b.bytes, sizeof(wordsB));
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		wordsA[i] = wordsA[i] == wordsB[i] ? 0xFFFFFFFF : 0x00000000;
+	};
+	return SimdLoad(wordsA);
+};
+inline SimdVector SimdShiftRightU16(SimdVector a, int bits) { return SimdMapU16(a, a, [bits](uint16_t x, uint16_t) { return x >> bits; }); };
+inline SimdVector SimdBlend(SimdVector mask, SimdVector a, SimdVector b) { return SimdOr(SimdAnd(mask, b), SimdAndNot(mask, a)); };
+
+inline uint32_t SimdMoveMask(SimdVector mask)
+{
+	uint32_t bits = 0;
+	for (uint32_t i = 0; i < sizeof(mask.bytes); i++)
+	{
+		bits |= (mask.bytes[i] >> 7) << i;
+	};
+	return bits;
+};
+
+inline SimdVector SimdWidenLowU8(SimdVector a) { uint16_t words[8]; for (uint32_t i = 0; i < 8; i++) { words[i] = a.bytes[i]; }; return SimdLoad(words); };
+inline SimdVector SimdWidenHighU8(SimdVector a) { uint16_t words[8]; for (uint32_t i = 0; i < 8; i++) { words[i] = a.bytes[i + 8]; }; return SimdLoad(words); };
+inline SimdVector SimdWidenLowMask(SimdVector mask) { uint16_t words[8]; for (uint32_t i = 0; i < 8; i++) { words[i] = mask.bytes[i] ? 0xFFFF : 0x0000; }; return SimdLoad(words); };
+inline SimdVector SimdWidenHighMask(SimdVector mask) { uint16_t words[8]; for (uint32_t i = 0; i < 8; i++) { words[i] = mask.bytes[i + 8] ? 0xFFFF : 0x0000; }; return SimdLoad(words); };
+
+inline SimdVector SimdNarrowMask(SimdVector low, SimdVector high)
+{
+	SimdVector result;
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		result.bytes[i] = low.bytes[i * 2] ? 0xFF : 0x00;
+		result.bytes[i + 8] = high.bytes[i * 2] ? 0xFF : 0x00;
+	};
+	return result;
+};
+
+#endif
+
+/**
+	Index of the lowest set bit, bits must not be zero.
+ */
+inline uint32_t CountTrailingZeros(uint32_t bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return static_cast<uint32_t>(__builtin_ctz(bits));
+#else
+	uint32_t index = 0;
+	while ((bits & 1) == 0)
+	{
+		bits >>= 1;
+		index++;
+	};
+	return index;
+#endif
+};
+
+#endif // SIMD_HPP_INCLUDED
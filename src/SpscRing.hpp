@@ -0,0 +1,107 @@
+#ifndef SPSCRING_HPP_INCLUDED
+#define SPSCRING_HPP_INCLUDED
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/** Assumed cache line size, used to keep the two indices from sharing a line */
+constexpr size_t g_cacheLineSize = 64;
+
+/**
+	Fixed size lock free queue for exactly one producer and one consumer thread.\n
+	Neither side ever blocks or allocates: TryPush() fails when the ring is
+	full and TryPop() fails when it is empty. Each index is only written by
+	its own side, so a push or pop is one relaxed load, one acquire load
+	and one release store.
+
+	@tparam T Trivially copyable element.
+	@tparam Capacity Number of slots, a power of two.
+ */
+template <typename T, size_t Capacity>
+class SpscRing
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+	public:
+
+		SpscRing() : m_head(0), m_tail(0) {};
+
+		/**
+			Appends an element, producer thread only.
+
+			@return false if the ring is full, the element is dropped.
+		 */
+		bool TryPush(const T& value)
+		{
+			size_t head = m_head.load(std::memory_order_relaxed);
+			if (head - m_tail.load(std::memory_order_acquire) == Capacity)
+			{
+				return false;
+			};
+
+			m_slots[head & (Capacity - 1)] = value;
+			m_head.store(head + 1, std::memory_order_release);
+			return true;
+		};
+
+		/**
+			Takes the oldest element, consumer thread only.
+
+			@return false if the ring is empty.
+		 */
+		bool TryPop(T& value)
+		{
+			size_t tail = m_tail.load(std::memory_order_relaxed);
+			if (m_head.load(std::memory_order_acquire) == tail)
+			{
+				return false;
+			};
+
+			value = m_slots[tail & (Capacity - 1)];
+			m_tail.store(tail + 1, std::memory_order_release);
+			return true;
+		};
+
+		/**
+			Looks at the oldest element without taking it, consumer thread only.
+
+			@return Null if the ring is empty.
+		 */
+		const T* Peek() const
+		{
+			size_t tail = m_tail.load(std::memory_order_relaxed);
+			if (m_head.load(std::memory_order_acquire) == tail)
+			{
+				return nullptr;
+			};
+			return &m_slots[tail & (Capacity - 1)];
+		};
+
+		/**
+			Retrieve the number of queued elements, only a snapshot when called from the other side.
+		 */
+		size_t GetSize() const
+		{
+			return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+		};
+
+	private:
+
+		// Padded rather than aligned, C++14 new does not honour over-alignment.
+
+		/** Next slot to write, only written by the producer */
+		std::atomic<size_t> m_head;
+		/** Keeps m_head and m_tail on separate cache lines */
+		char m_headPadding[g_cacheLineSize];
+		/** Next slot to read, only written by the consumer */
+		std::atomic<size_t> m_tail;
+		/** Keeps m_tail and the slots on separate cache lines */
+		char m_tailPadding[g_cacheLineSize];
+		/** Elements */
+		std::array<T, Capacity> m_slots;
+
+}; // SpscRing
+
+#endif // SPSCRING_HPP_INCLUDED
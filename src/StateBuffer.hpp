@@ -0,0 +1,146 @@
+#ifndef STATEBUFFER_HPP_INCLUDED
+#define STATEBUFFER_HPP_INCLUDED
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+	Appends little endian values to a caller provided buffer.\n
+	Writes past the end are dropped and remembered, check IsValid() once at the end.
+ */
+class StateWriter
+{
+	public:
+
+		StateWriter(uint8_t* pBuffer, size_t size) : m_pBuffer(pBuffer), m_size(size), m_offset(0), m_isValid(true) {};
+
+		void WriteBytes(const void* pData, size_t size)
+		{
+			if (!Reserve(size))
+			{
+				return;
+			};
+			std::memcpy(m_pBuffer + m_offset, pData, size);
+			m_offset += size;
+		};
+
+		void WriteU8(uint8_t value) { WriteBytes(&value, 1); };
+		void WriteU16(uint16_t value) { WriteLittleEndian(value, 2); };
+		void WriteU32(uint32_t value) { WriteLittleEndian(value, 4); };
+		void WriteU64(uint64_t value) { WriteLittleEndian(value, 8); };
+
+		size_t GetOffset() const { return m_offset; };
+		bool IsValid() const { return m_isValid; };
+
+	private:
+
+		bool Reserve(size_t size)
+		{
+			m_isValid = m_isValid && m_size - m_offset >= size;
+			return m_isValid;
+		};
+
+		void WriteLittleEndian(uint64_t value, size_t size)
+		{
+			if (!Reserve(size))
+			{
+				return;
+			};
+			for (size_t i = 0; i < size; i++)
+			{
+				m_pBuffer[m_offset++] = static_cast<uint8_t>(value >> (i * 8));
+			};
+		};
+
+	private:
+
+		/** Destination buffer */
+		uint8_t* m_pBuffer;
+		/** Size of the destination buffer */
+		size_t m_size;
+		/** Bytes written so far */
+		size_t m_offset;
+		/** Cleared when a write did not fit */
+		bool m_isValid;
+
+}; // StateWriter
+
+/**
+	Reads little endian values written by StateWriter.\n
+	Reads past the end return zero and are remembered, check IsValid() once at the end.
+ */
+class StateReader
+{
+	public:
+
+		StateReader(const uint8_t* pBuffer, size_t size) : m_pBuffer(pBuffer), m_size(size), m_offset(0), m_isValid(true) {};
+
+		void ReadBytes(void* pData, size_t size)
+		{
+			if (!Reserve(size))
+			{
+				std::memset(pData, 0, size);
+				return;
+			};
+			std::memcpy(pData, m_pBuffer + m_offset, size);
+			m_offset += size;
+		};
+
+		/** Returns the next size bytes in place, null if they run past the end */
+		const uint8_t* ReadSpan(size_t size)
+		{
+			if (!Reserve(size))
+			{
+				return nullptr;
+			};
+			const uint8_t* pData = m_pBuffer + m_offset;
+			m_offset += size;
+			return pData;
+		};
+
+		uint8_t ReadU8() { uint8_t value; ReadBytes(&value, 1); return value; };
+		uint16_t ReadU16() { return static_cast<uint16_t>(ReadLittleEndian(2)); };
+		uint32_t ReadU32() { return static_cast<uint32_t>(ReadLittleEndian(4)); };
+		uint64_t ReadU64() { return ReadLittleEndian(8); };
+
+		size_t GetOffset() const { return m_offset; };
+		bool IsValid() const { return m_isValid; };
+
+	private:
+
+		bool Reserve(size_t size)
+		{
+			m_isValid = m_isValid && m_size - m_offset >= size;
+			return m_isValid;
+		};
+
+		uint64_t ReadLittleEndian(size_t size)
+		{
+			if (!Reserve(size))
+			{
+				return 0;
+			};
+			uint64_t value = 0;
+			for (size_t i = 0; i < size; i++)
+			{
+				value |= static_cast<uint64_t>(m_pBuffer[m_offset++]) << (i * 8);
+			};
+			return value;
+		};
+
+	private:
+
+		/** Source buffer */
+		const uint8_t* m_pBuffer;
+		/** Size of the source buffer */
+		size_t m_size;
+		/** Bytes read so far */
+		size_t m_offset;
+		/** Cleared when a read ran past the end */
+		bool m_isValid;
+
+}; // StateReader
+
+#endif // STATEBUFFER_HPP_INCLUDED
@@ -0,0 +1,102 @@
+#ifndef TRIPLEBUFFER_HPP_INCLUDED
+#define TRIPLEBUFFER_HPP_INCLUDED
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include "SpscRing.hpp"
+
+/** Set in the middle slot index while it holds a value the consumer did not take yet */
+constexpr uint8_t g_tripleBufferFreshBit = 0x04;
+/** Slot index part of the middle slot index */
+constexpr uint8_t g_tripleBufferIndexMask = 0x03;
+
+/**
+	Lock free hand off of the latest value from one producer to one consumer thread.\n
+	The producer fills its back slot and publishes it by swapping it with the
+	middle slot, the consumer takes the middle slot by swapping it with its
+	front slot. Each side owns one slot at all times, so neither ever waits
+	or copies while the other is busy. A value the consumer did not take
+	before the next Publish() is replaced, only the latest one matters.
+
+	@tparam T Element, copied in to and read from the slots in place.
+ */
+template <typename T>
+class TripleBuffer
+{
+	public:
+
+		TripleBuffer() : m_middle(1), m_back(0), m_front(2) {};
+
+		/**
+			Retrieve the slot to fill, producer thread only.
+		 */
+		T& GetBackBuffer()
+		{
+			return m_slots[m_back];
+		};
+
+		/**
+			Makes the back slot the latest value, producer thread only.
+		 */
+		void Publish()
+		{
+			m_back = m_middle.exchange(m_back | g_tripleBufferFreshBit, std::memory_order_acq_rel) & g_tripleBufferIndexMask;
+		};
+
+		/**
+			Checks if the consumer did not take the last published value yet, producer thread only.\n
+			The consumer may take it right after, true only means it was still there.
+		 */
+		bool IsPending() const
+		{
+			return (m_middle.load(std::memory_order_relaxed) & g_tripleBufferFreshBit) != 0;
+		};
+
+		/**
+			Takes the latest value if one was published since the last call, consumer thread only.
+
+			@return false if nothing new was published, the front slot is unchanged.
+		 */
+		bool Acquire()
+		{
+			if ((m_middle.load(std::memory_order_relaxed) & g_tripleBufferFreshBit) == 0)
+			{
+				return false;
+			};
+
+			m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & g_tripleBufferIndexMask;
+			return true;
+		};
+
+		/**
+			Retrieve the value taken by the last Acquire(), consumer thread only.
+		 */
+		const T& GetFrontBuffer() const
+		{
+			return m_slots[m_front];
+		};
+
+	private:
+
+		// Padded rather than aligned, C++14 new does not honour over-alignment.
+
+		/** Slot shared between the two sides, with g_tripleBufferFreshBit */
+		std::atomic<uint8_t> m_middle;
+		/** Keeps m_middle and the sides on separate cache lines */
+		char m_middlePadding[g_cacheLineSize];
+		/** Slot owned by the producer */
+		uint8_t m_back;
+		/** Keeps the two sides on separate cache lines */
+		char m_backPadding[g_cacheLineSize];
+		/** Slot owned by the consumer */
+		uint8_t m_front;
+		/** Keeps m_front and the slots on separate cache lines */
+		char m_frontPadding[g_cacheLineSize];
+		/** Values */
+		std::array<T, 3> m_slots;
+
+}; // TripleBuffer
+
+#endif // TRIPLEBUFFER_HPP_INCLUDED
@@ -0,0 +1,263 @@
+/*! \file
+		Entry point for the static ROM analyzer.
+
+		Decodes a ROM without running it and prints its basic blocks, call
+		graph, data regions and the stores that may modify code, ending with
+		whether the ROM is safe for engines that assume code never changes.
+		The control flow graph can also be written as a Graphviz file.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include "Instruction.hpp"
+#include "Quirks.hpp"
+#include "RomAnalyzer.hpp"
+#include "RomCache.hpp"
+
+/**
+	Retrieve a short name for how control leaves a block.
+ */
+const char* GetBlockExitName(BlockExit exit);
+
+/**
+	Prints the analysis as text.
+
+	@param[in] analysis The analysis.
+	@param[in] romHash Content hash of the ROM.
+	@param[in] quirks Quirk profile the ROM was analyzed with.
+ */
+void PrintAnalysis(const RomAnalysis& analysis, uint64_t romHash, QuirkProfile quirks);
+
+/**
+	Writes the control flow graph as a Graphviz dot file.
+
+	@param[in] analysis The analysis.
+	@param[in] pDotPath Path of the file to write.
+	@return false if the file could not be written.
+ */
+bool WriteDotFile(const RomAnalysis& analysis, const char* pDotPath);
+
+/**
+	Prints how to use the analyzer.
+
+	@param[in] pProgramName Name of the executable.
+ */
+void PrintUsage(const char* pProgramName);
+
+/**
+	Entrypoint for program.
+ */
+int main(int argc, char** argv)
+{
+	const char* pRomPath = nullptr;
+	const char* pDotPath = nullptr;
+	Platform platform = Platform::Chip8;
+	QuirkProfile quirks = QuirkProfile::Default;
+	const QuirkProfile* pQuirks = nullptr;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--platform") == 0 && i + 1 < argc)
+		{
+			if (!FindPlatform(argv[++i], platform))
+			{
+				PrintUsage(argv[0]);
+				return -1;
+			};
+		}
+		else if (std::strcmp(argv[i], "--quirks") == 0 && i + 1 < argc)
+		{
+			if (!FindQuirkProfile(argv[++i], quirks))
+			{
+				PrintUsage(argv[0]);
+				return -1;
+			};
+			pQuirks = &quirks;
+		}
+		else if (std::strcmp(argv[i], "--quirks-db") == 0 && i + 1 < argc)
+		{
+			if (!QuirkDatabase::GetInstance().Load(argv[++i]))
+			{
+				printf("Failed to read quirk database %s\n", argv[i]);
+				return -1;
+			};
+		}
+		else if (std::strcmp(argv[i], "--dot") == 0 && i + 1 < argc)
+		{
+			pDotPath = argv[++i];
+		}
+		else if (argv[i][0] != '-' && pRomPath == nullptr)
+		{
+			pRomPath = argv[i];
+		}
+		else
+		{
+			PrintUsage(argv[0]);
+			return -1;
+		};
+	};
+
+	if (pRomPath == nullptr)
+	{
+		PrintUsage(argv[0]);
+		return -1;
+	};
+
+	RomStatus status;
+	std::shared_ptr<const Rom> pRom = RomCache::GetInstance().Load(pRomPath, platform == Platform::XoChip ? g_xoRomMaxSize : g_chipRomMaxSize, status);
+	if (!pRom)
+	{
+		printf("Failed to read %s\n", pRomPath);
+		return -1;
+	};
+
+	if (pQuirks == nullptr)
+	{
+		quirks = QuirkDatabase::GetInstance().Find(pRom->hash, platform);
+	};
+
+	RomAnalyzer analyzer(platform, quirks);
+	RomAnalysis analysis = analyzer.Analyze(pRom->data.data(), pRom->data.size());
+	PrintAnalysis(analysis, pRom->hash, quirks);
+
+	if (pDotPath != nullptr && !WriteDotFile(analysis, pDotPath))
+	{
+		printf("Failed to write %s\n", pDotPath);
+		return -1;
+	};
+
+	return 0;
+};
+
+const char* GetBlockExitName(BlockExit exit)
+{
+	switch (exit)
+	{
+		case BlockExit::Fallthrough: return "fallthrough";
+		case BlockExit::Jump: return "jump";
+		case BlockExit::Call: return "call";
+		case BlockExit::Return: return "return";
+		case BlockExit::Skip: return "skip";
+		case BlockExit::Computed: return "computed";
+		case BlockExit::Wait: return "wait";
+		case BlockExit::Halt: return "halt";
+		default: return "unknown";
+	};
+};
+
+void PrintAnalysis(const RomAnalysis& analysis, uint64_t romHash, QuirkProfile quirks)
+{
+	size_t instructionCount = analysis.instructions.count();
+	size_t dataSize = 0;
+	for (const MemoryRegion& region : analysis.dataRegions)
+	{
+		dataSize += region.last - region.first + 1;
+	};
+
+	printf("ROM hash %016llx, quirks %s\n", static_cast<unsigned long long>(romHash), GetQuirkProfileName(quirks));
+	printf("%zu instructions in %zu blocks, %zu subroutines, %zu data bytes, %u unknown opcodes\n",
+		instructionCount,
+		analysis.blocks.size(),
+		analysis.subroutines.size() - 1,
+		dataSize,
+		analysis.unknownOpcodes);
+
+	printf("\nBlocks\n");
+	for (const BasicBlock& block : analysis.blocks)
+	{
+		printf("  %03x-%03x %3u instructions %-11s",
+			block.start,
+			(block.start + block.size - 1) & g_chipAddressMask,
+			block.instructionCount,
+			GetBlockExitName(block.exit));
+		if (block.exit == BlockExit::Call)
+		{
+			printf(" %03x", block.callee);
+		};
+		if (!block.successors.empty())
+		{
+			printf(" ->");
+			for (uint16_t successor : block.successors)
+			{
+				printf(" %03x", successor);
+			};
+		};
+		printf("\n");
+	};
+
+	printf("\nSubroutines\n");
+	for (const Subroutine& subroutine : analysis.subroutines)
+	{
+		printf("  %03x%s %zu blocks", subroutine.entry, subroutine.entry == analysis.entry ? " (main)" : "", subroutine.blocks.size());
+		if (!subroutine.callees.empty())
+		{
+			printf(", calls");
+			for (uint16_t callee : subroutine.callees)
+			{
+				printf(" %03x", callee);
+			};
+		};
+		printf("\n");
+	};
+
+	printf("\nData regions\n");
+	for (const MemoryRegion& region : analysis.dataRegions)
+	{
+		printf("  %03x-%03x %u bytes\n", region.first, region.last, region.last - region.first + 1);
+	};
+
+	printf("\nComputed jumps\n");
+	for (uint16_t address : analysis.computedJumps)
+	{
+		printf("  %03x\n", address);
+	};
+
+	printf("\nSelf modifying code candidates\n");
+	for (const WriteCandidate& candidate : analysis.selfModifyingCode)
+	{
+		if (candidate.isResolved)
+		{
+			printf("  %03x writes %03x-%03x\n", candidate.writer, candidate.target.first, candidate.target.last);
+		}
+		else
+		{
+			printf("  %03x writes anywhere\n", candidate.writer);
+		};
+	};
+
+	printf("\n%s\n", analysis.IsStatic() ? "Static code, safe for fast paths" : "Code may change or is only partly known, not safe for fast paths");
+};
+
+bool WriteDotFile(const RomAnalysis& analysis, const char* pDotPath)
+{
+	FILE* pFile = std::fopen(pDotPath, "w");
+	if (pFile == nullptr)
+	{
+		return false;
+	};
+
+	fprintf(pFile, "digraph rom {\n\tnode [shape=box fontname=monospace];\n");
+	for (const BasicBlock& block : analysis.blocks)
+	{
+		fprintf(pFile, "\tb%03x [label=\"%03x %s\"];\n", block.start, block.start, GetBlockExitName(block.exit));
+		for (uint16_t successor : block.successors)
+		{
+			fprintf(pFile, "\tb%03x -> b%03x;\n", block.start, successor);
+		};
+		if (block.exit == BlockExit::Call)
+		{
+			fprintf(pFile, "\tb%03x -> b%03x [style=dashed];\n", block.start, block.callee);
+		};
+	};
+	fprintf(pFile, "}\n");
+
+	return std::fclose(pFile) == 0;
+};
+
+void PrintUsage(const char* pProgramName)
+{
+	printf("Usage: %s <path-to-rom> [--platform chip8|schip|xochip]\n"
+		"       [--quirks default|vip|schip|xochip] [--quirks-db FILE] [--dot FILE]\n", pProgramName);
+};
@@ -0,0 +1,589 @@
+/*! \file
+		Entry point for the ahead of time ROM translator.
+
+		Translates a ROM in to a C++ source file with one function per basic
+		block and a dispatcher finding the block for any address, which also
+		serves the computed jumps of Bnnn. Simple instructions become plain
+		C++ on the interpreter's registers, everything else calls back in to
+		the interpreter. Compiled in to an executable the program registers
+		itself with the AotRegistry and runs on Backend::Aot, see
+		chip8_add_aot_rom() in src/CMakeLists.txt.
+ */
+
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "Instruction.hpp"
+#include "Interpreter.hpp"
+#include "Quirks.hpp"
+#include "RomAnalyzer.hpp"
+#include "RomCache.hpp"
+
+/**
+	Address ROMs are loaded at, translated code never starts below it.
+ */
+constexpr uint16_t g_aotProgramStart = 0x0200;
+
+/**
+	Everything needed to write the generated file.
+ */
+struct AotSource
+{
+	/** Name of the program, a C identifier */
+	const char* pName;
+	/** Content hash of the ROM */
+	uint64_t romHash;
+	/** Instruction set to translate for */
+	Platform platform;
+	/** Quirk profile to translate for */
+	QuirkProfile quirks;
+	/** Memory after loading the ROM */
+	std::vector<uint8_t> memory;
+	/** Blocks that are translated */
+	std::vector<BasicBlock> blocks;
+	/** Bytes covered by translated blocks */
+	std::bitset<g_chipRamSize> code;
+};
+
+/**
+	Writes the translation of a ROM.
+
+	@param[in] source The ROM and the blocks to translate.
+	@param[in] pRomPath Path of the ROM, mentioned in the header comment.
+	@param[in] pOutputPath Path of the file to write.
+	@return false if the file could not be written.
+ */
+bool WriteSource(const AotSource& source, const char* pRomPath, const char* pOutputPath);
+
+/**
+	Writes the function for one basic block.
+ */
+void WriteBlock(FILE* pFile, const AotSource& source, const BasicBlock& block);
+
+/**
+	Writes the C++ for a single instruction of a block.
+
+	@param[in] address Address of the instruction.
+	@param[in] instruction The decoded instruction.
+	@param[in] blockInstructions Bit a is set if the block has an instruction at address a.
+	@return true if control can run on in to the next instruction, false after a jump, skip or return.
+ */
+bool WriteInstruction(FILE* pFile, const AotSource& source, uint16_t address, const Instruction& instruction, const std::bitset<g_chipRamSize>& blockInstructions);
+
+/**
+	Writes a transfer to a known address, a goto if it stays inside the block.
+ */
+void WriteExit(FILE* pFile, uint32_t target, const std::bitset<g_chipRamSize>& blockInstructions, const char* pIndent);
+
+/**
+	Decodes the instruction at an address of the loaded ROM.
+ */
+Instruction DecodeAt(const AotSource& source, uint16_t address);
+
+/**
+	Retrieve whether an instruction is translated to C++ instead of calling the interpreter.
+ */
+bool IsNative(const AotSource& source, uint16_t address, const Instruction& instruction);
+
+/**
+	Prints how to use the translator.
+
+	@param[in] pProgramName Name of the executable.
+ */
+void PrintUsage(const char* pProgramName);
+
+/**
+	Entrypoint for program.
+ */
+int main(int argc, char** argv)
+{
+	const char* pRomPath = nullptr;
+	const char* pOutputPath = nullptr;
+	const char* pName = nullptr;
+	Platform platform = Platform::Chip8;
+	QuirkProfile quirks = QuirkProfile::Default;
+	const QuirkProfile* pQuirks = nullptr;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+		{
+			pOutputPath = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--name") == 0 && i + 1 < argc)
+		{
+			pName = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--platform") == 0 && i + 1 < argc)
+		{
+			if (!FindPlatform(argv[++i], platform))
+			{
+				PrintUsage(argv[0]);
+				return -1;
+			};
+		}
+		else if (std::strcmp(argv[i], "--quirks") == 0 && i + 1 < argc)
+		{
+			if (!FindQuirkProfile(argv[++i], quirks))
+			{
+				PrintUsage(argv[0]);
+				return -1;
+			};
+			pQuirks = &quirks;
+		}
+		else if (std::strcmp(argv[i], "--quirks-db") == 0 && i + 1 < argc)
+		{
+			if (!QuirkDatabase::GetInstance().Load(argv[++i]))
+			{
+				printf("Failed to read quirk database %s\n", argv[i]);
+				return -1;
+			};
+		}
+		else if (argv[i][0] != '-' && pRomPath == nullptr)
+		{
+			pRomPath = argv[i];
+		}
+		else
+		{
+			PrintUsage(argv[0]);
+			return -1;
+		};
+	};
+
+	if (pRomPath == nullptr || pOutputPath == nullptr || pName == nullptr)
+	{
+		PrintUsage(argv[0]);
+		return -1;
+	};
+
+	// The name ends up in a string literal, keep it a plain identifier.
+	for (const char* pChar = pName; *pChar != '\0'; pChar++)
+	{
+		if (!std::isalnum(static_cast<unsigned char>(*pChar)) && *pChar != '_')
+		{
+			printf("--name must only contain letters, digits and underscores\n");
+			return -1;
+		};
+	};
+
+	RomStatus status;
+	std::shared_ptr<const Rom> pRom = RomCache::GetInstance().Load(pRomPath, platform == Platform::XoChip ? g_xoRomMaxSize : g_chipRomMaxSize, status);
+	if (!pRom)
+	{
+		printf("Failed to read %s\n", pRomPath);
+		return -1;
+	};
+
+	AotSource source;
+	source.pName = pName;
+	source.romHash = pRom->hash;
+	source.platform = platform;
+	source.quirks = pQuirks != nullptr ? quirks : QuirkDatabase::GetInstance().Find(pRom->hash, platform);
+
+	// Code only runs from the first 4K, data past it never needs translating.
+	source.memory.assign(g_chipRamSize, 0x00);
+	size_t codeSize = std::min<size_t>(pRom->data.size(), g_chipRomMaxSize);
+	std::copy(pRom->data.begin(), pRom->data.begin() + codeSize, source.memory.begin() + g_aotProgramStart);
+
+	RomAnalyzer analyzer(source.platform, source.quirks);
+	RomAnalysis analysis = analyzer.Analyze(pRom->data.data(), pRom->data.size());
+	for (const BasicBlock& block : analysis.blocks)
+	{
+		// Blocks in the interpreter area or wrapping around the end of memory are left to the interpreter.
+		if (block.start < g_aotProgramStart || block.start + block.size > g_chipRamSize)
+		{
+			continue;
+		};
+
+		source.blocks.push_back(block);
+		for (uint16_t i = 0; i < block.size; i++)
+		{
+			source.code.set(block.start + i);
+		};
+	};
+
+	if (source.blocks.empty())
+	{
+		printf("%s has no code to translate\n", pRomPath);
+		return -1;
+	};
+
+	if (!WriteSource(source, pRomPath, pOutputPath))
+	{
+		printf("Failed to write %s\n", pOutputPath);
+		return -1;
+	};
+
+	printf("Translated %zu blocks of %s, quirks %s%s\n",
+		source.blocks.size(),
+		pRomPath,
+		GetQuirkProfileName(source.quirks),
+		analysis.IsStatic() ? "" : ", code may change at run time");
+	return 0;
+};
+
+bool WriteSource(const AotSource& source, const char* pRomPath, const char* pOutputPath)
+{
+	static const char* const s_platforms[] = { "Platform::Chip8", "Platform::SuperChip", "Platform::XoChip" };
+	static const char* const s_quirks[] = { "QuirkProfile::Default", "QuirkProfile::Vip", "QuirkProfile::SuperChip", "QuirkProfile::XoChip" };
+
+	FILE* pFile = std::fopen(pOutputPath, "w");
+	if (pFile == nullptr)
+	{
+		return false;
+	};
+
+	fprintf(pFile, "// Generated by chip8-aot from %s, do not edit.\n\n", pRomPath);
+	fprintf(pFile, "#include \"AotEngine.hpp\"\n\nnamespace\n{\n");
+
+	for (const BasicBlock& block : source.blocks)
+	{
+		WriteBlock(pFile, source, block);
+	};
+
+	// Every instruction maps to its block, so blocks can be entered in the middle after running out of budget.
+	fprintf(pFile, "\tAotBlockFunction Dispatch(uint16_t address)\n\t{\n\t\tswitch (address)\n\t\t{\n");
+	for (const BasicBlock& block : source.blocks)
+	{
+		uint16_t address = block.start;
+		for (uint16_t i = 0; i < block.instructionCount; i++)
+		{
+			fprintf(pFile, "\t\t\tcase 0x%03x:\n", address);
+			address += DecodeAt(source, address).operation == Operation::OpF000 ? g_chipInstructionSize * 2 : g_chipInstructionSize;
+		};
+		fprintf(pFile, "\t\t\t\treturn &Block%03x;\n", block.start);
+	};
+	fprintf(pFile, "\t\t\tdefault:\n\t\t\t\treturn nullptr;\n\t\t};\n\t};\n\n");
+
+	uint32_t imageEnd = g_aotProgramStart;
+	for (uint32_t address = g_aotProgramStart; address < g_chipRamSize; address++)
+	{
+		imageEnd = source.code.test(address) ? address + 1 : imageEnd;
+	};
+
+	fprintf(pFile, "\tconst uint8_t g_image[] =\n\t{");
+	for (uint32_t address = g_aotProgramStart; address < imageEnd; address++)
+	{
+		fprintf(pFile, "%s0x%02x,", (address - g_aotProgramStart) % 16 == 0 ? "\n\t\t" : " ", source.memory[address]);
+	};
+	fprintf(pFile, "\n\t};\n\n");
+
+	size_t regionCount = 0;
+	fprintf(pFile, "\tconst MemoryRegion g_code[] =\n\t{\n");
+	for (uint32_t address = g_aotProgramStart; address < g_chipRamSize; address++)
+	{
+		if (source.code.test(address) && !source.code.test(address - 1))
+		{
+			uint32_t last = address;
+			while (last + 1 < g_chipRamSize && source.code.test(last + 1))
+			{
+				last++;
+			};
+			fprintf(pFile, "\t\t{ 0x%03x, 0x%03x },\n", address, last);
+			regionCount++;
+		};
+	};
+	fprintf(pFile, "\t};\n\n");
+
+	fprintf(pFile, "\tconst AotProgram g_program =\n\t{\n");
+	fprintf(pFile, "\t\t\"%s\",\n", source.pName);
+	fprintf(pFile, "\t\t0x%016llxULL,\n", static_cast<unsigned long long>(source.romHash));
+	fprintf(pFile, "\t\t%s,\n", s_platforms[static_cast<size_t>(source.platform)]);
+	fprintf(pFile, "\t\t%s,\n", s_quirks[static_cast<size_t>(source.quirks)]);
+	fprintf(pFile, "\t\tg_image,\n\t\tsizeof(g_image),\n\t\tg_code,\n\t\t%zu,\n\t\t&Dispatch\n\t};\n\n", regionCount);
+	fprintf(pFile, "\tconst bool g_isRegistered = AotRegistry::GetInstance().Add(&g_program);\n}\n");
+
+	return std::fclose(pFile) == 0;
+};
+
+void WriteBlock(FILE* pFile, const AotSource& source, const BasicBlock& block)
+{
+	std::bitset<g_chipRamSize> blockInstructions;
+	std::vector<uint16_t> addresses;
+	bool usesRegisters = false;
+	bool usesIndex = false;
+
+	uint16_t address = block.start;
+	for (uint16_t i = 0; i < block.instructionCount; i++)
+	{
+		Instruction instruction = DecodeAt(source, address);
+		blockInstructions.set(address);
+		addresses.push_back(address);
+		if (IsNative(source, address, instruction))
+		{
+			bool isIndexOperation =
+				instruction.operation == Operation::OpAnnn ||
+				instruction.operation == Operation::OpFx1E ||
+				instruction.operation == Operation::OpFx29;
+			bool isSelfComparison =
+				(instruction.operation == Operation::Op5xy0 || instruction.operation == Operation::Op9xy0) && instruction.x == instruction.y;
+			usesIndex |= isIndexOperation;
+			usesRegisters |= instruction.operation != Operation::OpAnnn && instruction.operation != Operation::Op1nnn && instruction.operation != Operation::Unknown &&
+				!isSelfComparison;
+		};
+		address += instruction.operation == Operation::OpF000 ? g_chipInstructionSize * 2 : g_chipInstructionSize;
+	};
+
+	fprintf(pFile, "\tuint32_t Block%03x(AotEngine& engine, uint16_t address, uint32_t budget)\n\t{\n", block.start);
+	if (usesRegisters)
+	{
+		fprintf(pFile, "\t\tuint8_t* v = engine.GetRegisters();\n");
+	};
+	if (usesIndex)
+	{
+		fprintf(pFile, "\t\tuint16_t& i = engine.GetIndexRegister();\n");
+	};
+	fprintf(pFile, "\t\tuint32_t executed = 0;\n\n\t\tswitch (address)\n\t\t{\n");
+	for (uint16_t instructionAddress : addresses)
+	{
+		fprintf(pFile, "\t\t\tcase 0x%03x: goto i%03x;\n", instructionAddress, instructionAddress);
+	};
+	fprintf(pFile, "\t\t\tdefault: engine.ExecuteInstruction(address); return 1;\n\t\t};\n\n");
+
+	bool isFallingThrough = true;
+	for (uint16_t instructionAddress : addresses)
+	{
+		isFallingThrough = WriteInstruction(pFile, source, instructionAddress, DecodeAt(source, instructionAddress), blockInstructions);
+	};
+
+	// Control only reaches the end when the block runs in to the next one.
+	if (isFallingThrough)
+	{
+		uint16_t end = block.start + block.size;
+		WriteExit(pFile, end, blockInstructions, "");
+	};
+	fprintf(pFile, "\t};\n\n");
+};
+
+bool WriteInstruction(FILE* pFile, const AotSource& source, uint16_t address, const Instruction& instruction, const std::bitset<g_chipRamSize>& blockInstructions)
+{
+	const QuirkFlags quirks = GetQuirkFlags(source.quirks);
+	const unsigned x = instruction.x;
+	const unsigned y = instruction.y;
+	const unsigned kk = instruction.kk;
+	const unsigned nnn = instruction.nnn;
+	const uint16_t next = address + g_chipInstructionSize;
+
+	fprintf(pFile, "\ti%03x:\n", address);
+	fprintf(pFile, "\t\tif (executed == budget)\n\t\t{\n\t\t\tengine.SetProgramCounter(0x%03x);\n\t\t\treturn executed;\n\t\t};\n", address);
+	fprintf(pFile, "\t\texecuted++;\n");
+
+	if (!IsNative(source, address, instruction))
+	{
+		fprintf(pFile, "\t\tengine.ExecuteInstruction(0x%03x);\n", address);
+		bool isFallingThrough = true;
+		switch (instruction.operation)
+		{
+			case Operation::OpFx33:
+			case Operation::OpFx55:
+			case Operation::Op5xy2:
+				// The store may have hit translated code, which then no longer runs.
+				fprintf(pFile, "\t\tif (!engine.IsValid())\n\t\t{\n\t\t\treturn executed;\n\t\t};\n");
+				break;
+
+			case Operation::Op2nnn:
+			case Operation::Op00EE:
+			case Operation::Op00FD:
+			case Operation::OpFx0A:
+			case Operation::Op3xkk:
+			case Operation::Op4xkk:
+			case Operation::Op5xy0:
+			case Operation::Op9xy0:
+			case Operation::OpEx9E:
+			case Operation::OpExA1:
+				// The interpreter moved the program counter.
+				fprintf(pFile, "\t\treturn executed;\n");
+				isFallingThrough = false;
+				break;
+
+			default:
+				break;
+		};
+		fprintf(pFile, "\n");
+		return isFallingThrough;
+	};
+
+	const char* pCondition = nullptr;
+	char condition[64];
+	bool isFallingThrough = true;
+	switch (instruction.operation)
+	{
+		case Operation::Op1nnn:
+			WriteExit(pFile, nnn, blockInstructions, "");
+			isFallingThrough = false;
+			break;
+
+		case Operation::Op3xkk:
+		case Operation::Op4xkk:
+			std::snprintf(condition, sizeof(condition), "v[0x%X] %s 0x%02x", x, instruction.operation == Operation::Op3xkk ? "==" : "!=", kk);
+			pCondition = condition;
+			break;
+
+		case Operation::Op5xy0:
+		case Operation::Op9xy0:
+			if (x == y)
+			{
+				// Comparing a register with itself has a known outcome.
+				pCondition = instruction.operation == Operation::Op5xy0 ? "true" : "false";
+			}
+			else
+			{
+				std::snprintf(condition, sizeof(condition), "v[0x%X] %s v[0x%X]", x, instruction.operation == Operation::Op5xy0 ? "==" : "!=", y);
+				pCondition = condition;
+			};
+			break;
+
+		case Operation::Op6xkk:
+			fprintf(pFile, "\t\tv[0x%X] = 0x%02x;\n", x, kk);
+			break;
+
+		case Operation::Op7xkk:
+			fprintf(pFile, "\t\tv[0x%X] = static_cast<uint8_t>(v[0x%X] + 0x%02x);\n", x, x, kk);
+			break;
+
+		case Operation::Op8xy0:
+			fprintf(pFile, "\t\tv[0x%X] = v[0x%X];\n", x, y);
+			break;
+
+		case Operation::Op8xy1:
+		case Operation::Op8xy2:
+		case Operation::Op8xy3:
+			fprintf(pFile, "\t\tv[0x%X] %s= v[0x%X];\n", x,
+				instruction.operation == Operation::Op8xy1 ? "|" : instruction.operation == Operation::Op8xy2 ? "&" : "^", y);
+			if (quirks.resetsVF)
+			{
+				fprintf(pFile, "\t\tv[0xF] = 0x00;\n");
+			};
+			break;
+
+		case Operation::Op8xy4:
+			fprintf(pFile, "\t\t{\n\t\t\tunsigned sum = v[0x%X] + v[0x%X];\n\t\t\tv[0x%X] = static_cast<uint8_t>(sum);\n\t\t\tv[0xF] = sum > 0xFF ? 0x01 : 0x00;\n\t\t};\n", x, y, x);
+			break;
+
+		case Operation::Op8xy5:
+		case Operation::Op8xy7:
+			if (x == y)
+			{
+				// Subtracting a register from itself never borrows.
+				fprintf(pFile, "\t\tv[0x%X] = 0x00;\n\t\tv[0xF] = 0x01;\n", x);
+			}
+			else if (instruction.operation == Operation::Op8xy5)
+			{
+				fprintf(pFile, "\t\t{\n\t\t\tuint8_t notBorrow = v[0x%X] >= v[0x%X] ? 0x01 : 0x00;\n\t\t\tv[0x%X] = static_cast<uint8_t>(v[0x%X] - v[0x%X]);\n\t\t\tv[0xF] = notBorrow;\n\t\t};\n", x, y, x, x, y);
+			}
+			else
+			{
+				fprintf(pFile, "\t\t{\n\t\t\tuint8_t notBorrow = v[0x%X] >= v[0x%X] ? 0x01 : 0x00;\n\t\t\tv[0x%X] = static_cast<uint8_t>(v[0x%X] - v[0x%X]);\n\t\t\tv[0xF] = notBorrow;\n\t\t};\n", y, x, x, y, x);
+			};
+			break;
+
+		case Operation::Op8xy6:
+			fprintf(pFile, "\t\t{\n\t\t\tuint8_t source = v[0x%X];\n\t\t\tv[0x%X] = source >> 1;\n\t\t\tv[0xF] = source & 0x01;\n\t\t};\n", quirks.shiftsVy ? y : x, x);
+			break;
+
+		case Operation::Op8xyE:
+			fprintf(pFile, "\t\t{\n\t\t\tuint8_t source = v[0x%X];\n\t\t\tv[0x%X] = static_cast<uint8_t>(source << 1);\n\t\t\tv[0xF] = source & 0x80 ? 0x01 : 0x00;\n\t\t};\n", quirks.shiftsVy ? y : x, x);
+			break;
+
+		case Operation::OpAnnn:
+			fprintf(pFile, "\t\ti = 0x%03x;\n", nnn);
+			break;
+
+		case Operation::OpBnnn:
+			// Computed jump, the engine finds the target block through the dispatcher.
+			fprintf(pFile, "\t\tengine.SetProgramCounter(static_cast<uint16_t>(0x%03x + v[0x%X]));\n\t\treturn executed;\n", nnn, quirks.jumpsWithVx ? x : 0);
+			isFallingThrough = false;
+			break;
+
+		case Operation::OpFx1E:
+			fprintf(pFile, "\t\ti = static_cast<uint16_t>(i + v[0x%X]);\n", x);
+			break;
+
+		case Operation::OpFx29:
+			fprintf(pFile, "\t\ti = (v[0x%X] & 0x0F) * 5;\n", x);
+			break;
+
+		default:
+			// Unknown opcodes are no-ops.
+			break;
+	};
+
+	if (pCondition != nullptr)
+	{
+		// On XO-CHIP a skip steps over F000 nnnn as a whole, the translated bytes after it never change.
+		bool isLongSkip = source.platform == Platform::XoChip && source.memory[next] == 0xF0 && source.memory[next + 1] == 0x00;
+		fprintf(pFile, "\t\tif (%s)\n\t\t{\n", pCondition);
+		WriteExit(pFile, next + (isLongSkip ? g_chipInstructionSize * 2 : g_chipInstructionSize), blockInstructions, "\t");
+		fprintf(pFile, "\t\t};\n");
+		WriteExit(pFile, next, blockInstructions, "");
+		isFallingThrough = false;
+	};
+	fprintf(pFile, "\n");
+	return isFallingThrough;
+};
+
+void WriteExit(FILE* pFile, uint32_t target, const std::bitset<g_chipRamSize>& blockInstructions, const char* pIndent)
+{
+	if (target < g_chipRamSize && blockInstructions.test(target))
+	{
+		fprintf(pFile, "%s\t\tgoto i%03x;\n", pIndent, target);
+		return;
+	};
+
+	fprintf(pFile, "%s\t\tengine.SetProgramCounter(0x%03x);\n%s\t\treturn executed;\n", pIndent, target, pIndent);
+};
+
+Instruction DecodeAt(const AotSource& source, uint16_t address)
+{
+	uint16_t opcode = (source.memory[address & g_chipAddressMask] << 8) | source.memory[(address + 1) & g_chipAddressMask];
+	return DecodeInstruction(opcode, source.platform);
+};
+
+bool IsNative(const AotSource& source, uint16_t address, const Instruction& instruction)
+{
+	switch (instruction.operation)
+	{
+		case Operation::Op3xkk:
+		case Operation::Op4xkk:
+		case Operation::Op5xy0:
+		case Operation::Op9xy0:
+		{
+			// The skip size is only fixed if the instruction after the skip is translated code.
+			uint16_t next = address + g_chipInstructionSize;
+			return source.platform != Platform::XoChip || (next + 1 < g_chipRamSize && source.code.test(next) && source.code.test(next + 1));
+		}
+
+		case Operation::Op1nnn:
+		case Operation::Op6xkk:
+		case Operation::Op7xkk:
+		case Operation::Op8xy0:
+		case Operation::Op8xy1:
+		case Operation::Op8xy2:
+		case Operation::Op8xy3:
+		case Operation::Op8xy4:
+		case Operation::Op8xy5:
+		case Operation::Op8xy6:
+		case Operation::Op8xy7:
+		case Operation::Op8xyE:
+		case Operation::OpAnnn:
+		case Operation::OpBnnn:
+		case Operation::OpFx1E:
+		case Operation::OpFx29:
+		case Operation::Unknown:
+			return true;
+
+		default:
+			return false;
+	};
+};
+
+void PrintUsage(const char* pProgramName)
+{
+	printf("Usage: %s <path-to-rom> --name NAME --out FILE.cpp [--platform chip8|schip|xochip]\n"
+		"       [--quirks default|vip|schip|xochip] [--quirks-db FILE]\n", pProgramName);
+};
@@ -0,0 +1,594 @@
+/*! \file
+		Entry point for the Chip8 microbenchmarks.
+
+		Times the hot paths of the core (dispatch, every opcode family,
+		sprite drawing, blitting, ROM loading and construction) and writes
+		the results as JSON. Benchmark names are stable, so the output of two
+		builds can be compared directly.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Blitter.hpp"
+#include "Framebuffer.hpp"
+#include "Interpreter.hpp"
+#include "RomCache.hpp"
+#include "Simd.hpp"
+
+#ifndef CHIP8_BUILD_TYPE
+#define CHIP8_BUILD_TYPE "unknown"
+#endif
+
+/**
+	Minimum time one repetition of a benchmark runs for unless --min-time is given.
+ */
+constexpr double g_defaultMinTime = 0.1;
+
+/**
+	Number of timed repetitions unless --repetitions is given, the median is reported.
+ */
+constexpr uint32_t g_defaultRepetitions = 5;
+
+/**
+	Number of copies of the measured instruction in an opcode benchmark loop.
+ */
+constexpr uint32_t g_opcodeLoopLength = 32;
+
+/**
+	Instructions executed per Execute() call in the dispatch benchmarks, one 60 Hz frame at 700 IPS.
+ */
+constexpr uint32_t g_benchmarkFrameCycles = 12;
+
+/**
+	Runs a benchmark for a number of iterations.
+
+	@return Number of operations performed.
+ */
+typedef std::function<uint64_t(uint64_t iterations)> BenchmarkBody;
+
+/**
+	A named benchmark.
+ */
+struct Benchmark
+{
+	/** Stable name, families are separated by '/' */
+	std::string name;
+	/** What one operation is, for example "instruction" or "frame" */
+	const char* pUnit;
+	/** Code being timed */
+	BenchmarkBody body;
+};
+
+/**
+	Timing of one benchmark.
+ */
+struct BenchmarkResult
+{
+	/** Name of the benchmark */
+	std::string name;
+	/** Unit of an operation */
+	const char* pUnit;
+	/** Operations per repetition */
+	uint64_t operations;
+	/** Median time per operation over the repetitions */
+	double medianNanoseconds;
+	/** Fastest time per operation over the repetitions */
+	double minimumNanoseconds;
+};
+
+/**
+	Writes a ROM to a file in the temporary directory.
+
+	@param[in] name File name.
+	@param[in] program Big endian instructions placed at 0x200.
+	@return Path of the file, empty if it could not be written.
+ */
+std::string WriteRom(const char* name, const std::vector<uint16_t>& program);
+
+/**
+	Builds an opcode benchmark ROM.\n
+	The setup instructions run once, then g_opcodeLoopLength copies of the
+	body run in a loop closed by a jump.
+
+	@param[in] setup Instructions run before the loop.
+	@param[in] body Instruction being measured.
+	@return The program.
+ */
+std::vector<uint16_t> BuildOpcodeLoop(const std::vector<uint16_t>& setup, uint16_t body);
+
+/**
+	Creates an interpreter running a ROM.
+
+	@param[in] path Path of the ROM.
+	@param[in] backend Execution backend.
+	@return The interpreter, null if it could not be created.
+ */
+std::unique_ptr<Interpreter> CreateInterpreter(const std::string& path, Backend backend);
+
+/**
+	Registers every benchmark.
+
+	@param[out] benchmarks List to add to.
+	@return false if a ROM could not be written.
+ */
+bool RegisterBenchmarks(std::vector<Benchmark>& benchmarks);
+
+/**
+	Times a benchmark.\n
+	The iteration count is doubled until one run takes a tenth of minTime,
+	then scaled so each repetition takes about minTime.
+ */
+BenchmarkResult RunBenchmark(const Benchmark& benchmark, double minTime, uint32_t repetitions);
+
+/**
+	Writes the results as JSON.
+ */
+void WriteJson(FILE* pFile, const std::vector<BenchmarkResult>& results, double minTime, uint32_t repetitions);
+
+/**
+	Prints how to use the benchmarks.
+
+	@param[in] pProgramName Name of the executable.
+ */
+void PrintUsage(const char* pProgramName);
+
+/**
+	Defeats dead code elimination of benchmark results.
+ */
+volatile uint64_t g_sink = 0;
+
+/**
+	Entrypoint for program.
+ */
+int main(int argc, char** argv)
+{
+	const char* pOutputPath = nullptr;
+	const char* pFilter = nullptr;
+	double minTime = g_defaultMinTime;
+	uint32_t repetitions = g_defaultRepetitions;
+	bool isListing = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+		{
+			pOutputPath = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+		{
+			pFilter = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+		{
+			minTime = std::strtod(argv[++i], nullptr);
+		}
+		else if (std::strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc)
+		{
+			repetitions = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (std::strcmp(argv[i], "--list") == 0)
+		{
+			isListing = true;
+		}
+		else
+		{
+			PrintUsage(argv[0]);
+			return -1;
+		};
+	};
+
+	if (minTime <= 0.0 || repetitions == 0)
+	{
+		PrintUsage(argv[0]);
+		return -1;
+	};
+
+	std::vector<Benchmark> benchmarks;
+	if (!RegisterBenchmarks(benchmarks))
+	{
+		printf("Failed to write the benchmark ROMs\n");
+		return -1;
+	};
+
+	std::vector<BenchmarkResult> results;
+	for (const Benchmark& benchmark : benchmarks)
+	{
+		if (pFilter != nullptr && benchmark.name.find(pFilter) == std::string::npos)
+		{
+			continue;
+		};
+
+		if (isListing)
+		{
+			printf("%s\n", benchmark.name.c_str());
+			continue;
+		};
+
+		BenchmarkResult result = RunBenchmark(benchmark, minTime, repetitions);
+		fprintf(stderr, "%-32s %10.2f ns/%s\n", result.name.c_str(), result.medianNanoseconds, result.pUnit);
+		results.push_back(result);
+	};
+
+	if (isListing)
+	{
+		return 0;
+	};
+
+	FILE* pFile = pOutputPath != nullptr ? std::fopen(pOutputPath, "w") : stdout;
+	if (pFile == nullptr)
+	{
+		printf("Failed to write %s\n", pOutputPath);
+		return -1;
+	};
+
+	WriteJson(pFile, results, minTime, repetitions);
+	if (pFile != stdout)
+	{
+		std::fclose(pFile);
+	};
+
+	return 0;
+};
+
+std::string WriteRom(const char* name, const std::vector<uint16_t>& program)
+{
+	const char* pDirectory = std::getenv("TMPDIR");
+#if defined(_WIN32)
+	if (pDirectory == nullptr)
+	{
+		pDirectory = std::getenv("TEMP");
+	};
+	std::string path = std::string(pDirectory != nullptr ? pDirectory : ".") + "\\" + name;
+#else
+	std::string path = std::string(pDirectory != nullptr ? pDirectory : "/tmp") + "/" + name;
+#endif
+
+	FILE* pFile = std::fopen(path.c_str(), "wb");
+	if (pFile == nullptr)
+	{
+		return std::string();
+	};
+
+	for (uint16_t opcode : program)
+	{
+		std::fputc(opcode >> 8, pFile);
+		std::fputc(opcode & 0xFF, pFile);
+	};
+
+	std::fclose(pFile);
+	return path;
+};
+
+std::vector<uint16_t> BuildOpcodeLoop(const std::vector<uint16_t>& setup, uint16_t body)
+{
+	std::vector<uint16_t> program = setup;
+	uint16_t loopStart = static_cast<uint16_t>(0x0200 + program.size() * g_chipInstructionSize);
+	for (uint32_t i = 0; i < g_opcodeLoopLength; i++)
+	{
+		program.push_back(body);
+	};
+	program.push_back(0x1000 | loopStart);
+	return program;
+};
+
+std::unique_ptr<Interpreter> CreateInterpreter(const std::string& path, Backend backend)
+{
+	std::unique_ptr<Interpreter> pInterpreter = std::make_unique<Interpreter>();
+	if (!pInterpreter->Initialize(path.c_str(), ScreenSize::Chip8) || !pInterpreter->SetBackend(backend))
+	{
+		return nullptr;
+	};
+	return pInterpreter;
+};
+
+/**
+	Benchmark executing a ROM in frame sized slices.
+ */
+BenchmarkBody ExecuteBody(const std::string& path, Backend backend)
+{
+	std::shared_ptr<Interpreter> pInterpreter = CreateInterpreter(path, backend);
+	return [pInterpreter](uint64_t iterations) -> uint64_t
+	{
+		for (uint64_t i = 0; i < iterations; i++)
+		{
+			pInterpreter->Execute(g_benchmarkFrameCycles);
+		};
+		return iterations * g_benchmarkFrameCycles;
+	};
+};
+
+bool RegisterBenchmarks(std::vector<Benchmark>& benchmarks)
+{
+	// A typical game loop: arithmetic, a subroutine call, a random number, a skip and a sprite.
+	std::vector<uint16_t> mix =
+	{
+		0x6005, 0x6103, 0xA000,
+		0x7001, 0x7101, 0x8204, 0x8312, 0x4300, 0x7302, 0xC40F,
+		0x2300, 0xF21E, 0x3F01, 0xD015, 0x8016, 0x8114, 0x1206
+	};
+	mix.resize(0x0100 / g_chipInstructionSize, 0x0000);
+	mix.push_back(0x7501);		// 0x300
+	mix.push_back(0x00EE);
+	std::string mixPath = WriteRom("chip8-bench-mix.ch8", mix);
+
+	// Largest ROM that fits in memory.
+	std::vector<uint16_t> full((g_chipRamSize - 0x0200) / g_chipInstructionSize, 0x1200);
+	std::string fullPath = WriteRom("chip8-bench-full.ch8", full);
+
+	if (mixPath.empty() || fullPath.empty())
+	{
+		return false;
+	};
+
+	// Instruction mix, one Run() call per instruction and through each backend.
+	std::shared_ptr<Interpreter> pRunInterpreter = CreateInterpreter(mixPath, Backend::Interpreter);
+	benchmarks.push_back({ "dispatch/run", "instruction", [pRunInterpreter](uint64_t iterations) -> uint64_t
+	{
+		Interpreter* pInterpreter = pRunInterpreter.get();
+		for (uint64_t i = 0; i < iterations; i++)
+		{
+			pInterpreter->Run();
+		};
+		return iterations;
+	} });
+	benchmarks.push_back({ "dispatch/execute", "instruction", ExecuteBody(mixPath, Backend::Interpreter) });
+	if (CreateInterpreter(mixPath, Backend::Recompiler))
+	{
+		benchmarks.push_back({ "dispatch/recompiler", "instruction", ExecuteBody(mixPath, Backend::Recompiler) });
+	};
+
+	// One loop per opcode family, V0 = 5, V1 = 3 and I = 0x300 unless the setup says otherwise.
+	struct OpcodeFamily
+	{
+		const char* pName;
+		std::vector<uint16_t> setup;
+		uint16_t body;
+	};
+	const std::vector<uint16_t> defaultSetup = { 0x6005, 0x6103, 0xA300 };
+	std::vector<OpcodeFamily> families =
+	{
+		{ "00E0", defaultSetup, 0x00E0 },
+		{ "3xkk", defaultSetup, 0x3001 },
+		{ "4xkk", defaultSetup, 0x4005 },
+		{ "5xy0", defaultSetup, 0x5010 },
+		{ "6xkk", defaultSetup, 0x6A42 },
+		{ "7xkk", defaultSetup, 0x7A01 },
+		{ "8xy0", defaultSetup, 0x8A10 },
+		{ "8xy1", defaultSetup, 0x8A11 },
+		{ "8xy4", defaultSetup, 0x8A14 },
+		{ "8xy5", defaultSetup, 0x8A15 },
+		{ "8xy6", defaultSetup, 0x8A16 },
+		{ "8xyE", defaultSetup, 0x8A1E },
+		{ "9xy0", defaultSetup, 0x9000 },
+		{ "Annn", defaultSetup, 0xA300 },
+		{ "Cxkk", defaultSetup, 0xCAFF },
+		{ "Dxyn", { 0x6005, 0x6103, 0xA000 }, 0xD015 },
+		{ "Ex9E", defaultSetup, 0xE09E },
+		{ "ExA1", defaultSetup, 0xE1A1 },
+		{ "Fx07", defaultSetup, 0xFA07 },
+		{ "Fx15", defaultSetup, 0xF015 },
+		{ "Fx1E", { 0x6000, 0xA300 }, 0xF01E },
+		{ "Fx29", defaultSetup, 0xF029 },
+		{ "Fx33", defaultSetup, 0xF033 },
+		{ "Fx55", defaultSetup, 0xF755 },
+		{ "Fx65", defaultSetup, 0xF765 }
+	};
+
+	for (const OpcodeFamily& family : families)
+	{
+		std::string name = family.pName;
+		std::string path = WriteRom(("chip8-bench-" + name + ".ch8").c_str(), BuildOpcodeLoop(family.setup, family.body));
+		if (path.empty())
+		{
+			return false;
+		};
+		benchmarks.push_back({ "opcode/" + name, "instruction", ExecuteBody(path, Backend::Interpreter) });
+	};
+
+	// Jumps and calls do not fit a straight loop, every instruction targets the next one.
+	std::vector<uint16_t> jumps;
+	std::vector<uint16_t> calls;
+	for (uint16_t i = 0; i < g_opcodeLoopLength; i++)
+	{
+		jumps.push_back(0x1000 | (0x0202 + i * g_chipInstructionSize));
+		calls.push_back(0x2300);
+	};
+	jumps.push_back(0x1200);
+	calls.push_back(0x1200);
+	calls.resize(0x0100 / g_chipInstructionSize, 0x0000);
+	calls.push_back(0x00EE);
+
+	std::string jumpPath = WriteRom("chip8-bench-1nnn.ch8", jumps);
+	std::string callPath = WriteRom("chip8-bench-2nnn.ch8", calls);
+	if (jumpPath.empty() || callPath.empty())
+	{
+		return false;
+	};
+	benchmarks.push_back({ "opcode/1nnn", "instruction", ExecuteBody(jumpPath, Backend::Interpreter) });
+	benchmarks.push_back({ "opcode/2nnn_00EE", "instruction", ExecuteBody(callPath, Backend::Interpreter) });
+
+	// Sprites at byte aligned, unaligned and clipped positions, drawn twice so the screen stays clear.
+	static const uint8_t s_sprite[15] = { 0xFF, 0x81, 0xBD, 0xA5, 0xA5, 0xBD, 0x81, 0xFF, 0x3C, 0x42, 0x99, 0xA5, 0x99, 0x42, 0x3C };
+	struct SpritePosition
+	{
+		const char* pName;
+		uint16_t x;
+		uint16_t y;
+	};
+	const SpritePosition positions[] = { { "aligned", 8, 4 }, { "unaligned", 11, 4 }, { "clipped", 60, 28 } };
+	for (uint8_t height : { 1, 5, 15 })
+	{
+		for (const SpritePosition& position : positions)
+		{
+			std::shared_ptr<Framebuffer> pFramebuffer = std::make_shared<Framebuffer>();
+			pFramebuffer->Resize(64, 32);
+			std::string name = "sprite/h" + std::to_string(height) + "/" + position.pName;
+			benchmarks.push_back({ name, "sprite", [pFramebuffer, position, height](uint64_t iterations) -> uint64_t
+			{
+				uint64_t collisions = 0;
+				for (uint64_t i = 0; i < iterations; i++)
+				{
+					collisions += pFramebuffer->DrawSprite<false>(position.x, position.y, s_sprite, height) ? 1 : 0;
+				};
+				g_sink = collisions;
+				return iterations;
+			} });
+		};
+	};
+
+	// Full window blits of a busy screen.
+	for (uint32_t scale : { 1, 4, 10 })
+	{
+		std::shared_ptr<Framebuffer> pFramebuffer = std::make_shared<Framebuffer>();
+		pFramebuffer->Resize(64, 32);
+		for (uint16_t y = 0; y < 32; y += 3)
+		{
+			pFramebuffer->DrawSprite<false>(y, y, s_sprite, 15);
+		};
+
+		uint32_t width = 64 * scale;
+		uint32_t height = 32 * scale;
+		std::shared_ptr<std::vector<uint32_t>> pPixels = std::make_shared<std::vector<uint32_t>>(width * height);
+		std::shared_ptr<Blitter> pBlitter = std::make_shared<Blitter>();
+		pBlitter->SetScale(scale);
+
+		benchmarks.push_back({ "blit/scale" + std::to_string(scale), "frame", [=](uint64_t iterations) -> uint64_t
+		{
+			for (uint64_t i = 0; i < iterations; i++)
+			{
+				pBlitter->Blit(*pFramebuffer, pPixels->data(), width, width, height);
+			};
+			g_sink = (*pPixels)[width * height / 2];
+			return iterations;
+		} });
+	};
+
+	// ROM loading, served from the ROM cache after the first load, and construction.
+	for (const std::pair<const char*, std::string>& rom : { std::make_pair("small", mixPath), std::make_pair("full", fullPath) })
+	{
+		std::string path = rom.second;
+		benchmarks.push_back({ std::string("rom/load/") + rom.first, "load", [path](uint64_t iterations) -> uint64_t
+		{
+			Interpreter interpreter;
+			for (uint64_t i = 0; i < iterations; i++)
+			{
+				g_sink = interpreter.Initialize(path.c_str(), ScreenSize::Chip8) ? 1 : 0;
+			};
+			return iterations;
+		} });
+	};
+
+	// The same loads with the ROM cache dropped first, so the file is read every time.
+	benchmarks.push_back({ "rom/read/full", "load", [fullPath](uint64_t iterations) -> uint64_t
+	{
+		Interpreter interpreter;
+		for (uint64_t i = 0; i < iterations; i++)
+		{
+			RomCache::GetInstance().Clear();
+			g_sink = interpreter.Initialize(fullPath.c_str(), ScreenSize::Chip8) ? 1 : 0;
+		};
+		return iterations;
+	} });
+
+	benchmarks.push_back({ "interpreter/construct", "instance", [](uint64_t iterations) -> uint64_t
+	{
+		for (uint64_t i = 0; i < iterations; i++)
+		{
+			std::unique_ptr<Interpreter> pInterpreter = std::make_unique<Interpreter>();
+			g_sink = pInterpreter->GetCycleCount();
+		};
+		return iterations;
+	} });
+
+	return true;
+};
+
+BenchmarkResult RunBenchmark(const Benchmark& benchmark, double minTime, uint32_t repetitions)
+{
+	auto time = [&benchmark](uint64_t iterations, uint64_t& operations) -> double
+	{
+		auto start = std::chrono::steady_clock::now();
+		operations = benchmark.body(iterations);
+		auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double>(end - start).count();
+	};
+
+	uint64_t iterations = 1;
+	uint64_t operations = 0;
+	double seconds = time(iterations, operations);
+	while (seconds < minTime / 10.0)
+	{
+		iterations *= 2;
+		seconds = time(iterations, operations);
+	};
+	iterations = std::max<uint64_t>(1, static_cast<uint64_t>(iterations * minTime / std::max(seconds, 1e-9)));
+
+	std::vector<double> nanoseconds;
+	for (uint32_t i = 0; i < repetitions; i++)
+	{
+		seconds = time(iterations, operations);
+		nanoseconds.push_back(seconds * 1e9 / std::max<uint64_t>(operations, 1));
+	};
+	std::sort(nanoseconds.begin(), nanoseconds.end());
+
+	BenchmarkResult result;
+	result.name = benchmark.name;
+	result.pUnit = benchmark.pUnit;
+	result.operations = operations;
+	result.medianNanoseconds = nanoseconds[nanoseconds.size() / 2];
+	result.minimumNanoseconds = nanoseconds.front();
+	return result;
+};
+
+void WriteJson(FILE* pFile, const std::vector<BenchmarkResult>& results, double minTime, uint32_t repetitions)
+{
+#if CHIP8_SIMD_AVX2
+	const char* pSimd = "avx2";
+#elif CHIP8_SIMD_SSE2
+	const char* pSimd = "sse2";
+#else
+	const char* pSimd = "scalar";
+#endif
+
+#if CHIP8_THREADED_DISPATCH
+	const char* pDispatch = "threaded";
+#else
+	const char* pDispatch = "switch";
+#endif
+
+	fprintf(pFile, "{\n");
+	fprintf(pFile, "  \"context\": {\n");
+	fprintf(pFile, "    \"build_type\": \"%s\",\n", CHIP8_BUILD_TYPE);
+	fprintf(pFile, "    \"dispatch\": \"%s\",\n", pDispatch);
+	fprintf(pFile, "    \"simd\": \"%s\",\n", pSimd);
+	fprintf(pFile, "    \"min_time\": %g,\n", minTime);
+	fprintf(pFile, "    \"repetitions\": %u\n", repetitions);
+	fprintf(pFile, "  },\n");
+	fprintf(pFile, "  \"benchmarks\": [\n");
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const BenchmarkResult& result = results[i];
+		fprintf(pFile, "    { \"name\": \"%s\", \"unit\": \"%s\", \"operations\": %llu, \"ns_per_op\": %.3f, \"min_ns_per_op\": %.3f, \"ops_per_second\": %.0f }%s\n",
+			result.name.c_str(),
+			result.pUnit,
+			static_cast<unsigned long long>(result.operations),
+			result.medianNanoseconds,
+			result.minimumNanoseconds,
+			result.medianNanoseconds > 0.0 ? 1e9 / result.medianNanoseconds : 0.0,
+			i + 1 < results.size() ? "," : "");
+	};
+	fprintf(pFile, "  ]\n");
+	fprintf(pFile, "}\n");
+};
+
+void PrintUsage(const char* pProgramName)
+{
+	printf("Usage: %s [--out FILE] [--filter TEXT] [--min-time SECONDS] [--repetitions N] [--list]\n", pProgramName);
+};
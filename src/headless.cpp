@@ -0,0 +1,725 @@
+/*! \file
+		Entry point for the headless Chip8 runner.
+
+		Executes a ROM without any window or throttling and reports the
+		achieved instructions per second.
+ */
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "Audio.hpp"
+#include "BatchEngine.hpp"
+#include "Interpreter.hpp"
+#include "LockstepEngine.hpp"
+#include "Movie.hpp"
+#if CHIP8_PROFILER
+#include "Profiler.hpp"
+#endif
+#include "Quirks.hpp"
+#include "RewindBuffer.hpp"
+#include "RomAnalyzer.hpp"
+#include "RomCache.hpp"
+#include "Scheduler.hpp"
+
+/**
+	Number of instructions executed per frame when running by frames.
+ */
+constexpr uint32_t g_defaultCyclesPerFrame = 10;
+
+/**
+	Number of instructions executed when neither cycles or frames are given.
+ */
+constexpr uint64_t g_defaultCycles = 10000000;
+
+/**
+	Number of instructions a batch instance runs before yielding.
+ */
+constexpr uint32_t g_defaultSliceCycles = 10000;
+
+/**
+	Number of addresses and subroutines listed in the profile report.
+ */
+constexpr uint32_t g_profileTopCount = 16;
+
+/**
+	Creates and initializes an interpreter for the ROM.
+
+	@param[in] pRomPath Path to the ROM file.
+	@param[in] backend Requested execution backend.
+	@param[in] platform Instruction set to run the ROM with.
+	@param[in] pQuirks Quirk profile to run the ROM with, null picks it from the QuirkDatabase.
+	@param[in] seed Random seed.
+	@param[in] isSkippingIdle Skip the iterations of wait loops instead of executing them.
+	@return The interpreter or null if the ROM failed to load.
+ */
+std::unique_ptr<Interpreter> CreateInterpreter(const char* pRomPath, Backend backend, Platform platform, const QuirkProfile* pQuirks, uint64_t seed, bool isSkippingIdle);
+
+/**
+	Analyzes the ROM and decodes, or translates, its code before running it.
+
+	@param[in] interpreter Interpreter the ROM is loaded in.
+	@param[in] pRomPath Path to the ROM file.
+	@return false if the ROM could not be read.
+ */
+bool PrepareInterpreter(Interpreter& interpreter, const char* pRomPath);
+
+/**
+	Restores an interpreter from a save state file.
+
+	@param[in] interpreter Interpreter to restore.
+	@param[in] pStatePath Path to a file written by SaveStateFile().
+	@return false if the file could not be read or loaded.
+ */
+bool LoadStateFile(Interpreter& interpreter, const char* pStatePath);
+
+/**
+	Writes the state of an interpreter to a file.
+
+	@param[in] interpreter Interpreter to save.
+	@param[in] pStatePath Path of the file to write.
+	@return false if the file could not be written.
+ */
+bool SaveStateFile(const Interpreter& interpreter, const char* pStatePath);
+
+/**
+	Runs many instances of the ROM on the batch engine and prints aggregate throughput.
+
+	@return Exit code for the program.
+ */
+int RunBatch(const char* pRomPath, const char* pStatePath, Backend backend, Platform platform, const QuirkProfile* pQuirks, uint64_t seed, uint64_t cycles, uint32_t cyclesPerFrame, uint32_t instances, uint32_t threads, uint32_t sliceCycles, bool isSkippingIdle);
+
+/**
+	Runs lanes copies of the ROM on the lockstep engine and prints aggregate throughput.
+
+	@param[in] pExpectedHash State hash lane 0 has to end with, null to accept any.
+	@return Exit code for the program.
+ */
+int RunLockstep(const char* pRomPath, uint64_t seed, uint64_t cycles, uint32_t cyclesPerFrame, uint32_t lanes, const uint64_t* pExpectedHash);
+
+/**
+	Compares the state hash at the end of a run against --expect-hash.
+
+	@param[in] hash State hash the run ended with.
+	@param[in] pExpectedHash Expected state hash, null to accept any.
+	@return false if the hashes differ.
+ */
+bool CheckStateHash(uint64_t hash, const uint64_t* pExpectedHash);
+
+/**
+	Replays a movie on a fresh interpreter and checks that it ends in the recorded state.
+
+	@return Exit code for the program.
+ */
+int RunReplay(const char* pRomPath, const char* pMoviePath, Backend backend, Platform platform, const QuirkProfile* pQuirks, bool isSkippingIdle);
+
+/**
+	Prints how to use the headless runner.
+
+	@param[in] pProgramName Name of the executable.
+ */
+void PrintUsage(const char* pProgramName);
+
+/**
+	Entrypoint for program.
+ */
+int main(int argc, char** argv)
+{
+	const char* pRomPath = nullptr;
+	const char* pLoadPath = nullptr;
+	const char* pSavePath = nullptr;
+	const char* pRecordPath = nullptr;
+	const char* pReplayPath = nullptr;
+#if CHIP8_PROFILER
+	const char* pProfilePath = nullptr;
+#endif
+	const char* pAudioPath = nullptr;
+	uint64_t seed = g_defaultRandomSeed;
+	uint64_t cycles = 0;
+	uint64_t frames = 0;
+	uint32_t cyclesPerFrame = g_defaultCyclesPerFrame;
+	Backend backend = Backend::Interpreter;
+	Platform platform = Platform::Chip8;
+	QuirkProfile quirks = QuirkProfile::Default;
+	const QuirkProfile* pQuirks = nullptr;
+	uint32_t instances = 1;
+	uint32_t threads = 0;
+	uint32_t sliceCycles = g_defaultSliceCycles;
+	uint32_t lanes = 0;
+	bool isRewindEnabled = false;
+	uint32_t rewindFrames = 0;
+	bool isPrepared = false;
+	bool isSkippingIdle = false;
+	uint64_t expectedHash = 0;
+	const uint64_t* pExpectedHash = nullptr;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--cycles") == 0 && i + 1 < argc)
+		{
+			cycles = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+		{
+			frames = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (std::strcmp(argv[i], "--cycles-per-frame") == 0 && i + 1 < argc)
+		{
+			cyclesPerFrame = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (std::strcmp(argv[i], "--instances") == 0 && i + 1 < argc)
+		{
+			instances = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+		{
+			threads = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (std::strcmp(argv[i], "--slice") == 0 && i + 1 < argc)
+		{
+			sliceCycles = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (std::strcmp(argv[i], "--load-state") == 0 && i + 1 < argc)
+		{
+			pLoadPath = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--save-state") == 0 && i + 1 < argc)
+		{
+			pSavePath = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+		{
+			seed = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+		{
+			pRecordPath = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+		{
+			pReplayPath = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+		{
+#if CHIP8_PROFILER
+			pProfilePath = argv[++i];
+#else
+			printf("--profile %s: profiling needs a build configured with -DCHIP8_PROFILER=ON\n", argv[++i]);
+			return -1;
+#endif
+		}
+		else if (std::strcmp(argv[i], "--audio") == 0 && i + 1 < argc)
+		{
+			pAudioPath = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--rewind") == 0)
+		{
+			isRewindEnabled = true;
+		}
+		else if (std::strcmp(argv[i], "--rewind-frames") == 0 && i + 1 < argc)
+		{
+			rewindFrames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			isRewindEnabled = true;
+		}
+		else if (std::strcmp(argv[i], "--prepare") == 0)
+		{
+			isPrepared = true;
+		}
+		else if (std::strcmp(argv[i], "--skip-idle") == 0)
+		{
+			isSkippingIdle = true;
+		}
+		else if (std::strcmp(argv[i], "--expect-hash") == 0 && i + 1 < argc)
+		{
+			expectedHash = std::strtoull(argv[++i], nullptr, 16);
+			pExpectedHash = &expectedHash;
+		}
+		else if (std::strcmp(argv[i], "--lanes") == 0 && i + 1 < argc)
+		{
+			lanes = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (std::strcmp(argv[i], "--backend") == 0 && i + 1 < argc)
+		{
+			i++;
+			if (std::strcmp(argv[i], "interpreter") == 0)
+			{
+				backend = Backend::Interpreter;
+			}
+			else if (std::strcmp(argv[i], "recompiler") == 0)
+			{
+				backend = Backend::Recompiler;
+			}
+			else if (std::strcmp(argv[i], "aot") == 0)
+			{
+				backend = Backend::Aot;
+			}
+			else
+			{
+				PrintUsage(argv[0]);
+				return -1;
+			};
+		}
+		else if (std::strcmp(argv[i], "--quirks") == 0 && i + 1 < argc)
+		{
+			if (!FindQuirkProfile(argv[++i], quirks))
+			{
+				PrintUsage(argv[0]);
+				return -1;
+			};
+			pQuirks = &quirks;
+		}
+		else if (std::strcmp(argv[i], "--quirks-db") == 0 && i + 1 < argc)
+		{
+			if (!QuirkDatabase::GetInstance().Load(argv[++i]))
+			{
+				printf("Failed to read quirk database %s\n", argv[i]);
+				return -1;
+			};
+		}
+		else if (std::strcmp(argv[i], "--platform") == 0 && i + 1 < argc)
+		{
+			if (!FindPlatform(argv[++i], platform))
+			{
+				PrintUsage(argv[0]);
+				return -1;
+			};
+		}
+		else if (argv[i][0] != '-' && pRomPath == nullptr)
+		{
+			pRomPath = argv[i];
+		}
+		else
+		{
+			PrintUsage(argv[0]);
+			return -1;
+		};
+	};
+
+	// A movie starts from a freshly loaded ROM.
+	if (pRomPath == nullptr || cyclesPerFrame == 0 || instances == 0 || (pRecordPath != nullptr && pLoadPath != nullptr))
+	{
+		PrintUsage(argv[0]);
+		return -1;
+	};
+
+	if (frames > 0)
+	{
+		cycles = frames * cyclesPerFrame;
+	}
+	else if (cycles == 0)
+	{
+		cycles = g_defaultCycles;
+	};
+
+	if (pReplayPath != nullptr)
+	{
+		return RunReplay(pRomPath, pReplayPath, backend, platform, pQuirks, isSkippingIdle);
+	};
+
+	// The lockstep engine only implements the original instruction set with the default quirks.
+	if (lanes > 0 && platform != Platform::Chip8)
+	{
+		printf("--lanes only supports --platform chip8\n");
+		return -1;
+	};
+
+	if (lanes > 0)
+	{
+		// Without --quirks the ROM may still be listed in the quirk database.
+		QuirkProfile laneQuirks = quirks;
+		if (pQuirks == nullptr)
+		{
+			RomStatus status;
+			std::shared_ptr<const Rom> pRom = RomCache::GetInstance().Load(pRomPath, g_chipRomMaxSize, status);
+			if (!pRom)
+			{
+				printf("Failed to read %s\n", pRomPath);
+				return -1;
+			};
+			laneQuirks = QuirkDatabase::GetInstance().Find(pRom->hash, platform);
+		};
+
+		if (laneQuirks != QuirkProfile::Default)
+		{
+			printf("--lanes only supports the default quirks, %s runs with %s\n", pRomPath, GetQuirkProfileName(laneQuirks));
+			return -1;
+		};
+
+		return RunLockstep(pRomPath, seed, cycles, cyclesPerFrame, lanes, pExpectedHash);
+	};
+
+	if (instances > 1 || threads > 0)
+	{
+		return RunBatch(pRomPath, pLoadPath, backend, platform, pQuirks, seed, cycles, cyclesPerFrame, instances, threads, sliceCycles, isSkippingIdle);
+	};
+
+	std::unique_ptr<Interpreter> pInterpreter = CreateInterpreter(pRomPath, backend, platform, pQuirks, seed, isSkippingIdle);
+	if (!pInterpreter || (isPrepared && !PrepareInterpreter(*pInterpreter, pRomPath)) ||
+		(pLoadPath != nullptr && !LoadStateFile(*pInterpreter, pLoadPath)))
+	{
+		return -1;
+	};
+
+	// Records every frame like the interactive loop does, to measure the cost of rewinding.
+	std::unique_ptr<RewindBuffer> pRewind = isRewindEnabled ? std::make_unique<RewindBuffer>() : nullptr;
+	uint64_t pushedFrames = 0;
+
+	Movie movie;
+	movie.Start(seed);
+
+#if CHIP8_PROFILER
+	std::unique_ptr<Profiler> pProfiler = pProfilePath != nullptr ? std::make_unique<Profiler>() : nullptr;
+	pInterpreter->SetProfiler(pProfiler.get());
+#endif
+
+	// Renders one frame of audio after every frame, either in to a WAV file or discarded to measure the synthesis.
+	std::unique_ptr<AudioEngine> pAudio;
+	WavWriter wavWriter;
+	std::vector<float> audioFrame;
+	if (pAudioPath != nullptr)
+	{
+		uint32_t samplesPerFrame = g_audioDefaultSampleRate / g_timerFrequency;
+		pAudio = std::make_unique<AudioEngine>(g_audioDefaultSampleRate, samplesPerFrame);
+		pAudio->SetInstructionsPerSecond(cyclesPerFrame * g_timerFrequency);
+		pInterpreter->SetSoundListener(pAudio.get());
+		audioFrame.resize(samplesPerFrame);
+
+		if (std::strcmp(pAudioPath, "null") != 0 && !wavWriter.Open(pAudioPath, g_audioDefaultSampleRate))
+		{
+			printf("Failed to create %s\n", pAudioPath);
+			return -1;
+		};
+	};
+
+	auto start = std::chrono::steady_clock::now();
+
+	// Execute in frame sized slices with a timer tick after each, like the interactive loop.
+	uint64_t remaining = cycles;
+	while (remaining > 0)
+	{
+		uint32_t slice = static_cast<uint32_t>(remaining < cyclesPerFrame ? remaining : cyclesPerFrame);
+		remaining -= pInterpreter->Execute(slice);
+		if (slice == cyclesPerFrame)
+		{
+			pInterpreter->TickTimers();
+			if (pRecordPath != nullptr)
+			{
+				movie.Record(pInterpreter->GetCycleCount(), MovieEvent::Frame);
+			};
+			if (pRewind)
+			{
+				pRewind->Push(*pInterpreter);
+				pushedFrames++;
+			};
+			if (pAudio)
+			{
+				pAudio->Render(audioFrame.data(), static_cast<uint32_t>(audioFrame.size()));
+				wavWriter.Write(audioFrame.data(), static_cast<uint32_t>(audioFrame.size()));
+			};
+		};
+	};
+
+	auto end = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(end - start).count();
+	uint64_t executed = pInterpreter->GetCycleCount();
+
+	printf("Executed %llu instructions (%llu frames) in %.3f s\n",
+		static_cast<unsigned long long>(executed),
+		static_cast<unsigned long long>(executed / cyclesPerFrame),
+		seconds);
+	printf("%.0f instructions/sec\n", seconds > 0.0 ? executed / seconds : 0.0);
+	printf("State hash %016llx\n", static_cast<unsigned long long>(pInterpreter->GetStateHash()));
+	printf("ROM hash %016llx, quirks %s\n", static_cast<unsigned long long>(pInterpreter->GetRomHash()), GetQuirkProfileName(pInterpreter->GetQuirkProfile()));
+	if (isSkippingIdle)
+	{
+		printf("Skipped %llu instructions in wait loops\n", static_cast<unsigned long long>(pInterpreter->GetIdleCycleCount()));
+	};
+	if (backend == Backend::Recompiler)
+	{
+		uint64_t recompiled = pInterpreter->GetRecompiledCycleCount();
+		printf("Ran %llu instructions in recompiled blocks (%.0f%%)\n", static_cast<unsigned long long>(recompiled), executed > 0 ? 100.0 * recompiled / executed : 0.0);
+	};
+
+	if (pAudio)
+	{
+		pInterpreter->SetSoundListener(nullptr);
+		if (!wavWriter.Close())
+		{
+			printf("Failed to write %s\n", pAudioPath);
+			return -1;
+		};
+		printf("Audio dropped %llu beeper changes\n", static_cast<unsigned long long>(pAudio->GetDroppedEvents()));
+	};
+
+	if (pRewind && pRewind->GetFrameCount() > 0)
+	{
+		printf("Rewind holds %u of %llu frames in %zu bytes (%.1f bytes/frame)\n",
+			pRewind->GetFrameCount(),
+			static_cast<unsigned long long>(pushedFrames),
+			pRewind->GetUsedBytes(),
+			static_cast<double>(pRewind->GetUsedBytes()) / pRewind->GetFrameCount());
+	};
+
+	// Steps back like holding Backspace does, --expect-hash then checks the rewound state.
+	for (uint32_t i = 0; i < rewindFrames; i++)
+	{
+		if (!pRewind->Rewind(*pInterpreter))
+		{
+			printf("Rewind failed after %u of %u frames\n", i, rewindFrames);
+			return -1;
+		};
+	};
+	if (rewindFrames > 0)
+	{
+		printf("Rewound %u frames, state hash %016llx\n", rewindFrames, static_cast<unsigned long long>(pInterpreter->GetStateHash()));
+	};
+
+	if (pSavePath != nullptr && !SaveStateFile(*pInterpreter, pSavePath))
+	{
+		return -1;
+	};
+
+#if CHIP8_PROFILER
+	if (pProfiler)
+	{
+		printf("\n");
+		pProfiler->WriteReport(stdout, g_profileTopCount);
+		if (!pProfiler->WriteFoldedStacks(pProfilePath))
+		{
+			printf("Failed to write %s\n", pProfilePath);
+			return -1;
+		};
+	};
+#endif
+
+	if (pRecordPath != nullptr)
+	{
+		movie.Finish(*pInterpreter);
+		if (!movie.Save(pRecordPath))
+		{
+			printf("Failed to write %s\n", pRecordPath);
+			return -1;
+		};
+	};
+
+	return CheckStateHash(pInterpreter->GetStateHash(), pExpectedHash) ? 0 : -1;
+};
+
+std::unique_ptr<Interpreter> CreateInterpreter(const char* pRomPath, Backend backend, Platform platform, const QuirkProfile* pQuirks, uint64_t seed, bool isSkippingIdle)
+{
+	std::unique_ptr<Interpreter> pInterpreter = std::make_unique<Interpreter>();
+	if (!pInterpreter->Initialize(pRomPath, ScreenSize::Chip8, platform))
+	{
+		printf("Failed to initialize Chip8 Emulator!\n");
+		return nullptr;
+	};
+	pInterpreter->SetRandomSeed(seed);
+	pInterpreter->SetIdleSkipping(isSkippingIdle);
+	if (pQuirks != nullptr)
+	{
+		pInterpreter->SetQuirkProfile(*pQuirks);
+	};
+
+	if (!pInterpreter->SetBackend(backend))
+	{
+		printf("Requested backend is not available, falling back to the interpreter.\n");
+	};
+
+	return pInterpreter;
+};
+
+bool PrepareInterpreter(Interpreter& interpreter, const char* pRomPath)
+{
+	// Already cached by Interpreter::Initialize(), this only costs a stat().
+	RomStatus status;
+	std::shared_ptr<const Rom> pRom = RomCache::GetInstance().Load(pRomPath, g_xoRomMaxSize, status);
+	if (!pRom)
+	{
+		printf("Failed to read %s\n", pRomPath);
+		return false;
+	};
+
+	RomAnalyzer analyzer(interpreter.GetPlatform(), interpreter.GetQuirkProfile());
+	RomAnalysis analysis = analyzer.Analyze(pRom->data.data(), pRom->data.size());
+	interpreter.Prepare(analysis);
+
+	printf("Prepared %zu blocks, %s\n", analysis.blocks.size(), analysis.IsStatic() ? "static code" : "code may change at run time");
+	return true;
+};
+
+bool LoadStateFile(Interpreter& interpreter, const char* pStatePath)
+{
+	std::array<uint8_t, g_saveStateMaxSize> buffer;
+	FILE* pFile = std::fopen(pStatePath, "rb");
+	if (pFile == nullptr)
+	{
+		printf("Failed to open %s\n", pStatePath);
+		return false;
+	};
+
+	size_t size = std::fread(buffer.data(), 1, buffer.size(), pFile);
+	std::fclose(pFile);
+
+	if (!interpreter.LoadState(buffer.data(), size))
+	{
+		printf("%s is not a valid save state\n", pStatePath);
+		return false;
+	};
+
+	return true;
+};
+
+bool SaveStateFile(const Interpreter& interpreter, const char* pStatePath)
+{
+	std::array<uint8_t, g_saveStateMaxSize> buffer;
+	size_t size = interpreter.SaveState(buffer.data(), buffer.size());
+
+	FILE* pFile = std::fopen(pStatePath, "wb");
+	if (pFile == nullptr || std::fwrite(buffer.data(), 1, size, pFile) != size)
+	{
+		printf("Failed to write %s\n", pStatePath);
+		if (pFile != nullptr)
+		{
+			std::fclose(pFile);
+		};
+		return false;
+	};
+
+	std::fclose(pFile);
+	return true;
+};
+
+int RunBatch(const char* pRomPath, const char* pStatePath, Backend backend, Platform platform, const QuirkProfile* pQuirks, uint64_t seed, uint64_t cycles, uint32_t cyclesPerFrame, uint32_t instances, uint32_t threads, uint32_t sliceCycles, bool isSkippingIdle)
+{
+	BatchEngine engine(threads);
+	for (uint32_t i = 0; i < instances; i++)
+	{
+		// Every instance forks from the same save state.
+		std::unique_ptr<Interpreter> pInterpreter = CreateInterpreter(pRomPath, backend, platform, pQuirks, seed, isSkippingIdle);
+		if (!pInterpreter || (pStatePath != nullptr && !LoadStateFile(*pInterpreter, pStatePath)))
+		{
+			return -1;
+		};
+		engine.AddInstance(std::move(pInterpreter));
+	};
+
+	BatchResult result = engine.Run(cycles, sliceCycles, cyclesPerFrame);
+
+	printf("Executed %llu instructions on %u instances and %u threads in %.3f s (%llu steals)\n",
+		static_cast<unsigned long long>(result.instructions),
+		instances,
+		engine.GetThreadCount(),
+		result.seconds,
+		static_cast<unsigned long long>(result.steals));
+	printf("%.0f instructions/sec\n", result.seconds > 0.0 ? result.instructions / result.seconds : 0.0);
+
+	return 0;
+};
+
+int RunLockstep(const char* pRomPath, uint64_t seed, uint64_t cycles, uint32_t cyclesPerFrame, uint32_t lanes, const uint64_t* pExpectedHash)
+{
+	LockstepEngine engine(lanes);
+	if (!engine.Initialize(pRomPath))
+	{
+		printf("Failed to initialize Chip8 Emulator!\n");
+		return -1;
+	};
+	engine.SetRandomSeed(seed);
+
+	auto start = std::chrono::steady_clock::now();
+
+	uint64_t remaining = cycles;
+	while (remaining > 0)
+	{
+		uint32_t slice = static_cast<uint32_t>(remaining < cyclesPerFrame ? remaining : cyclesPerFrame);
+		remaining -= engine.Execute(slice);
+		if (slice == cyclesPerFrame)
+		{
+			engine.TickTimers();
+		};
+	};
+
+	auto end = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(end - start).count();
+	uint64_t executed = engine.GetCycleCount() * lanes;
+
+	printf("Executed %llu instructions on %u lanes in %.3f s\n",
+		static_cast<unsigned long long>(executed),
+		lanes,
+		seconds);
+	printf("%.0f instructions/sec\n", seconds > 0.0 ? executed / seconds : 0.0);
+	printf("State hash %016llx (lane 0)\n", static_cast<unsigned long long>(engine.GetStateHash(0)));
+
+	return CheckStateHash(engine.GetStateHash(0), pExpectedHash) ? 0 : -1;
+};
+
+bool CheckStateHash(uint64_t hash, const uint64_t* pExpectedHash)
+{
+	if (pExpectedHash != nullptr && hash != *pExpectedHash)
+	{
+		printf("State hash differs from the expected %016llx\n", static_cast<unsigned long long>(*pExpectedHash));
+		return false;
+	};
+
+	return true;
+};
+
+int RunReplay(const char* pRomPath, const char* pMoviePath, Backend backend, Platform platform, const QuirkProfile* pQuirks, bool isSkippingIdle)
+{
+	Movie movie;
+	if (!movie.Load(pMoviePath))
+	{
+		printf("%s is not a valid movie\n", pMoviePath);
+		return -1;
+	};
+
+	std::unique_ptr<Interpreter> pInterpreter = CreateInterpreter(pRomPath, backend, platform, pQuirks, movie.GetSeed(), isSkippingIdle);
+	if (!pInterpreter)
+	{
+		return -1;
+	};
+
+	auto start = std::chrono::steady_clock::now();
+	bool isMatching = movie.Replay(*pInterpreter);
+	auto end = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(end - start).count();
+	uint64_t executed = pInterpreter->GetCycleCount();
+
+	printf("Replayed %llu instructions (%llu frames, %zu events) in %.3f s\n",
+		static_cast<unsigned long long>(executed),
+		static_cast<unsigned long long>(movie.GetFrameCount()),
+		movie.GetEventCount(),
+		seconds);
+	printf("%.0f instructions/sec\n", seconds > 0.0 ? executed / seconds : 0.0);
+	printf("State hash %016llx\n", static_cast<unsigned long long>(pInterpreter->GetStateHash()));
+	printf("ROM hash %016llx, quirks %s\n", static_cast<unsigned long long>(pInterpreter->GetRomHash()), GetQuirkProfileName(pInterpreter->GetQuirkProfile()));
+	if (isSkippingIdle)
+	{
+		printf("Skipped %llu instructions in wait loops\n", static_cast<unsigned long long>(pInterpreter->GetIdleCycleCount()));
+	};
+
+	if (!isMatching)
+	{
+		printf("Replay diverged, recorded state hash %016llx\n", static_cast<unsigned long long>(movie.GetEndStateHash()));
+		return -1;
+	};
+
+	printf("Replay matches the recording\n");
+	return 0;
+};
+
+void PrintUsage(const char* pProgramName)
+{
+	printf("Usage: %s <path-to-rom> [--cycles N | --frames N] [--cycles-per-frame N]\n"
+		"       [--backend interpreter|recompiler|aot] [--platform chip8|schip|xochip]\n"
+		"       [--quirks default|vip|schip|xochip] [--quirks-db FILE]\n"
+		"       [--instances N] [--threads N] [--slice N]\n"
+		"       [--lanes N] [--prepare] [--skip-idle] [--expect-hash HEX]\n"
+		"       [--load-state FILE] [--save-state FILE] [--rewind] [--rewind-frames N]\n"
+		"       [--seed N] [--record FILE | --replay FILE]\n"
+		"       [--profile FILE] [--audio null|FILE.wav]\n", pProgramName);
+};
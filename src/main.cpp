@@ -2,9 +2,25 @@
 		Entry point for Chip8 Emulator
  */
 
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
 #include <fstream>
 #include <memory>
+#include <thread>
+#include <vector>
+#include "Audio.hpp"
+#include "Blitter.hpp"
+#include "InputQueue.hpp"
 #include "Interpreter.hpp"
+#include "Movie.hpp"
+#include "Quirks.hpp"
+#include "RewindBuffer.hpp"
+#include "Scheduler.hpp"
+#include "TripleBuffer.hpp"
 #include <SDL.h>
 
 #undef main		// Undef main so we don't use SDL's main()
@@ -15,14 +31,72 @@
 SDL_Window* g_pWindow = nullptr;
 
 /**
- * SDL Surface pointer
+ * SDL Renderer pointer, software backed
  */
-SDL_Surface* g_pSurface = nullptr;
+SDL_Renderer* g_pRenderer = nullptr;
 
 /**
-    Bool value for when to exit the emulator.
+ * Streaming texture the guest frames are uploaded to, the size of the window
  */
-bool g_quit = false;
+SDL_Texture* g_pTexture = nullptr;
+
+/**
+    Bool value for when to exit the emulator, read by the emulation thread.
+ */
+std::atomic<bool> g_quit(false);
+
+/**
+    Set when the window has to be presented again without a new frame.
+ */
+bool g_redrawAll = true;
+
+/**
+    Guest frame handed to the window thread.
+ */
+struct GuestFrame
+{
+    /** Screen of the guest */
+    Framebuffer framebuffer;
+    /** Bit y is set for every row changed since the frame the window thread took last */
+    uint64_t dirtyRows;
+};
+
+/**
+    Guest frames on their way from the emulation thread to the window.
+ */
+TripleBuffer<GuestFrame> g_frames;
+
+/**
+    Dirty rows of the last published frame, emulation thread only.
+ */
+uint64_t g_publishedRows = 0;
+
+/**
+    Window sized copy of the texture, window thread only.
+    Only the rows a frame changed are redrawn in to it before it is uploaded.
+ */
+std::vector<uint32_t> g_pixels;
+
+/**
+    Width of the guest screen g_pixels was drawn from.
+ */
+uint16_t g_presentedWidth = 0;
+
+/**
+    Height of the guest screen g_pixels was drawn from.
+ */
+uint16_t g_presentedHeight = 0;
+
+/**
+    SDL event pushed by the emulation thread after publishing a frame.
+ */
+Uint32 g_frameEvent = 0;
+
+/**
+    SDL event pushed by the emulation thread to change the title, the code is
+    the speed-up in tenths or -1 to restore it.
+ */
+Uint32 g_titleEvent = 0;
 
 /**
 	uint16_t to store screen width and height.
@@ -35,11 +109,106 @@ constexpr uint16_t g_screenSize = 0x4020;
  */
 std::unique_ptr<Interpreter> g_pInterpreter = nullptr;
 
+/**
+    Scales the emulator screen in to the window surface.
+ */
+Blitter g_blitter;
+
+/**
+    Paces the guest against wall clock time.
+ */
+Scheduler g_scheduler;
+
+/**
+    Last frames of the guest, stepped back through while rewinding.
+ */
+RewindBuffer g_rewind;
+
+/**
+    Set while the rewind key is held.
+ */
+std::atomic<bool> g_isRewinding(false);
+
+/**
+    Turbo mode the window thread asked for, applied by the emulation thread.
+ */
+std::atomic<bool> g_isTurboRequested(false);
+
+/**
+    Speed of turbo mode, a multiple of real time or g_schedulerUnthrottled.
+ */
+uint32_t g_turboSpeed = g_schedulerUnthrottled;
+
+/**
+    Set while turbo mode is on, emulation thread only.
+ */
+bool g_isTurbo = false;
+
+/**
+    Guest ticks run since the speed-up in the title was last updated.
+ */
+uint64_t g_turboTicks = 0;
+
+/**
+    Time the speed-up in the title was last updated.
+ */
+Scheduler::Clock::time_point g_turboMeasureStart;
+
+/**
+    Inputs recorded for --record, null when not recording.
+ */
+std::unique_ptr<Movie> g_pMovie = nullptr;
+
+/**
+    Beeper synthesis, fed by the interpreter and pulled by the audio device. Null when muted.
+ */
+std::unique_ptr<AudioEngine> g_pAudio = nullptr;
+
+/**
+    SDL audio device, 0 when audio is not open.
+ */
+SDL_AudioDeviceID g_audioDevice = 0;
+
+/**
+    Title of the window, turbo mode appends the speed-up to it.
+ */
+constexpr const char* g_pWindowTitle = "Chip8";
+
+/**
+    Guest frames per presented frame in turbo mode unless --frame-skip is given.
+ */
+constexpr uint32_t g_defaultTurboFrameSkip = 10;
+
+/**
+    Window pixels per emulator pixel unless --scale is given.
+ */
+constexpr uint32_t g_defaultScale = 10;
+
 /**
     Emulator key map.
  */
 std::array<uint8_t, g_chipKeyboardSize> g_keyboardMap = {};
 
+/**
+    Keycodes below this have an entry in g_keyLookup, every mapped key is ASCII.
+ */
+constexpr uint32_t g_keyLookupSize = 128;
+
+/**
+    Marks keycodes that are not mapped to a Chip8 key.
+ */
+constexpr uint8_t g_keyUnmapped = 0xFF;
+
+/**
+    Chip8 key index per keycode, built from g_keyboardMap.
+ */
+std::array<uint8_t, g_keyLookupSize> g_keyLookup = {};
+
+/**
+    Key changes on their way from the event watch to the guest.
+ */
+InputQueue g_inputQueue;
+
 /**
     Initialize SDL for Chip8 emulator
 
@@ -52,10 +221,89 @@ std::array<uint8_t, g_chipKeyboardSize> g_keyboardMap = {};
 bool InitializeSDL(const std::string& windowName, uint32_t windowWidth, uint32_t windowHeight);
 
 /**
-    Handle input for the emulator
+    Opens the audio device and connects the beeper to the interpreter.
+
+    @param[in] bufferFrames Samples per device buffer, smaller means lower latency.
+    @return false if no audio device could be opened, the emulator then runs silent.
+ */
+bool InitializeAudio(uint32_t bufferFrames);
+
+/**
+    SDL audio callback, runs on SDL's audio thread.
+
+    @param[in] pUserData The AudioEngine.
+    @param[out] pStream Buffer to fill with float samples.
+    @param[in] length Size of the buffer in bytes.
+ */
+void AudioCallback(void* pUserData, Uint8* pStream, int length);
+
+/**
+    SDL event watch, queues Chip8 key changes the moment SDL receives them.\n
+    Also runs on the emulation thread for the events it pushes, which are never key changes.
+
+    @param[in] pUserData Unused.
+    @param[in] pEvent Event SDL is about to queue.
+    @return Ignored by SDL for event watches.
+ */
+int InputWatch(void* pUserData, SDL_Event* pEvent);
+
+/**
+    Waits for SDL events, handles them and presents the frames that arrived.
  */
 void HandleInput();
 
+/**
+    Runs the guest against the scheduler until the emulator quits, on the emulation thread.
+ */
+void RunEmulation();
+
+/**
+    Hands the guest screen to the window thread without waiting for it.
+ */
+void PublishFrame();
+
+/**
+    Queues one of the emulator's own SDL events, safe from any thread.
+
+    @param[in] type g_frameEvent or g_titleEvent.
+    @param[in] code Value for the event.
+ */
+void PushEvent(Uint32 type, Sint32 code);
+
+/**
+    Switches turbo mode on or off, on the emulation thread.\n
+    Audio is paused while the guest runs faster than real time.
+
+    @param[in] isTurbo true to run at g_turboSpeed, false for real time.
+ */
+void SetTurbo(bool isTurbo);
+
+/**
+    Shows the achieved speed-up in the window title about once a second while in turbo mode.
+
+    @param[in] ticks Guest ticks run since the last call.
+ */
+void UpdateTurboTitle(uint32_t ticks);
+
+/**
+    Prints how to use the emulator.
+
+    @param[in] pProgramName Name of the executable.
+ */
+void PrintUsage(const char* pProgramName);
+
+/**
+    Retrieve the refresh rate of the display the window is on.
+
+    @return Refresh rate in Hz, 0 if unknown.
+ */
+uint32_t GetDisplayRefreshRate();
+
+/**
+    Draws the last published guest frame to the window, on the window thread.
+ */
+void Present();
+
 /**
     Shutdown SDL when exiting the emulator
  */
@@ -66,28 +314,158 @@ void ShutdownSDL();
  */
 int main(int argc, char** argv)
 {
+    const char* pRomPath = nullptr;
+    const char* pRecordPath = nullptr;
+    uint32_t scale = g_defaultScale;
+    uint32_t audioBufferFrames = g_audioDefaultBufferFrames;
+    uint32_t frameSkip = g_defaultTurboFrameSkip;
+    bool isMuted = false;
+    Platform platform = Platform::Chip8;
+    QuirkProfile quirks = QuirkProfile::Default;
+    bool hasQuirks = false;
+    uint64_t seed = static_cast<uint64_t>(std::time(nullptr));
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--scale") == 0 && i + 1 < argc)
+        {
+            scale = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--ips") == 0 && i + 1 < argc)
+        {
+            g_scheduler.SetInstructionsPerSecond(static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10)));
+        }
+        else if (std::strcmp(argv[i], "--turbo") == 0 && i + 1 < argc)
+        {
+            g_turboSpeed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--frame-skip") == 0 && i + 1 < argc)
+        {
+            frameSkip = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--palette") == 0 && i + 1 < argc)
+        {
+            const Palette* pPalette = FindPalette(argv[++i]);
+            if (pPalette == nullptr)
+            {
+                PrintUsage(argv[0]);
+                return -1;
+            };
+            g_blitter.SetPalette(*pPalette);
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+        {
+            pRecordPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--audio-buffer") == 0 && i + 1 < argc)
+        {
+            audioBufferFrames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--mute") == 0)
+        {
+            isMuted = true;
+        }
+        else if (std::strcmp(argv[i], "--quirks") == 0 && i + 1 < argc)
+        {
+            if (!FindQuirkProfile(argv[++i], quirks))
+            {
+                PrintUsage(argv[0]);
+                return -1;
+            };
+            hasQuirks = true;
+        }
+        else if (std::strcmp(argv[i], "--quirks-db") == 0 && i + 1 < argc)
+        {
+            if (!QuirkDatabase::GetInstance().Load(argv[++i]))
+            {
+                printf("Failed to read quirk database %s\n", argv[i]);
+                return -1;
+            };
+        }
+        else if (std::strcmp(argv[i], "--platform") == 0 && i + 1 < argc)
+        {
+            if (!FindPlatform(argv[++i], platform))
+            {
+                PrintUsage(argv[0]);
+                return -1;
+            };
+        }
+        else if (argv[i][0] != '-' && pRomPath == nullptr)
+        {
+            pRomPath = argv[i];
+        }
+        else
+        {
+            PrintUsage(argv[0]);
+            return -1;
+        };
+    };
+
+    if (pRomPath == nullptr || scale == 0 || frameSkip == 0 || audioBufferFrames == 0 || audioBufferFrames > 0xFFFF)
+    {
+        PrintUsage(argv[0]);
+        return -1;
+    };
+
     g_pInterpreter = std::make_unique<Interpreter>();
-    
-    if (InitializeSDL("Chip8", 640, 320) &&
-        argc == 2 &&
+    // Later platforms switch between 64x32 and 128x64 at run time, the window
+    // fits the high resolution and the blitter scales either one to fill it.
+    uint16_t screenSize = platform == Platform::Chip8 ? g_screenSize : static_cast<uint16_t>(ScreenSize::HiRes);
+    g_blitter.SetScale(platform == Platform::Chip8 ? scale : 0);
+
+    uint32_t windowWidth = (screenSize >> 8) * scale;
+    uint32_t windowHeight = (screenSize & 0x00FF) * scale;
+
+    if (InitializeSDL(g_pWindowTitle, windowWidth, windowHeight) &&
         g_pInterpreter != nullptr &&
-        g_pInterpreter->Initialize(argv[1], ScreenSize::Chip8))
+        g_pInterpreter->Initialize(pRomPath, ScreenSize::Chip8, platform))
     {
-        uint32_t* pScreen = static_cast<uint32_t*>(g_pSurface->pixels);
+        g_pInterpreter->SetRandomSeed(seed);
+        // A guest waiting on the delay timer or a key ends its tick early, leaving
+        // the rest of it to WaitForNextTick() sleeping.
+        g_pInterpreter->SetIdleSkipping(true);
+        if (hasQuirks)
+        {
+            g_pInterpreter->SetQuirkProfile(quirks);
+        };
+        if (pRecordPath != nullptr)
+        {
+            g_pMovie = std::make_unique<Movie>();
+            g_pMovie->Start(seed);
+        };
+
+        if (!isMuted && !InitializeAudio(audioBufferFrames))
+        {
+            printf("Failed to open audio, running without sound: %s\n", SDL_GetError());
+        };
+
+        g_scheduler.SetRefreshRate(GetDisplayRefreshRate());
+        g_scheduler.SetFrameSkip(frameSkip);
+        g_scheduler.Start();
+
+        // SDL video and events have to stay on the thread that created the
+        // window, so this thread presents and the guest runs on its own.
+        std::thread emulation(RunEmulation);
         while (!g_quit)
         {
-            g_pInterpreter->Run();
             HandleInput();
+        };
+        emulation.join();
 
-            SDL_LockSurface(g_pSurface);
-            std::memset(pScreen, 0x00000000, (g_pSurface->w * g_pSurface->h * sizeof(uint32_t)));
-            
-            g_pInterpreter->Draw(pScreen, 640, 320);
-                
-            SDL_UnlockSurface(g_pSurface);
-
-            SDL_UpdateWindowSurface(g_pWindow);
+        // Before ShutdownSDL(), which destroys the interpreter.
+        if (g_pMovie)
+        {
+            g_pMovie->Finish(*g_pInterpreter);
+            if (!g_pMovie->Save(pRecordPath))
+            {
+                printf("Failed to write %s\n", pRecordPath);
+            };
         };
+
         ShutdownSDL();
             
         return 0;
@@ -119,7 +497,28 @@ bool InitializeSDL(const std::string& windowName, uint32_t windowWidth, uint32_t
         return false;
     }
     
-    g_pSurface = SDL_GetWindowSurface(g_pWindow);
+    // Software rendering keeps the upload a plain memory copy, the blitter already scales.
+    g_pRenderer = SDL_CreateRenderer(g_pWindow, -1, SDL_RENDERER_SOFTWARE);
+    if (!g_pRenderer)
+    {
+        printf("Failed to initialize SDL_Renderer: %s\n", SDL_GetError());
+        return false;
+    };
+
+    g_pTexture = SDL_CreateTexture(g_pRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, windowWidth, windowHeight);
+    if (!g_pTexture)
+    {
+        printf("Failed to initialize SDL_Texture: %s\n", SDL_GetError());
+        return false;
+    };
+
+    g_frameEvent = SDL_RegisterEvents(2);
+    if (g_frameEvent == static_cast<Uint32>(-1))
+    {
+        printf("Failed to register SDL events: %s\n", SDL_GetError());
+        return false;
+    };
+    g_titleEvent = g_frameEvent + 1;
     
     g_keyboardMap =
     {
@@ -128,24 +527,94 @@ bool InitializeSDL(const std::string& windowName, uint32_t windowWidth, uint32_t
         SDLK_s, SDLK_d, SDLK_z, SDLK_c,     // 7, 8, 9, E
         SDLK_4, SDLK_r, SDLK_f, SDLK_v      // A, 0, B, F
     };
+
+    g_keyLookup.fill(g_keyUnmapped);
+    for (uint8_t keyIndex = 0; keyIndex < g_keyboardMap.size(); keyIndex++)
+    {
+        g_keyLookup[g_keyboardMap[keyIndex]] = keyIndex;
+    };
+
+    SDL_AddEventWatch(InputWatch, nullptr);
     
     return true;
 };
 
+/**
+    Opens a mono float device and starts pulling samples from the beeper
+ */
+bool InitializeAudio(uint32_t bufferFrames)
+{
+    g_pAudio = std::make_unique<AudioEngine>(g_audioDefaultSampleRate, bufferFrames);
+    g_pAudio->SetInstructionsPerSecond(g_scheduler.GetInstructionsPerSecond());
+
+    SDL_AudioSpec desired = {};
+    desired.freq = static_cast<int>(g_audioDefaultSampleRate);
+    desired.format = AUDIO_F32SYS;
+    desired.channels = 1;
+    desired.samples = static_cast<Uint16>(bufferFrames);
+    desired.callback = AudioCallback;
+    desired.userdata = g_pAudio.get();
+
+    // SDL converts to whatever the hardware wants, so the engine always renders the requested format.
+    g_audioDevice = SDL_OpenAudioDevice(nullptr, 0, &desired, nullptr, 0);
+    if (g_audioDevice == 0)
+    {
+        g_pAudio.reset();
+        return false;
+    };
+
+    g_pInterpreter->SetSoundListener(g_pAudio.get());
+    SDL_PauseAudioDevice(g_audioDevice, 0);
+    return true;
+};
+
+/**
+    Renders the beeper in to SDL's buffer
+ */
+void AudioCallback(void* pUserData, Uint8* pStream, int length)
+{
+    AudioEngine* pAudio = static_cast<AudioEngine*>(pUserData);
+    pAudio->Render(reinterpret_cast<float*>(pStream), static_cast<uint32_t>(length / sizeof(float)));
+};
+
 /**
     Handles input via SDL
  */
 void HandleInput()
 {
     SDL_Event e;
-    
-    while (SDL_PollEvent(&e) != 0)
+    if (SDL_WaitEvent(&e) == 0)
     {
+        return;
+    };
+
+    do
+    {
+        if (e.type == g_titleEvent)
+        {
+            char title[64];
+            if (e.user.code < 0)
+            {
+                std::snprintf(title, sizeof(title), "%s", g_pWindowTitle);
+            }
+            else
+            {
+                std::snprintf(title, sizeof(title), "%s - turbo %.1fx", g_pWindowTitle, e.user.code / 10.0);
+            };
+            SDL_SetWindowTitle(g_pWindow, title);
+            continue;
+        };
+
+        // New frames are picked up below, however many events announced them.
         switch (e.type)
         {
             case SDL_QUIT:
                 g_quit = true;
                 break;
+
+            case SDL_WINDOWEVENT:
+                g_redrawAll = true;
+                break;
                 
             case SDL_KEYDOWN:
                 
@@ -154,28 +623,235 @@ void HandleInput()
                     g_quit = true;
                     break;
                 };
-                
-                for (uint8_t keyIndex = 0; keyIndex < g_keyboardMap.size(); keyIndex++)
+
+                if (e.key.keysym.sym == SDLK_TAB && e.key.repeat == 0)
                 {
-                    if (e.key.keysym.sym == g_keyboardMap[keyIndex])
-                    {
-                        g_pInterpreter->OnKeyPressed(keyIndex);
-                    };
+                    g_isTurboRequested = !g_isTurboRequested;
+                    break;
+                };
+
+                // A movie can not be rewound, the recording would no longer replay.
+                if (e.key.keysym.sym == SDLK_BACKSPACE)
+                {
+                    g_isRewinding = !g_pMovie;
                 };
-                
                 break;
                 
             case SDL_KEYUP:
-                for (uint8_t keyIndex = 0; keyIndex < g_keyboardMap.size(); keyIndex++)
+                if (e.key.keysym.sym == SDLK_BACKSPACE)
                 {
-                    if (e.key.keysym.sym == g_keyboardMap[keyIndex])
-                    {
-                        g_pInterpreter->OnKeyReleased(keyIndex);
-                    };
+                    g_isRewinding = false;
                 };
                 break;
         };
+    }
+    while (SDL_PollEvent(&e) != 0);
+
+    if (g_frames.Acquire() || g_redrawAll)
+    {
+        Present();
+    };
+};
+
+/**
+    Polls the scheduler, runs the ticks that became due and publishes the frames
+ */
+void RunEmulation()
+{
+    PublishFrame();
+
+    while (!g_quit)
+    {
+        if (g_isTurboRequested != g_isTurbo)
+        {
+            SetTurbo(g_isTurboRequested);
+        };
+
+        // Run the guest for every 60 Hz tick that became due.
+        uint32_t ticks = g_scheduler.PollTicks();
+        g_inputQueue.BeginTicks(ticks);
+        for (uint32_t i = 0; i < ticks; i++)
+        {
+            // Rewinding steps back one recorded frame per tick instead.
+            if (g_isRewinding)
+            {
+                g_inputQueue.Flush(*g_pInterpreter);
+                g_rewind.Rewind(*g_pInterpreter);
+                continue;
+            };
+
+            g_inputQueue.ExecuteTick(*g_pInterpreter, g_scheduler.GetTickInstructions(), g_pMovie.get());
+            g_pInterpreter->TickTimers();
+            if (g_pMovie)
+            {
+                g_pMovie->Record(g_pInterpreter->GetCycleCount(), MovieEvent::Frame);
+            }
+            else
+            {
+                g_rewind.Push(*g_pInterpreter);
+            };
+        };
+        UpdateTurboTitle(ticks);
+
+        // Frames where the guest did not touch the screen are not published at all.
+        if (ticks > 0 && g_pInterpreter->IsFrameDirty() && g_scheduler.ShouldPresent())
+        {
+            PublishFrame();
+        };
+
+        g_scheduler.WaitForNextTick();
+    };
+};
+
+/**
+    Copies the screen in to the triple buffer and wakes the window thread
+ */
+void PublishFrame()
+{
+    // The window thread never drew the rows of a frame it did not take, they go with this one.
+    uint64_t rows = g_pInterpreter->GetDirtyRows();
+    if (g_frames.IsPending())
+    {
+        rows |= g_publishedRows;
+    };
+
+    GuestFrame& frame = g_frames.GetBackBuffer();
+    frame.framebuffer = g_pInterpreter->GetFramebuffer();
+    frame.dirtyRows = rows;
+    g_frames.Publish();
+    g_publishedRows = rows;
+    g_pInterpreter->ClearDirtyRows();
+    PushEvent(g_frameEvent, 0);
+};
+
+/**
+    Pushes a user event, SDL_PushEvent() is thread safe
+ */
+void PushEvent(Uint32 type, Sint32 code)
+{
+    SDL_Event event = {};
+    event.type = type;
+    event.user.code = code;
+    SDL_PushEvent(&event);
+};
+
+/**
+    Changes the scheduler speed and pauses or resumes audio
+ */
+void SetTurbo(bool isTurbo)
+{
+    g_isTurbo = isTurbo;
+    g_scheduler.SetSpeed(isTurbo ? g_turboSpeed : 1);
+    g_turboTicks = 0;
+    g_turboMeasureStart = Scheduler::Clock::now();
+
+    if (g_audioDevice != 0)
+    {
+        // The beeper may have changed while detached, tell the engine where it stands now.
+        g_pInterpreter->SetSoundListener(isTurbo ? nullptr : g_pAudio.get());
+        if (!isTurbo)
+        {
+            g_pAudio->OnSoundChanged(g_pInterpreter->GetCycleCount(), g_pInterpreter->IsSoundActive());
+        };
+        SDL_PauseAudioDevice(g_audioDevice, isTurbo ? 1 : 0);
     };
+
+    if (!isTurbo)
+    {
+        PushEvent(g_titleEvent, -1);
+    };
+};
+
+/**
+    Measures guest seconds per wall clock second and sends them to the window thread
+ */
+void UpdateTurboTitle(uint32_t ticks)
+{
+    if (!g_isTurbo)
+    {
+        return;
+    };
+
+    g_turboTicks += ticks;
+    double seconds = std::chrono::duration<double>(Scheduler::Clock::now() - g_turboMeasureStart).count();
+    if (seconds < 1.0)
+    {
+        return;
+    };
+
+    PushEvent(g_titleEvent, static_cast<Sint32>(g_turboTicks * 10 / (seconds * g_timerFrequency)));
+
+    g_turboTicks = 0;
+    g_turboMeasureStart = Scheduler::Clock::now();
+};
+
+/**
+    Looks the key up and queues the change with the time it arrived
+ */
+int InputWatch(void* pUserData, SDL_Event* pEvent)
+{
+    (void)pUserData;
+
+    if ((pEvent->type != SDL_KEYDOWN && pEvent->type != SDL_KEYUP) || pEvent->key.repeat != 0)
+    {
+        return 1;
+    };
+
+    SDL_Keycode keycode = pEvent->key.keysym.sym;
+    if (keycode < 0 || static_cast<uint32_t>(keycode) >= g_keyLookupSize || g_keyLookup[keycode] == g_keyUnmapped)
+    {
+        return 1;
+    };
+
+    g_inputQueue.Push(g_keyLookup[keycode], pEvent->type == SDL_KEYDOWN);
+    return 1;
+};
+
+/**
+    Queries SDL for the refresh rate of the window's display
+ */
+uint32_t GetDisplayRefreshRate()
+{
+    SDL_DisplayMode mode;
+    if (SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(g_pWindow), &mode) != 0 || mode.refresh_rate <= 0)
+    {
+        return 0;
+    };
+
+    return static_cast<uint32_t>(mode.refresh_rate);
+};
+
+/**
+    Blits the changed rows of the emulator screen to the window surface and presents them
+ */
+void Present()
+{
+    int width = 0;
+    int height = 0;
+    SDL_QueryTexture(g_pTexture, nullptr, nullptr, &width, &height);
+
+    // A new window or guest screen size leaves nothing to keep.
+    const GuestFrame& frame = g_frames.GetFrontBuffer();
+    size_t pixelCount = static_cast<size_t>(width) * height;
+    if (g_redrawAll || g_pixels.size() != pixelCount ||
+        frame.framebuffer.GetWidth() != g_presentedWidth || frame.framebuffer.GetHeight() != g_presentedHeight)
+    {
+        g_pixels.resize(pixelCount);
+        g_blitter.Blit(frame.framebuffer, g_pixels.data(), width, width, height);
+        g_presentedWidth = frame.framebuffer.GetWidth();
+        g_presentedHeight = frame.framebuffer.GetHeight();
+    }
+    else
+    {
+        g_blitter.BlitRows(frame.framebuffer, frame.dirtyRows, g_pixels.data(), width, width, height);
+    };
+
+    // Streaming texture pixels are undefined after a lock, so the whole copy is uploaded.
+    SDL_UpdateTexture(g_pTexture, nullptr, g_pixels.data(), width * sizeof(uint32_t));
+
+    SDL_RenderCopy(g_pRenderer, g_pTexture, nullptr, nullptr);
+    SDL_RenderPresent(g_pRenderer);
+    g_redrawAll = false;
 };
 
 /**
@@ -183,10 +859,31 @@ void HandleInput()
  */
 void ShutdownSDL()
 {
-    if (g_pSurface)
+    SDL_DelEventWatch(InputWatch, nullptr);
+
+    // Stop the audio thread before the engine it renders from goes away.
+    if (g_audioDevice != 0)
+    {
+        SDL_CloseAudioDevice(g_audioDevice);
+        g_audioDevice = 0;
+    };
+
+    if (g_pInterpreter)
+    {
+        g_pInterpreter->SetSoundListener(nullptr);
+    };
+    g_pAudio.reset();
+
+    if (g_pTexture)
+    {
+        SDL_DestroyTexture(g_pTexture);
+        g_pTexture = nullptr;
+    };
+
+    if (g_pRenderer)
     {
-        SDL_FreeSurface(g_pSurface);
-        g_pSurface = nullptr;
+        SDL_DestroyRenderer(g_pRenderer);
+        g_pRenderer = nullptr;
     };
     
     if (g_pWindow)
@@ -203,3 +900,11 @@ void ShutdownSDL()
     
     SDL_Quit();
 };
+
+void PrintUsage(const char* pProgramName)
+{
+    printf("Usage: %s <path-to-rom> [--ips N] [--turbo N] [--frame-skip N] [--scale N]\n"
+           "       [--palette mono|amber|green|lcd]\n"
+           "       [--platform chip8|schip|xochip] [--quirks default|vip|schip|xochip] [--quirks-db FILE]\n"
+           "       [--seed N] [--record FILE] [--audio-buffer N] [--mute]\n", pProgramName);
+};